@@ -0,0 +1,107 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<uint64_t> g_allocations{ 0 };
+    std::atomic<uint64_t> g_frees{ 0 };
+}
+
+namespace AllocationCounter {
+    bool IsEnabled() {
+#ifdef POVERLAY_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    uint64_t GetAllocationCount() {
+        return g_allocations.load(std::memory_order_relaxed);
+    }
+
+    int64_t GetLiveCount() {
+        return static_cast<int64_t>(g_allocations.load(std::memory_order_relaxed) -
+            g_frees.load(std::memory_order_relaxed));
+    }
+}
+
+#ifdef POVERLAY_COUNT_ALLOCATIONS
+
+namespace {
+    void* CountedAllocate(size_t size) {
+        void* block = malloc(size ? size : 1);
+        if (block) {
+            g_allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+        return block;
+    }
+
+    void* CountedAllocateAligned(size_t size, std::align_val_t alignment) {
+        const size_t align = static_cast<size_t>(alignment);
+        size = ((size ? size : 1) + align - 1) / align * align;
+#ifdef _MSC_VER
+        void* block = _aligned_malloc(size, align);
+#else
+        void* block = aligned_alloc(align, size);
+#endif
+        if (block) {
+            g_allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+        return block;
+    }
+
+    void CountedFree(void* block) {
+        if (!block) return;
+        g_frees.fetch_add(1, std::memory_order_relaxed);
+        free(block);
+    }
+
+    void CountedFreeAligned(void* block) {
+        if (!block) return;
+        g_frees.fetch_add(1, std::memory_order_relaxed);
+#ifdef _MSC_VER
+        _aligned_free(block);
+#else
+        free(block);
+#endif
+    }
+}
+
+void* operator new(size_t size) {
+    if (void* block = CountedAllocate(size)) return block;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if (void* block = CountedAllocate(size)) return block;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size); }
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (void* block = CountedAllocateAligned(size, alignment)) return block;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    if (void* block = CountedAllocateAligned(size, alignment)) return block;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept { CountedFree(block); }
+void operator delete[](void* block) noexcept { CountedFree(block); }
+void operator delete(void* block, size_t) noexcept { CountedFree(block); }
+void operator delete[](void* block, size_t) noexcept { CountedFree(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { CountedFree(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { CountedFree(block); }
+void operator delete(void* block, std::align_val_t) noexcept { CountedFreeAligned(block); }
+void operator delete[](void* block, std::align_val_t) noexcept { CountedFreeAligned(block); }
+void operator delete(void* block, size_t, std::align_val_t) noexcept { CountedFreeAligned(block); }
+void operator delete[](void* block, size_t, std::align_val_t) noexcept { CountedFreeAligned(block); }
+
+#endif
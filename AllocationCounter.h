@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+// Process-wide heap allocation counts. Counting replaces the global
+// operator new/delete and is only compiled in when
+// POVERLAY_COUNT_ALLOCATIONS is defined; otherwise IsEnabled() is false
+// and every count stays 0.
+namespace AllocationCounter {
+    bool IsEnabled();
+
+    // Allocations since process start
+    uint64_t GetAllocationCount();
+
+    // Allocations not yet freed
+    int64_t GetLiveCount();
+}
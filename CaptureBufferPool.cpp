@@ -0,0 +1,103 @@
+#include "CaptureBufferPool.h"
+
+#include <algorithm>
+
+namespace {
+    int RoundUp(int value, int granule) {
+        return ((value + granule - 1) / granule) * granule;
+    }
+}
+
+CaptureBufferPool::CaptureBufferPool(CaptureDevice& device, size_t maxBuffers)
+    : m_device(device)
+    , m_maxBuffers(maxBuffers > 0 ? maxBuffers : 1) {
+}
+
+CaptureBufferPool::~CaptureBufferPool() {
+    Clear();
+}
+
+CaptureBufferPool::Buffer* CaptureBufferPool::Acquire(int width, int height) {
+    if (width <= 0 || height <= 0) return nullptr;
+
+    // Best fit: the smallest free buffer that is large enough
+    Buffer* best = nullptr;
+    for (auto& buffer : m_buffers) {
+        if (buffer->inUse) continue;
+        if (buffer->capacityWidth < width || buffer->capacityHeight < height) continue;
+
+        if (!best || buffer->capacityWidth * buffer->capacityHeight <
+            best->capacityWidth * best->capacityHeight) {
+            best = buffer.get();
+        }
+    }
+
+    if (best) {
+        best->inUse = true;
+        return best;
+    }
+
+    // Nothing fits; grow the pool or replace a free buffer that is too small
+    Buffer* target = nullptr;
+    if (m_buffers.size() < m_maxBuffers) {
+        m_buffers.push_back(std::make_unique<Buffer>());
+        target = m_buffers.back().get();
+    }
+    else {
+        for (auto& buffer : m_buffers) {
+            if (!buffer->inUse) {
+                target = buffer.get();
+                break;
+            }
+        }
+        if (!target) return nullptr; // Every buffer is in use
+
+        // Never shrink, so alternating region sizes settle on buffers that
+        // hold them all instead of replacing bitmaps for good
+        width = (std::max)(width, target->capacityWidth);
+        height = (std::max)(height, target->capacityHeight);
+        m_device.DestroyBitmap(*target);
+    }
+
+    if (!m_device.CreateBitmap(*target, RoundUp(width, WIDTH_GRANULE), RoundUp(height, HEIGHT_GRANULE))) {
+        return nullptr;
+    }
+
+    target->inUse = true;
+    return target;
+}
+
+void CaptureBufferPool::Release(Buffer* buffer) {
+    if (buffer) {
+        buffer->inUse = false;
+    }
+}
+
+void CaptureBufferPool::Trim() {
+    for (auto it = m_buffers.begin(); it != m_buffers.end();) {
+        if (!(*it)->inUse) {
+            m_device.DestroyBitmap(**it);
+            it = m_buffers.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void CaptureBufferPool::Clear() {
+    for (auto& buffer : m_buffers) {
+        m_device.DestroyBitmap(*buffer);
+    }
+    m_buffers.clear();
+}
+
+FrameView CaptureBufferPool::MakeView(const Buffer& buffer, int width, int height) {
+    FrameView view;
+    view.data = buffer.bits;
+    view.width = (std::min)(width, buffer.capacityWidth);
+    view.height = (std::min)(height, buffer.capacityHeight);
+    view.stride = buffer.GetStride();
+    view.format = PixelFormat::BGRX32;
+    return view;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "CaptureDevice.h"
+#include "FrameView.h"
+
+// Pool of capture bitmaps reused across capture region changes. Buffers are
+// sized by capacity, so re-selecting a region of similar size reuses an
+// existing bitmap instead of allocating a new one, and the number of live
+// bitmaps never exceeds the pool limit. Bitmaps come from the device.
+class CaptureBufferPool {
+public:
+    using Buffer = CaptureBuffer;
+
+    explicit CaptureBufferPool(CaptureDevice& device, size_t maxBuffers = 2);
+    ~CaptureBufferPool();
+
+    CaptureBufferPool(const CaptureBufferPool&) = delete;
+    CaptureBufferPool& operator=(const CaptureBufferPool&) = delete;
+
+    // Get a buffer that can hold width x height pixels, or nullptr if the
+    // pool is exhausted or the bitmap could not be created
+    Buffer* Acquire(int width, int height);
+
+    // Return a buffer to the pool; its bitmap is kept for reuse
+    void Release(Buffer* buffer);
+
+    // Free every bitmap that is not in use
+    void Trim();
+
+    // Free every bitmap
+    void Clear();
+
+    size_t GetBufferCount() const { return m_buffers.size(); }
+
+    // View of the top-left width x height pixels of a buffer
+    static FrameView MakeView(const Buffer& buffer, int width, int height);
+
+private:
+    // Capacity is rounded up so small adjustments to the region reuse a buffer
+    static constexpr int WIDTH_GRANULE = 64;
+    static constexpr int HEIGHT_GRANULE = 8;
+
+    CaptureDevice& m_device;
+    size_t m_maxBuffers;
+    std::vector<std::unique_ptr<Buffer>> m_buffers;
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "FrameView.h"
+
+// Screen rectangle of a capture: RECT on Windows, the same shape elsewhere
+#ifdef _WIN32
+using CaptureRect = RECT;
+#else
+struct CaptureRect {
+    int left;
+    int top;
+    int right;
+    int bottom;
+};
+#endif
+
+// A top-down 32-bit bitmap the device blits into. bitmap is the device's
+// handle for it (an HBITMAP for GDI); bits are the pixels.
+struct CaptureBuffer {
+    void* bitmap = nullptr;
+    uint8_t* bits = nullptr;
+    int capacityWidth = 0;
+    int capacityHeight = 0;
+    bool inUse = false;
+
+    int GetStride() const { return capacityWidth * FrameView::BYTES_PER_PIXEL; }
+};
+
+// Where CaptureSystem gets its pixels from: GDI on the screen in the
+// overlay, a synthetic gauge in the tests and the soak harness.
+// Open and Close bracket the device's lifetime in a CaptureSystem; bitmaps
+// are created and blitted from the capture task only.
+class CaptureDevice {
+public:
+    virtual ~CaptureDevice() = default;
+
+    virtual bool Open() = 0;
+    virtual void Close() = 0;
+
+    // Make buffer a width x height bitmap; on failure buffer is left empty
+    virtual bool CreateBitmap(CaptureBuffer& buffer, int width, int height) = 0;
+    virtual void DestroyBitmap(CaptureBuffer& buffer) = 0;
+
+    // Copy a screen region into the top-left corner of buffer
+    virtual bool Blit(const CaptureBuffer& buffer, const CaptureRect& region) = 0;
+};
@@ -0,0 +1,284 @@
+#include "CaptureScheduler.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+namespace {
+    std::chrono::nanoseconds GetThreadCpuTime(std::thread& thread) {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        if (!GetThreadTimes(thread.native_handle(), &creation, &exit, &kernel, &user)) {
+            return std::chrono::nanoseconds(0);
+        }
+        // 100ns units
+        const uint64_t ticks = ((static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) +
+            ((static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+        return std::chrono::nanoseconds(ticks * 100);
+#else
+        clockid_t clock;
+        timespec time;
+        if (pthread_getcpuclockid(thread.native_handle(), &clock) != 0 || clock_gettime(clock, &time) != 0) {
+            return std::chrono::nanoseconds(0);
+        }
+        return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+#endif
+    }
+}
+
+CaptureScheduler::CaptureScheduler(size_t workerCount)
+    : m_pendingJobs(0)
+    , m_nextId(1)
+    , m_nextQueue(0)
+    , m_stopping(false) {
+    if (workerCount == 0) {
+        size_t cores = std::thread::hardware_concurrency();
+        workerCount = cores == 0 ? 1 : (cores < MAX_DEFAULT_WORKERS ? cores : MAX_DEFAULT_WORKERS);
+    }
+
+    for (size_t i = 0; i < workerCount; i++) {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < workerCount; i++) {
+        m_workers.emplace_back(&CaptureScheduler::WorkerLoop, this, i);
+    }
+    m_timer = std::thread(&CaptureScheduler::TimerLoop, this);
+}
+
+CaptureScheduler::~CaptureScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_timerWake.notify_all();
+    m_workAvailable.notify_all();
+
+    m_timer.join();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+std::chrono::nanoseconds CaptureScheduler::GetCpuTime() {
+    std::chrono::nanoseconds total = GetThreadCpuTime(m_timer);
+    for (auto& worker : m_workers) {
+        total += GetThreadCpuTime(worker);
+    }
+    return total;
+}
+
+CaptureScheduler::TaskId CaptureScheduler::Add(Task* task, Clock::duration period) {
+    auto entry = std::make_shared<Entry>();
+    entry->task = task;
+    entry->period = period;
+    entry->due = Clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entry->id = m_nextId++;
+        m_entries[entry->id] = entry;
+
+        // Any queue may end up holding every task at once
+        for (auto& queue : m_queues) {
+            std::lock_guard<std::mutex> queueLock(queue->mutex);
+            queue->Reserve(m_entries.size());
+        }
+    }
+    m_timerWake.notify_one();
+    return entry->id;
+}
+
+void CaptureScheduler::Remove(TaskId id) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(id);
+    if (it == m_entries.end()) return;
+
+    std::shared_ptr<Entry> entry = it->second;
+    m_entries.erase(it);
+    entry->removed = true;
+
+    // A queued job is dropped by whichever worker pops it
+    m_entryIdle.wait(lock, [&entry] { return !entry->running && !entry->queued; });
+}
+
+void CaptureScheduler::Wake(TaskId id) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(id);
+        if (it == m_entries.end()) return;
+
+        Entry& entry = *it->second;
+        if (entry.running) {
+            entry.woken = true;
+        }
+        else {
+            entry.due = Clock::now();
+        }
+    }
+    m_timerWake.notify_one();
+}
+
+void CaptureScheduler::SetPeriod(TaskId id, Clock::duration period) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(id);
+        if (it == m_entries.end()) return;
+
+        // Pull the next run in if the new period is shorter
+        Entry& entry = *it->second;
+        entry.period = period;
+        auto latest = Clock::now() + period;
+        if (entry.due > latest) {
+            entry.due = latest;
+        }
+    }
+    m_timerWake.notify_one();
+}
+
+size_t CaptureScheduler::GetTaskCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void CaptureScheduler::TimerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stopping) {
+        auto now = Clock::now();
+        auto nextDue = (Clock::time_point::max)();
+
+        for (auto& [id, entry] : m_entries) {
+            if (entry->queued || entry->running) continue;
+
+            if (entry->due <= now) {
+                entry->queued = true;
+                WorkerQueue& queue = *m_queues[m_nextQueue++ % m_queues.size()];
+                {
+                    // Counted under the queue lock, so no worker can pop the
+                    // job, and count it off, before it was counted
+                    std::lock_guard<std::mutex> queueLock(queue.mutex);
+                    queue.PushBack(entry);
+                    m_pendingJobs++;
+                }
+                m_workAvailable.notify_one();
+            }
+            else if (entry->due < nextDue) {
+                nextDue = entry->due;
+            }
+        }
+
+        // Finished jobs and new tasks notify us, so sleeping until the
+        // earliest idle deadline is enough
+        if (nextDue == (Clock::time_point::max)()) {
+            m_timerWake.wait(lock);
+        }
+        else {
+            m_timerWake.wait_until(lock, nextDue);
+        }
+    }
+}
+
+void CaptureScheduler::WorkerLoop(size_t index) {
+    while (true) {
+        std::shared_ptr<Entry> entry = PopJob(index);
+        if (entry) {
+            RunJob(entry);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_workAvailable.wait(lock, [this] { return m_stopping || m_pendingJobs > 0; });
+        if (m_stopping) return;
+    }
+}
+
+std::shared_ptr<CaptureScheduler::Entry> CaptureScheduler::PopJob(size_t index) {
+    // Newest job from our own queue first
+    {
+        WorkerQueue& own = *m_queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.count > 0) {
+            auto entry = own.PopBack();
+            m_pendingJobs--;
+            return entry;
+        }
+    }
+
+    // Otherwise steal the oldest job from another worker
+    for (size_t offset = 1; offset < m_queues.size(); offset++) {
+        WorkerQueue& victim = *m_queues[(index + offset) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.count > 0) {
+            auto entry = victim.PopFront();
+            m_pendingJobs--;
+            return entry;
+        }
+    }
+
+    return nullptr;
+}
+
+void CaptureScheduler::WorkerQueue::Reserve(size_t capacity) {
+    if (capacity <= jobs.size()) return;
+
+    // Unwrap the ring into the larger buffer
+    std::vector<std::shared_ptr<Entry>> resized(capacity);
+    for (size_t i = 0; i < count; i++) {
+        resized[i] = std::move(jobs[(head + i) % jobs.size()]);
+    }
+    jobs.swap(resized);
+    head = 0;
+}
+
+void CaptureScheduler::WorkerQueue::PushBack(std::shared_ptr<Entry> entry) {
+    // Only grows if a removed task is still queued when its slot is reused
+    if (count == jobs.size()) {
+        Reserve(jobs.empty() ? 4 : jobs.size() * 2);
+    }
+    jobs[(head + count) % jobs.size()] = std::move(entry);
+    count++;
+}
+
+std::shared_ptr<CaptureScheduler::Entry> CaptureScheduler::WorkerQueue::PopBack() {
+    count--;
+    return std::move(jobs[(head + count) % jobs.size()]);
+}
+
+std::shared_ptr<CaptureScheduler::Entry> CaptureScheduler::WorkerQueue::PopFront() {
+    auto entry = std::move(jobs[head]);
+    head = (head + 1) % jobs.size();
+    count--;
+    return entry;
+}
+
+void CaptureScheduler::RunJob(const std::shared_ptr<Entry>& entry) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entry->queued = false;
+        if (entry->removed) {
+            m_entryIdle.notify_all();
+            return;
+        }
+        entry->running = true;
+    }
+
+    entry->task->Run();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        entry->running = false;
+
+        // Keep the cadence, but skip ticks that were missed entirely
+        auto now = Clock::now();
+        entry->due += entry->period;
+        if (entry->due < now || entry->woken) {
+            entry->due = now;
+        }
+        entry->woken = false;
+    }
+    m_entryIdle.notify_all();
+    m_timerWake.notify_one();
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Runs periodic capture tasks for any number of clients on a small, fixed
+// pool of worker threads. A timer thread hands due tasks to the workers'
+// queues round-robin; a worker that runs dry steals from the others, so
+// one slow client does not hold up the rest. Thread count follows the
+// core count, not the client count.
+class CaptureScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TaskId = uint64_t;
+
+    class Task {
+    public:
+        virtual ~Task() = default;
+        virtual void Run() = 0;
+    };
+
+    // workerCount 0 picks a size from the number of cores
+    explicit CaptureScheduler(size_t workerCount = 0);
+    ~CaptureScheduler();
+
+    CaptureScheduler(const CaptureScheduler&) = delete;
+    CaptureScheduler& operator=(const CaptureScheduler&) = delete;
+
+    // Run task every period, starting now. The task must outlive its registration.
+    TaskId Add(Task* task, Clock::duration period);
+
+    // Unregister a task and wait for any in-flight run to finish. Must not be
+    // called from inside a task.
+    void Remove(TaskId id);
+
+    // Run a task as soon as a worker is free instead of at its next tick; a
+    // task woken mid-run runs again straight after. Never waits for the task.
+    void Wake(TaskId id);
+
+    // Change a task's period; may be called from inside the task
+    void SetPeriod(TaskId id, Clock::duration period);
+
+    // CPU time the scheduler's own threads have used so far, read from the
+    // per-thread CPU clocks; the time spent capturing, without the UI thread
+    std::chrono::nanoseconds GetCpuTime();
+
+    size_t GetWorkerCount() const { return m_workers.size(); }
+    size_t GetTaskCount() const;
+
+    static constexpr size_t MAX_DEFAULT_WORKERS = 4;
+
+private:
+    struct Entry {
+        TaskId id = 0;
+        Task* task = nullptr;
+        Clock::duration period{};
+        Clock::time_point due;
+        bool queued = false;
+        bool running = false;
+        bool removed = false;
+        bool woken = false;     // Wake() arrived while running
+    };
+
+    // Ring of queued jobs. Add sizes it for every task, so queueing and
+    // stealing never touch the heap once tasks are registered.
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Entry>> jobs;
+        size_t head = 0;
+        size_t count = 0;
+
+        void Reserve(size_t capacity);
+        void PushBack(std::shared_ptr<Entry> entry);
+        std::shared_ptr<Entry> PopBack();
+        std::shared_ptr<Entry> PopFront();
+    };
+
+    void TimerLoop();
+    void WorkerLoop(size_t index);
+    std::shared_ptr<Entry> PopJob(size_t index);
+    void RunJob(const std::shared_ptr<Entry>& entry);
+
+    // Guards m_entries, every Entry's state flags and m_stopping
+    mutable std::mutex m_mutex;
+    std::condition_variable m_timerWake;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_entryIdle;
+
+    std::unordered_map<TaskId, std::shared_ptr<Entry>> m_entries;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    // Jobs in all queues; only changed under the lock of the queue the job
+    // goes into or comes out of, so pops never outrun pushes
+    std::atomic<size_t> m_pendingJobs;
+    TaskId m_nextId;
+    size_t m_nextQueue;
+    bool m_stopping;
+
+    std::vector<std::thread> m_workers;
+    std::thread m_timer;
+};
@@ -1,298 +1,310 @@
 #include "CaptureSystem.h"
 
-CaptureSystem::CaptureSystem()
-    : m_overlayWindow(nullptr)
-    , m_screenDC(nullptr)
-    , m_memoryDC(nullptr)
-    , m_captureBitmap(nullptr)
-    , m_bitmapData(nullptr)
-    , m_isCapturing(false) {
+#include <algorithm>
+
+CaptureSystem::CaptureSystem(CaptureScheduler& scheduler, std::unique_ptr<CaptureDevice> device,
+    std::unique_ptr<CaptureSink> sink)
+    : m_device(std::move(device))
+    , m_sink(std::move(sink))
+    , m_requestedPaused(false)
+    , m_isDeviceOpen(false)
+    , m_bufferPool(*m_device)
+    , m_captureBuffer(nullptr)
+    , m_isCapturing(false)
+    , m_isPaused(false)
+    , m_quality(CaptureQuality::Full)
+    , m_scheduler(scheduler)
+    , m_taskId(0) {
 }
 
 CaptureSystem::~CaptureSystem() {
-    StopCapture();
-    CleanupCaptureDC();
-}
+    Shutdown();
 
-bool CaptureSystem::Initialize(HWND overlayWindow) {
-    m_overlayWindow = overlayWindow;
-    return SetupCaptureDC();
+    m_captureBuffer = nullptr;
+    m_bufferPool.Clear();
+    if (m_isDeviceOpen) {
+        m_device->Close();
+    }
 }
 
-bool CaptureSystem::SetupCaptureDC() {
-    // Get screen DC
-    m_screenDC = GetDC(nullptr);
-    if (!m_screenDC) return false;
-
-    // Create compatible DC
-    m_memoryDC = CreateCompatibleDC(m_screenDC);
-    if (!m_memoryDC) {
-        ReleaseDC(nullptr, m_screenDC);
-        m_screenDC = nullptr;
-        return false;
+bool CaptureSystem::Initialize(const std::string& channelName) {
+    // Publishing is best effort; the overlay works without external readers
+    if (!channelName.empty()) {
+        m_pipeline.OpenChannel(channelName.c_str());
     }
 
+    if (!m_device->Open()) return false;
+    m_isDeviceOpen = true;
+
+    // Registered for good; while stopped a tick only checks for commands
+    m_taskId = m_scheduler.Add(this, FRAME_DURATION);
     return true;
 }
 
-void CaptureSystem::CleanupCaptureDC() {
-    if (m_captureBitmap) {
-        DeleteObject(m_captureBitmap);
-        m_captureBitmap = nullptr;
+CaptureSystem::Geometry CaptureSystem::MakeGeometry(const CaptureRect& region, const CaptureRect* textRegion) {
+    // One blit covers the bar and, when set, the XP text next to it
+    Geometry geometry;
+    geometry.capture = region;
+    geometry.bar = region;
+    geometry.hasText = textRegion && textRegion->right > textRegion->left &&
+        textRegion->bottom > textRegion->top;
+    if (geometry.hasText) {
+        geometry.capture.left = (std::min)(region.left, textRegion->left);
+        geometry.capture.top = (std::min)(region.top, textRegion->top);
+        geometry.capture.right = (std::max)(region.right, textRegion->right);
+        geometry.capture.bottom = (std::max)(region.bottom, textRegion->bottom);
+        geometry.text = *textRegion;
     }
+    return geometry;
+}
 
-    if (m_memoryDC) {
-        DeleteDC(m_memoryDC);
-        m_memoryDC = nullptr;
-    }
+bool CaptureSystem::Send(const Command& command) {
+    if (!m_commands.TryPush(command)) return false;
 
-    if (m_screenDC) {
-        ReleaseDC(nullptr, m_screenDC);
-        m_screenDC = nullptr;
+    // Apply it now rather than at the next tick
+    if (m_taskId) {
+        m_scheduler.Wake(m_taskId);
     }
+    return true;
 }
 
-bool CaptureSystem::StartCapture(const RECT& region) {
-    if (m_isCapturing) return false;
-
-    m_captureRegion = region;
-    int width = region.right - region.left;
-    int height = region.bottom - region.top;
+bool CaptureSystem::StartCapture(const CaptureRect& region, const CaptureRect* textRegion, const AnalyzerWarmState* warmState) {
+    Command command;
+    command.type = Command::Type::Start;
+    command.geometry = MakeGeometry(region, textRegion);
+    if (warmState) {
+        command.hasWarmState = true;
+        command.warmState = *warmState;
+    }
+    return Send(command);
+}
 
-    // Create bitmap for capture
-    BITMAPINFO bmi = {};
-    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-    bmi.bmiHeader.biWidth = width;
-    bmi.bmiHeader.biHeight = -height; // Top-down
-    bmi.bmiHeader.biPlanes = 1;
-    bmi.bmiHeader.biBitCount = 32;
-    bmi.bmiHeader.biCompression = BI_RGB;
+bool CaptureSystem::StopCapture() {
+    Command command;
+    command.type = Command::Type::Stop;
+    return Send(command);
+}
 
-    m_captureBitmap = CreateDIBSection(m_memoryDC, &bmi, DIB_RGB_COLORS,
-        reinterpret_cast<void**>(&m_bitmapData),
-        nullptr, 0);
-    if (!m_captureBitmap) return false;
+bool CaptureSystem::Retarget(const CaptureRect& region, const CaptureRect* textRegion) {
+    Command command;
+    command.type = Command::Type::Retarget;
+    command.geometry = MakeGeometry(region, textRegion);
+    return Send(command);
+}
 
-    // Start capture thread
-    m_isCapturing = true;
-    m_captureThread = std::make_unique<std::thread>(&CaptureSystem::CaptureThread, this);
+bool CaptureSystem::SetPaused(bool paused) {
+    Command command;
+    command.type = paused ? Command::Type::Pause : Command::Type::Resume;
+    if (!Send(command)) return false;
 
+    m_requestedPaused = paused;
     return true;
 }
 
-void CaptureSystem::StopCapture() {
-    if (!m_isCapturing) return;
+bool CaptureSystem::SetCaptureRate(int framesPerSecond) {
+    if (framesPerSecond <= 0) return false;
 
-    m_isCapturing = false;
-    if (m_captureThread && m_captureThread->joinable()) {
-        m_captureThread->join();
-    }
+    Command command;
+    command.type = Command::Type::SetRate;
+    command.framesPerSecond = framesPerSecond;
+    return Send(command);
 }
 
-void CaptureSystem::CaptureThread() {
-    auto nextCapture = std::chrono::steady_clock::now();
-
-    while (m_isCapturing) {
-        // Process frame
-        float xpPercentage = ProcessFrame();
-
-        // TODO: Update UI with new XP percentage
-
-        // Wait for next frame
-        nextCapture += FRAME_DURATION;
-        std::this_thread::sleep_until(nextCapture);
-    }
+bool CaptureSystem::SetQuality(CaptureQuality quality, int sampleStep) {
+    Command command;
+    command.type = Command::Type::SetQuality;
+    command.quality = quality;
+    command.sampleStep = quality == CaptureQuality::Sampled ? sampleStep : 1;
+    return Send(command);
 }
 
-float CaptureSystem::ProcessFrame() {
-    // Select bitmap into DC
-    HBITMAP oldBitmap = (HBITMAP)SelectObject(m_memoryDC, m_captureBitmap);
-
-    // Capture screen region
-    BitBlt(m_memoryDC, 0, 0,
-        m_captureRegion.right - m_captureRegion.left,
-        m_captureRegion.bottom - m_captureRegion.top,
-        m_screenDC,
-        m_captureRegion.left, m_captureRegion.top,
-        SRCCOPY);
-
-    // Analyze the captured region
-    float result = AnalyzeRegion();
-
-    // Convert to percentage string with 2 decimal places
-    std::wstringstream ss;
-    ss << std::fixed << std::setprecision(2) << result << L"%";
-    // Signal main window to update (we'll add this functionality)
-    PostMessage(m_overlayWindow, WM_USER_XP_UPDATE, 0,
-        reinterpret_cast<LPARAM>(_wcsdup(ss.str().c_str())));
-
-    // Cleanup
-    SelectObject(m_memoryDC, oldBitmap);
-
-    return result;
+bool CaptureSystem::Recalibrate() {
+    Command command;
+    command.type = Command::Type::Recalibrate;
+    return Send(command);
 }
 
-bool CaptureSystem::IsFilledPixel(const RGBQUAD& pixel) {
-    // Check for XP fill color (#2D67E2)
-    const int fillRed = 0x2D;    // 45
-    const int fillGreen = 0x67;  // 103
-    const int fillBlue = 0xE2;   // 226
-
-    // Allow some tolerance for slight variations
-    const int tolerance = 20;
+void CaptureSystem::Shutdown() {
+    if (m_taskId) {
+        // Waits only for a frame that is being processed right now
+        m_scheduler.Remove(m_taskId);
+        m_taskId = 0;
+    }
 
-    return abs(pixel.rgbRed - fillRed) <= tolerance &&
-        abs(pixel.rgbGreen - fillGreen) <= tolerance &&
-        abs(pixel.rgbBlue - fillBlue) <= tolerance;
+    // No worker runs the task any more, so this thread may drain the queue
+    ApplyCommands();
+    m_isCapturing = false;
+    ReleaseBuffer();
 }
 
-bool CaptureSystem::IsMarkerPixel(const RGBQUAD& pixel) {
-    // Check for regular marker color (#99A6C0)
-    const int markerRed = 0x99;   // 153
-    const int markerGreen = 0xA6; // 166
-    const int markerBlue = 0xC0;  // 192
-
-    // Check for filled marker color (#9BB0ED)
-    const int filledMarkerRed = 0x9B;   // 155
-    const int filledMarkerGreen = 0xB0; // 176
-    const int filledMarkerBlue = 0xED;  // 237
-
-    const int tolerance = 12;
+void CaptureSystem::Run() {
+    ApplyCommands();
 
-    // Check if it's either a regular marker or a filled marker
-    bool isRegularMarker = abs(pixel.rgbRed - markerRed) <= tolerance &&
-        abs(pixel.rgbGreen - markerGreen) <= tolerance &&
-        abs(pixel.rgbBlue - markerBlue) <= tolerance;
-
-    bool isFilledMarker = abs(pixel.rgbRed - filledMarkerRed) <= tolerance &&
-        abs(pixel.rgbGreen - filledMarkerGreen) <= tolerance &&
-        abs(pixel.rgbBlue - filledMarkerBlue) <= tolerance;
+    if (m_isCapturing && !m_isPaused) {
+        ProcessFrame();
+    }
+}
 
-    return isRegularMarker || isFilledMarker;
+void CaptureSystem::ApplyCommands() {
+    Command command;
+    while (m_commands.TryPop(command)) {
+        ApplyCommand(command);
+    }
 }
 
-bool CaptureSystem::IsFilledMarkerPixel(const RGBQUAD& pixel) {
-    const int filledMarkerRed = 0x9B;   // 155
-    const int filledMarkerGreen = 0xB0; // 176
-    const int filledMarkerBlue = 0xED;  // 237
+void CaptureSystem::ApplyCommand(const Command& command) {
+    switch (command.type) {
+    case Command::Type::Start:
+        // Hand the old buffer back first so the pool can reuse it
+        m_isCapturing = false;
+        ReleaseBuffer();
+        if (!ApplyGeometry(command.geometry)) {
+            m_sink->OnCaptureFailed();
+            break;
+        }
 
-    const int tolerance = 12;
+        if (command.hasWarmState) {
+            m_pipeline.SetWarmState(command.warmState);
+        }
+        else {
+            m_pipeline.ResetWarmState();
+        }
+        // Filter history belongs to the previous region
+        m_pipeline.ResetConditioner();
+        m_isCapturing = true;
+        break;
+
+    case Command::Type::Stop:
+        m_isCapturing = false;
+        ReleaseBuffer();
+        break;
+
+    case Command::Type::Retarget:
+        // Ignored while stopped; a failed resize keeps capturing the old geometry
+        if (m_isCapturing) {
+            ApplyGeometry(command.geometry);
+        }
+        break;
 
-    return abs(pixel.rgbRed - filledMarkerRed) <= tolerance &&
-        abs(pixel.rgbGreen - filledMarkerGreen) <= tolerance &&
-        abs(pixel.rgbBlue - filledMarkerBlue) <= tolerance;
-}
+    case Command::Type::Pause:
+        m_isPaused = true;
+        break;
 
-bool CaptureSystem::IsVerticalBarSequence(int x, int y) {
-    const int verticalBarWidth = 4; // Vertical bars are 4 pixels wide
-    const int tolerance = 10; // Tolerance for color variations
+    case Command::Type::Resume:
+        m_isPaused = false;
+        break;
 
-    // Check if the next 4 pixels are vertical bar pixels
-    for (int i = 0; i < verticalBarWidth; i++) {
-        if (x + i >= m_captureRegion.right - m_captureRegion.left) {
-            return false; // Out of bounds
+    case Command::Type::SetRate:
+        if (m_taskId) {
+            m_scheduler.SetPeriod(m_taskId, std::chrono::microseconds(1000000 / command.framesPerSecond));
         }
+        break;
 
-        RGBQUAD* pixel = reinterpret_cast<RGBQUAD*>(
-            m_bitmapData + (y * (m_captureRegion.right - m_captureRegion.left) + (x + i)) * 4);
+    case Command::Type::SetQuality:
+        m_quality = command.quality;
+        m_pipeline.SetSampleStep(command.sampleStep);
+        break;
 
-        if (!IsMarkerPixel(*pixel)) {
-            return false; // Not a vertical bar pixel
-        }
+    case Command::Type::Recalibrate:
+        m_pipeline.ResetWarmState();
+        m_pipeline.ResetConditioner();
+        break;
     }
-
-    return true; // Found a 4-pixel vertical bar sequence
 }
 
-bool CaptureSystem::IsBackgroundPixel(const RGBQUAD& pixel) {
-    // Check for background color (#002240)
-    const int bgRed = 0x00;   // 0
-    const int bgGreen = 0x22; // 34
-    const int bgBlue = 0x40;  // 64
-
-    const int tolerance = 8;
+bool CaptureSystem::ApplyGeometry(const Geometry& geometry) {
+    // A move keeps the buffer; only a size beyond its capacity needs another.
+    // A buffer left over from a previous region is reused when large enough.
+    const int width = geometry.GetWidth();
+    const int height = geometry.GetHeight();
+    if (!m_captureBuffer || width > m_captureBuffer->capacityWidth || height > m_captureBuffer->capacityHeight) {
+        CaptureBufferPool::Buffer* buffer = m_bufferPool.Acquire(width, height);
+        if (!buffer) return false;
+        ReleaseBuffer();
+        m_captureBuffer = buffer;
+    }
 
-    return abs(pixel.rgbRed - bgRed) <= tolerance &&
-        abs(pixel.rgbGreen - bgGreen) <= tolerance &&
-        abs(pixel.rgbBlue - bgBlue) <= tolerance;
+    m_geometry = geometry;
+    return true;
 }
 
-float CaptureSystem::AnalyzeRegion() {
-    if (!m_bitmapData) return 0.0f;
-
-    const int width = m_captureRegion.right - m_captureRegion.left;
-    const int height = m_captureRegion.bottom - m_captureRegion.top;
-
-    if (width <= 0 || height <= 0) return 0.0f;
+void CaptureSystem::ReleaseBuffer() {
+    if (!m_captureBuffer) return;
 
-    // Sample from the middle vertical position of the bar
-    const int sampleY = height / 2;
-
-    // Count filled pixels
-    int filledPixels = 0;
-    int totalPixels = 0;
+    m_bufferPool.Release(m_captureBuffer);
+    m_captureBuffer = nullptr;
+}
 
-    // Scan horizontally across the bar
-    for (int x = 0; x < width; x++) {
-        RGBQUAD* pixel = reinterpret_cast<RGBQUAD*>(
-            m_bitmapData + (sampleY * width + x) * 4);
+CaptureRect CaptureSystem::GetGaugeLine(const CaptureRect& bar) const {
+    // The row or column the analyzer samples, as a one pixel band
+    CaptureRect line = bar;
+    if (m_pipeline.GetGaugeLayout().orientation == GaugeOrientation::Horizontal) {
+        line.top = bar.top + (bar.bottom - bar.top) / 2;
+        line.bottom = line.top + 1;
+    }
+    else {
+        line.left = bar.left + (bar.right - bar.left) / 2;
+        line.right = line.left + 1;
+    }
+    return line;
+}
 
-        // Skip if pixel isn't part of the XP bar (i.e., not fill color or background)
-        if (!IsFilledPixel(*pixel) && !IsBackgroundPixel(*pixel) && !IsMarkerPixel(*pixel)) {
-            continue;
-        }
+float CaptureSystem::ProcessFrame() {
+    // Band only: blit just the gauge line, which is the whole bar view, and
+    // skip the text
+    const auto start = std::chrono::steady_clock::now();
+    const bool isBandOnly = m_quality >= CaptureQuality::BandOnly;
+    const CaptureRect captureRegion = isBandOnly ? GetGaugeLine(m_geometry.bar) : m_geometry.capture;
+    const int width = captureRegion.right - captureRegion.left;
+    const int height = captureRegion.bottom - captureRegion.top;
+
+    // Capture screen region into the top-left corner of the buffer. A failed
+    // blit leaves the previous frame's pixels, which carry nothing new.
+    if (!m_device->Blit(*m_captureBuffer, captureRegion)) {
+        return GetDisplay().percent;
+    }
 
-        // Check if this is the start of a marker sequence
-        if (IsVerticalBarSequence(x, sampleY)) {
-            bool isFilledLeft = false;
-            bool isFilledRight = false;
-
-            // Check pixels on both sides of the marker
-            if (x > 0) {
-                RGBQUAD* pixelLeft = reinterpret_cast<RGBQUAD*>(
-                    m_bitmapData + (sampleY * width + (x - 1)) * 4);
-                isFilledLeft = IsFilledPixel(*pixelLeft);
-            }
-
-            if (x + 4 < width) {
-                RGBQUAD* pixelRight = reinterpret_cast<RGBQUAD*>(
-                    m_bitmapData + (sampleY * width + (x + 4)) * 4);
-                isFilledRight = IsFilledPixel(*pixelRight);
-            }
-
-            // Check if the marker itself shows the filled color
-            bool isMarkerFilled = false;
-            for (int i = 0; i < 4; i++) {
-                RGBQUAD* markerPixel = reinterpret_cast<RGBQUAD*>(
-                    m_bitmapData + (sampleY * width + (x + i)) * 4);
-                if (IsFilledMarkerPixel(*markerPixel)) {
-                    isMarkerFilled = true;
-                    break;
-                }
-            }
-
-            // Count marker as filled if either:
-            // 1. Both sides are filled
-            // 2. The marker itself shows the filled marker color
-            if ((isFilledLeft && isFilledRight) || isMarkerFilled) {
-                filledPixels += 4;
-            }
-            totalPixels += 4;
-            x += 3; // Skip the rest of the marker
-            continue;
-        }
+    // Bar and text are sub-rectangles of the same capture
+    const FrameView frame = CaptureBufferPool::MakeView(*m_captureBuffer, width, height);
+    const CaptureRect& barRegion = isBandOnly ? captureRegion : m_geometry.bar;
+    const FrameView bar = frame.SubView(barRegion.left - captureRegion.left,
+        barRegion.top - captureRegion.top,
+        barRegion.right - barRegion.left, barRegion.bottom - barRegion.top);
+    FrameView text;
+    if (m_geometry.hasText && !isBandOnly) {
+        const CaptureRect& textRegion = m_geometry.text;
+        text = frame.SubView(textRegion.left - captureRegion.left,
+            textRegion.top - captureRegion.top,
+            textRegion.right - textRegion.left, textRegion.bottom - textRegion.top);
+    }
 
-        // Count normal pixels
-        if (IsFilledPixel(*pixel)) {
-            filledPixels++;
+    // Analyze, filter and publish
+    GaugePipeline::Result result = m_pipeline.Process(bar, text);
+    const float percent = result.exact.valid ? result.exact.GetPercent() : result.conditioned.value;
+
+    // Only changes beyond the hysteresis, or new exact numbers, reach the
+    // overlay. The sink only announces the value; the overlay formats it
+    // from GetDisplay, so nothing is allocated per frame.
+    if (result.emit) {
+        {
+            std::lock_guard<std::mutex> lock(m_displayMutex);
+            m_display.percent = percent;
+            m_display.exact = result.exact;
         }
-        totalPixels++;
+        m_sink->OnXpUpdate(percent);
     }
 
-    // Calculate percentage
-    if (totalPixels > 0) {
-        return (filledPixels * 100.0f) / totalPixels;
+    // The recorder stays frozen until the overlay has dumped it
+    if (result.recorderFrozen) {
+        m_sink->OnRecorderFrozen();
     }
 
-    return 0.0f;
-}
\ No newline at end of file
+    m_sink->OnFrameProcessed(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start));
+    return percent;
+}
+
+CaptureSystem::Display CaptureSystem::GetDisplay() const {
+    std::lock_guard<std::mutex> lock(m_displayMutex);
+    return m_display;
+}
@@ -1,58 +1,217 @@
-#define WM_USER_XP_UPDATE (WM_USER + 1)
-
 #pragma once
-#include <windows.h>
 #include <memory>
 #include <chrono>
-#include <thread>
-#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include "CaptureBufferPool.h"
+#include "CaptureDevice.h"
+#include "CaptureScheduler.h"
+#include "CpuGovernor.h"
+#include "FrameView.h"
+#include "GaugeLayout.h"
+#include "GaugePipeline.h"
+#include "SharedSampleChannel.h"
+#include "SignalConditioner.h"
+#include "SpscQueue.h"
+#include "WarmState.h"
+#include "XpBarPalette.h"
+#include "XpSample.h"
 
-class CaptureSystem {
+// Where a CaptureSystem announces results; the overlay posts them to its
+// window (see GdiCapture.h). Called on the capture task, so implementations
+// only hand the event over and return.
+class CaptureSink {
 public:
-    CaptureSystem();
-    ~CaptureSystem();
+    virtual ~CaptureSink() = default;
 
-    // Initialize capture system
-    bool Initialize(HWND overlayWindow);
+    // A new value is ready in GetDisplay
+    virtual void OnXpUpdate(float percent) = 0;
 
-    // Start/Stop capture
-    bool StartCapture(const RECT& region);
-    void StopCapture();
+    // StartCapture could not get a capture buffer
+    virtual void OnCaptureFailed() = 0;
 
-    // Process one frame and return XP percentage (0-100)
-    float ProcessFrame();
+    // The flight recorder froze and waits to be dumped
+    virtual void OnRecorderFrozen() = 0;
+
+    // Time from the start of the blit to the end of publishing, every frame
+    virtual void OnFrameProcessed(std::chrono::microseconds /*elapsed*/) {}
+};
+
+// Captures and analyzes one game window's XP bar. The capture task stays
+// registered with the CaptureScheduler shared by every tracked window from
+// Initialize to Shutdown; the UI thread steers it through a lock-free
+// command queue and wakes it, so reconfiguring never waits for a frame.
+// Pixels come from a CaptureDevice and results go to a CaptureSink, so the
+// same code runs against the screen and against a synthetic gauge.
+class CaptureSystem : public CaptureScheduler::Task {
+public:
+    CaptureSystem(CaptureScheduler& scheduler, std::unique_ptr<CaptureDevice> device,
+        std::unique_ptr<CaptureSink> sink);
+    ~CaptureSystem() override;
+
+    // Open the device and register the capture task; samples are published
+    // under channelName, or not at all if it is empty
+    bool Initialize(const std::string& channelName = SharedSampleChannel::DEFAULT_NAME);
+
+    // Commands. Each is queued for the capture task and wakes it; none waits
+    // for a frame. False only if the queue is full. Call them from the
+    // thread that owns the overlay window.
+
+    // Start (or restart) capture. Regions are in screen coordinates.
+    // textRegion, if given, is the XP text read for exact numbers; it is
+    // captured in the same blit as the bar. warmState, if given, is trusted
+    // for the first frame, otherwise analysis starts cold. If no capture
+    // buffer can be had the sink's OnCaptureFailed is called.
+    bool StartCapture(const CaptureRect& region, const CaptureRect* textRegion = nullptr,
+        const AnalyzerWarmState* warmState = nullptr);
+    bool StopCapture();
+
+    // Move the capture while it runs, e.g. when the game window moves; the
+    // buffer is only replaced if the new size does not fit it
+    bool Retarget(const CaptureRect& region, const CaptureRect* textRegion = nullptr);
+
+    // Pause/Resume analysis without giving up the region or buffer
+    bool SetPaused(bool paused);
+    bool IsPaused() const { return m_requestedPaused; }
+
+    // Capture rate until SetCaptureRate changes it
+    static constexpr int CAPTURE_FPS = 4; // 4 frames per second
+    bool SetCaptureRate(int framesPerSecond);
+
+    // Degrade or restore the capture for the CPU governor. The rate is set
+    // separately with SetCaptureRate; from BandOnly on only the gauge line
+    // is blitted and the XP text is not read, and Sampled probes every
+    // sampleStep pixels for a moved fill edge.
+    bool SetQuality(CaptureQuality quality, int sampleStep);
+
+    // Forget the warm state and filter history and rescan from scratch
+    bool Recalibrate();
+
+    // Unregister the capture task, waiting only for a frame in progress,
+    // then apply whatever is still queued. Called by the destructor.
+    void Shutdown();
+
+    // Latest emitted value, announced by the sink's OnXpUpdate
+    struct Display {
+        float percent = 0.0f;   // Exact when the XP text was read
+        XpTextReading exact;
+    };
+    Display GetDisplay() const;
+
+    // Warm state; only valid after Shutdown
+    const AnalyzerWarmState& GetWarmState() const { return m_pipeline.GetWarmState(); }
+
+    // Palette the classifier matches against; only set before the first StartCapture
+    void SetPalette(const XpBarPalette& palette) { m_pipeline.SetPalette(palette); }
+
+    // Gauge geometry; false if no analyzer is instantiated for the layout.
+    // Only set before the first StartCapture
+    bool SetGaugeLayout(const GaugeLayout& layout) { return m_pipeline.SetGaugeLayout(layout); }
+
+    // Filtering between analysis and publishing; only set before the first StartCapture
+    void SetConditionerConfig(const SignalConditionerConfig& config) { m_pipeline.SetConditionerConfig(config); }
+
+    // Glyph templates for the exact XP read, shared between clients; only set before the first StartCapture
+    void SetDigitReader(std::shared_ptr<const DigitTemplateSet> templates, const DigitReaderConfig& config) {
+        m_pipeline.SetDigitTemplates(std::move(templates));
+        m_pipeline.SetDigitReaderConfig(config);
+    }
+
+    // Flight recorder settings; only set before the first StartCapture
+    void SetRecorderConfig(const FlightRecorderConfig& config) { m_pipeline.SetRecorderConfig(config); }
+
+    // Freeze the flight recorder at the next frame. Whenever it freezes the
+    // sink's OnRecorderFrozen is called; the recording may then be
+    // written from any thread, and recording goes on after ResumeRecorder.
+    void TriggerRecorder() { m_pipeline.GetRecorder().Trigger(); }
+    bool WriteRecording(std::ostream& out) const { return m_pipeline.WriteRecording(out); }
+    void ResumeRecorder() { m_pipeline.GetRecorder().Resume(); }
+    FlightFreezeReason GetRecorderFreezeReason() { return m_pipeline.GetRecorder().GetFreezeReason(); }
+
+    // Scheduler callback; applies queued commands, then processes one frame
+    // if capturing and not paused
+    void Run() override;
 
 private:
-    // Capture thread function
-    void CaptureThread();
+    // Screen rectangles of one capture
+    struct Geometry {
+        CaptureRect capture = { 0, 0, 0, 0 };  // Bounds of everything blitted
+        CaptureRect bar = { 0, 0, 0, 0 };
+        CaptureRect text = { 0, 0, 0, 0 };
+        bool hasText = false;
 
-    // Helper functions
-    bool SetupCaptureDC();
-    void CleanupCaptureDC();
-    float AnalyzeRegion();
-    bool IsFilledPixel(const RGBQUAD& pixel);
-    bool IsMarkerPixel(const RGBQUAD& pixel);
-    bool IsFilledMarkerPixel(const RGBQUAD& pixel);
-    bool IsBackgroundPixel(const RGBQUAD& pixel);
-    bool IsVerticalBarSequence(int x, int y);
+        int GetWidth() const { return capture.right - capture.left; }
+        int GetHeight() const { return capture.bottom - capture.top; }
+    };
 
+    // Queued from the UI thread, applied by the capture task
+    struct Command {
+        enum class Type {
+            Start,
+            Stop,
+            Retarget,
+            Pause,
+            Resume,
+            SetRate,
+            SetQuality,
+            Recalibrate
+        };
 
+        Type type = Type::Stop;
+        Geometry geometry;
+        bool hasWarmState = false;
+        AnalyzerWarmState warmState;
+        int framesPerSecond = 0;
+        CaptureQuality quality = CaptureQuality::Full;
+        int sampleStep = 1;
+    };
+
+    // Helper functions
+    static Geometry MakeGeometry(const CaptureRect& region, const CaptureRect* textRegion);
+    bool Send(const Command& command);
+    void ApplyCommands();
+    void ApplyCommand(const Command& command);
+    bool ApplyGeometry(const Geometry& geometry);
+    void ReleaseBuffer();
+    CaptureRect GetGaugeLine(const CaptureRect& bar) const;
+
+    // Process one frame and return XP percentage (0-100), exact when the XP text was read
+    float ProcessFrame();
 
     // Members
-    HWND m_overlayWindow;
-    RECT m_captureRegion;
+    std::unique_ptr<CaptureDevice> m_device;
+    std::unique_ptr<CaptureSink> m_sink;
+
+    // Commands from the UI thread
+    static constexpr size_t COMMAND_CAPACITY = 32;
+    SpscQueue<Command, COMMAND_CAPACITY> m_commands;
+    bool m_requestedPaused;     // UI thread's view of the pause state
 
-    // GDI resources
-    HDC m_screenDC;
-    HDC m_memoryDC;
-    HBITMAP m_captureBitmap;
-    BYTE* m_bitmapData;
+    // Analysis, filtering and publication
+    GaugePipeline m_pipeline;
 
-    // Thread control
-    std::atomic<bool> m_isCapturing;
-    std::unique_ptr<std::thread> m_captureThread;
+    // Capture buffers, from m_device
+    bool m_isDeviceOpen;
+    CaptureBufferPool m_bufferPool;
+    CaptureBufferPool::Buffer* m_captureBuffer;
+
+    // Last emitted value, handed to the UI thread
+    mutable std::mutex m_displayMutex;
+    Display m_display;
+
+    // Capture state, owned by whichever worker runs the task
+    Geometry m_geometry;
+    bool m_isCapturing;
+    bool m_isPaused;
+    CaptureQuality m_quality;
+
+    // Scheduling
+    CaptureScheduler& m_scheduler;
+    CaptureScheduler::TaskId m_taskId;
 
     // Timing control
-    static constexpr int CAPTURE_FPS = 4; // 4 frames per second
     static constexpr auto FRAME_DURATION = std::chrono::milliseconds(1000 / CAPTURE_FPS);
 };
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "ClassificationLoupe.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOUPE_SSE2 1
+#endif
+
+namespace {
+    // Tint per class: colour and weight out of 256. Other pixels keep their colour.
+    struct ClassTint {
+        uint8_t red, green, blue;
+        int weight;
+    };
+
+    constexpr ClassTint CLASS_TINTS[] = {
+        { 0x00, 0x00, 0x00, 0 },      // Other
+        { 0x00, 0x40, 0xFF, 160 },    // Background: blue
+        { 0x00, 0xFF, 0x40, 160 },    // Fill: green
+        { 0xFF, 0xE0, 0x00, 160 },    // Marker: yellow
+        { 0xFF, 0x40, 0xFF, 160 },    // FilledMarker: magenta
+    };
+
+    constexpr uint32_t CENTRE_FRAME = 0x00FFFFFF;
+}
+
+void ClassificationLoupe::Configure(const XpBarPalette& palette, int zoom) {
+    m_classifier.palette = palette;
+    m_zoom = zoom < 1 ? 1 : (zoom > MAX_ZOOM ? MAX_ZOOM : zoom);
+
+    for (int pixelClass = 0; pixelClass < CLASS_COUNT; pixelClass++) {
+        const ClassTint& tint = CLASS_TINTS[pixelClass];
+        const uint8_t colour[3] = { tint.blue, tint.green, tint.red };
+        for (int channel = 0; channel < 3; channel++) {
+            for (int value = 0; value < 256; value++) {
+                m_tint[pixelClass][channel][value] = static_cast<uint8_t>(
+                    (value * (256 - tint.weight) + colour[channel] * tint.weight) >> 8);
+            }
+        }
+    }
+}
+
+void ClassificationLoupe::Render(const FrameView& patch, uint8_t* out, int outStride) {
+    memset(m_classCounts, 0, sizeof(m_classCounts));
+
+    // Classify and tint each captured pixel once
+    const int width = patch.IsEmpty() ? 0 : (patch.width < PATCH_SIZE ? patch.width : PATCH_SIZE);
+    const int height = patch.IsEmpty() ? 0 : (patch.height < PATCH_SIZE ? patch.height : PATCH_SIZE);
+    for (int y = 0; y < PATCH_SIZE; y++) {
+        uint32_t* row = m_tinted + y * PATCH_SIZE;
+        for (int x = 0; x < PATCH_SIZE; x++) {
+            if (x >= width || y >= height) {
+                row[x] = 0;
+                continue;
+            }
+
+            const uint8_t* pixel = patch.PixelAt(x, y);
+            const int pixelClass = static_cast<int>(m_classifier.Classify(pixel));
+            m_classCounts[pixelClass]++;
+            row[x] = static_cast<uint32_t>(m_tint[pixelClass][0][pixel[0]]) |
+                (static_cast<uint32_t>(m_tint[pixelClass][1][pixel[1]]) << 8) |
+                (static_cast<uint32_t>(m_tint[pixelClass][2][pixel[2]]) << 16);
+        }
+    }
+
+    // Upscale: one replicated row per captured row, copied down zoom - 1 times
+    const size_t rowBytes = static_cast<size_t>(GetOutputSize()) * FrameView::BYTES_PER_PIXEL;
+    for (int y = 0; y < PATCH_SIZE; y++) {
+        uint8_t* first = out + static_cast<ptrdiff_t>(y) * m_zoom * outStride;
+        ReplicateRow(m_tinted + y * PATCH_SIZE, reinterpret_cast<uint32_t*>(first));
+        for (int copy = 1; copy < m_zoom; copy++) {
+            memcpy(first + static_cast<ptrdiff_t>(copy) * outStride, first, rowBytes);
+        }
+    }
+
+    // Frame the pixel under the cursor, once the cell is large enough to hold it
+    if (m_zoom >= 3) {
+        const int origin = (PATCH_SIZE / 2) * m_zoom;
+        for (int i = 0; i < m_zoom; i++) {
+            uint32_t* top = reinterpret_cast<uint32_t*>(out + static_cast<ptrdiff_t>(origin) * outStride) + origin + i;
+            uint32_t* bottom = reinterpret_cast<uint32_t*>(out + static_cast<ptrdiff_t>(origin + m_zoom - 1) * outStride) + origin + i;
+            uint32_t* left = reinterpret_cast<uint32_t*>(out + static_cast<ptrdiff_t>(origin + i) * outStride) + origin;
+            *top = CENTRE_FRAME;
+            *bottom = CENTRE_FRAME;
+            left[0] = CENTRE_FRAME;
+            left[m_zoom - 1] = CENTRE_FRAME;
+        }
+    }
+}
+
+void ClassificationLoupe::ReplicateRow(const uint32_t* source, uint32_t* destination) const {
+    const int zoom = m_zoom;
+    for (int x = 0; x < PATCH_SIZE; x++) {
+        uint32_t* cell = destination + x * zoom;
+        int i = 0;
+#ifdef LOUPE_SSE2
+        const __m128i pixel = _mm_set1_epi32(static_cast<int>(source[x]));
+        for (; i + 4 <= zoom; i += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(cell + i), pixel);
+        }
+#endif
+        for (; i < zoom; i++) {
+            cell[i] = source[x];
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+
+#include "FrameView.h"
+#include "GaugeAnalyzer.h"
+#include "XpBarPalette.h"
+
+// Settings for the setup-mode loupe, read from the [Loupe] INI section
+struct LoupeConfig {
+    bool enabled = true;
+    int zoom = 4;   // Output pixels per captured pixel
+};
+
+// Magnifies a PATCH_SIZE square of captured pixels and tints each pixel by
+// the class the analyzer's classifier gives it, so a region can be drawn
+// over exactly the pixels that will read as bar. Classification and
+// tinting go through per-class channel LUTs built by Configure; the
+// nearest-neighbour upscale writes each output row once and copies it down.
+// Render only touches fixed-size members and the caller's output buffer.
+// Platform independent.
+class ClassificationLoupe {
+public:
+    static constexpr int PATCH_SIZE = 64;
+    static constexpr int MAX_ZOOM = 8;
+
+    // Rebuild the LUTs; zoom is clamped to 1..MAX_ZOOM
+    void Configure(const XpBarPalette& palette, int zoom);
+
+    int GetZoom() const { return m_zoom; }
+
+    // Output is GetOutputSize() pixels square
+    int GetOutputSize() const { return PATCH_SIZE * m_zoom; }
+
+    // Classify patch, centred on the cursor and at most PATCH_SIZE square,
+    // and write the magnified, tinted image as BGRX rows outStride bytes
+    // apart. Pixels outside the patch are black; the centre pixel is framed.
+    void Render(const FrameView& patch, uint8_t* out, int outStride);
+
+    // Pixels of a class in the last rendered patch
+    int GetClassCount(PixelClass pixelClass) const { return m_classCounts[static_cast<int>(pixelClass)]; }
+
+private:
+    static constexpr int CLASS_COUNT = 5;
+
+    void ReplicateRow(const uint32_t* source, uint32_t* destination) const;
+
+    PaletteClassifier m_classifier;
+    int m_zoom = 1;
+
+    // Blend of each channel value with the class colour: [class][channel][value]
+    uint8_t m_tint[CLASS_COUNT][3][256] = {};
+
+    // Tinted patch, one packed BGRX value per captured pixel
+    uint32_t m_tinted[PATCH_SIZE * PATCH_SIZE] = {};
+    int m_classCounts[CLASS_COUNT] = {};
+};
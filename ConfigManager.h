@@ -2,19 +2,72 @@
 #include <windows.h>
 #include <string>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
 #include <shlobj.h>
 
+#include "ClassificationLoupe.h"
+#include "CpuGovernor.h"
+#include "DigitReader.h"
+#include "FlightRecorder.h"
+#include "GaugeLayout.h"
+#include "HotkeyBindings.h"
+#include "SignalConditioner.h"
+#include "WarmState.h"
+#include "XpBarPalette.h"
+
 #pragma comment(lib, "shell32.lib")
 
 class ConfigManager {
 public:
     struct Config {
-        // XP bar region
+        // XP bar region, relative to the game window's top-left corner
         RECT xpBarRegion = { 0, 0, 0, 0 };
         bool hasRegion = false;
+        SIZE regionReference = { 0, 0 }; // Game window size the regions were drawn on
+        bool normalizeRegion = false;    // Scale regions with the game window size
 
         // Text display
         POINT textPosition = { 350, 350 };
+
+        // Hotkeys, read from the [Hotkeys] section
+        HotkeyTable hotkeys;
+
+        // Classifier palette, read from the [Palette] section
+        XpBarPalette palette;
+
+        // Gauge geometry, read from the [Gauge] section
+        GaugeLayout gaugeLayout;
+
+        // Noise filtering, read from the [Filter] section
+        SignalConditionerConfig filter;
+
+        // Exact XP text read, from the [XpText] section. The region is
+        // relative to the game window like the XP bar region.
+        bool hasTextRegion = false;
+        RECT xpTextRegion = { 0, 0, 0, 0 };
+        DigitReaderConfig digitReader;
+        std::string digitGlyphs = "0123456789/,";
+        std::wstring digitTemplateFile = L"digits.pgm";
+
+        // XP history graph, from the [Sparkline] section
+        bool showSparkline = true;
+        int sparklineMinutes = 5;   // 0 shows the whole session
+        int sparklineWidth = 120;   // Pixels, at most SamplePyramid capacity
+        int sparklineHeight = 24;
+
+        // Misread diagnosis, from the [Recorder] section
+        FlightRecorderConfig recorder;
+
+        // Capture CPU budget, from the [Governor] section
+        CpuGovernorConfig governor;
+
+        // Setup-mode magnifier, from the [Loupe] section
+        LoupeConfig loupe;
+
+        // Analyzer state saved by the previous run
+        AnalyzerWarmState warmState;
     };
 
     ConfigManager() {
@@ -35,6 +88,10 @@ public:
 
         if (config.hasRegion) {
             WriteRegionToINI(L"Region", config.xpBarRegion);
+
+            wchar_t value[32];
+            swprintf_s(value, L"%d,%d", config.regionReference.cx, config.regionReference.cy);
+            WritePrivateProfileString(L"Region", L"Reference", value, m_configPath.c_str());
         }
 
         // Save text position
@@ -44,12 +101,14 @@ public:
     }
 
     // Save current application state
-    void SaveCurrentState(bool hasSelectedRegion, const RECT& selectedRegion, const POINT& textPosition) {
+    void SaveCurrentState(bool hasSelectedRegion, const RECT& selectedRegion, const POINT& textPosition,
+        const SIZE& windowSize) {
         Config config;
         config.textPosition = textPosition;
         config.hasRegion = hasSelectedRegion;
         if (config.hasRegion) {
             config.xpBarRegion = selectedRegion;
+            config.regionReference = windowSize;
         }
         SaveConfig(config);
     }
@@ -65,14 +124,106 @@ public:
         config.hasRegion = (_wtoi(buffer) != 0);
         if (config.hasRegion) {
             config.xpBarRegion = ReadRegionFromINI(L"Region");
+
+            GetPrivateProfileString(L"Region", L"Reference", L"0,0",
+                buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+            swscanf_s(buffer, L"%d,%d", &config.regionReference.cx, &config.regionReference.cy);
         }
+        config.normalizeRegion = GetPrivateProfileInt(L"Region", L"Normalize", 0, m_configPath.c_str()) != 0;
 
         // Load text position
         config.textPosition = ReadPointFromINI(L"TextDisplay", L"Position");
 
+        // Load hotkeys
+        config.hotkeys = ReadHotkeysFromINI(L"Hotkeys");
+
+        // Load palette and warm state
+        config.palette = ReadPaletteFromINI(L"Palette");
+        config.gaugeLayout = ReadGaugeLayoutFromINI(L"Gauge");
+        config.warmState = ReadWarmStateFromINI(L"WarmState");
+
+        // Load noise filtering
+        config.filter = ReadFilterFromINI(L"Filter");
+
+        // Load the exact XP text read
+        ReadXpTextFromINI(L"XpText", config);
+
+        // Load the history graph
+        config.showSparkline = GetPrivateProfileInt(L"Sparkline", L"Enabled", 1, m_configPath.c_str()) != 0;
+        config.sparklineMinutes = GetPrivateProfileInt(L"Sparkline", L"Minutes",
+            config.sparklineMinutes, m_configPath.c_str());
+        config.sparklineWidth = GetPrivateProfileInt(L"Sparkline", L"Width",
+            config.sparklineWidth, m_configPath.c_str());
+        config.sparklineHeight = GetPrivateProfileInt(L"Sparkline", L"Height",
+            config.sparklineHeight, m_configPath.c_str());
+
+        // Load the flight recorder
+        config.recorder = ReadRecorderFromINI(L"Recorder");
+
+        // Load the CPU budget
+        config.governor = ReadGovernorFromINI(L"Governor");
+
+        // Load the setup-mode magnifier
+        config.loupe.enabled = GetPrivateProfileInt(L"Loupe", L"Enabled",
+            config.loupe.enabled ? 1 : 0, m_configPath.c_str()) != 0;
+        config.loupe.zoom = GetPrivateProfileInt(L"Loupe", L"Zoom", config.loupe.zoom, m_configPath.c_str());
+
         return config;
     }
 
+    // Raw bytes of a file next to config.ini; empty if it can't be read
+    std::vector<uint8_t> ReadDataFile(const std::wstring& name) {
+        std::ifstream file(m_configPath.parent_path() / name, std::ios::binary);
+        if (!file) return {};
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // Directory next to config.ini, created if missing
+    std::filesystem::path GetDataDirectory(const std::wstring& name) {
+        std::filesystem::path directory = m_configPath.parent_path() / name;
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        return directory;
+    }
+
+    // Save a palette and marker width found by --tune; later launches classify with them
+    void SaveTuning(const XpBarPalette& palette, int markerWidth) {
+        std::filesystem::create_directories(m_configPath.parent_path());
+        WritePaletteToINI(L"Palette", palette);
+
+        wchar_t value[16];
+        swprintf_s(value, L"%d", markerWidth);
+        WritePrivateProfileString(L"Gauge", L"MarkerWidth", value, m_configPath.c_str());
+    }
+
+    // Save analyzer state for the next launch
+    void SaveWarmState(const AnalyzerWarmState& state) {
+        std::filesystem::create_directories(m_configPath.parent_path());
+
+        WritePrivateProfileString(L"WarmState", L"Valid",
+            state.valid ? L"1" : L"0", m_configPath.c_str());
+        if (!state.valid) return;
+
+        wchar_t value[64];
+        swprintf_s(value, L"%.4f", state.reading.percent);
+        WritePrivateProfileString(L"WarmState", L"Percent", value, m_configPath.c_str());
+
+        swprintf_s(value, L"%d,%d,%d", state.reading.filledPixels,
+            state.reading.totalPixels, state.frontier);
+        WritePrivateProfileString(L"WarmState", L"Counts", value, m_configPath.c_str());
+
+        swprintf_s(value, L"%d", state.gaugeLength);
+        WritePrivateProfileString(L"WarmState", L"GaugeLength", value, m_configPath.c_str());
+        WritePrivateProfileString(L"WarmState", L"Geometry", nullptr, m_configPath.c_str());
+
+        swprintf_s(value, L"%d,%d,%d",
+            static_cast<int>(state.layout.orientation), static_cast<int>(state.layout.direction),
+            state.layout.markerWidth);
+        WritePrivateProfileString(L"WarmState", L"Layout", value, m_configPath.c_str());
+
+        WritePaletteToINI(L"WarmState", state.palette);
+    }
+
 private:
     std::filesystem::path m_configPath;
 
@@ -99,6 +250,226 @@ private:
         WritePrivateProfileString(section, L"Bounds", value, m_configPath.c_str());
     }
 
+    // Hotkeys are only ever read; missing entries are written back with their
+    // defaults so the bindings are discoverable in the INI file
+    HotkeyTable ReadHotkeysFromINI(const wchar_t* section) {
+        HotkeyTable table;
+        for (int i = 1; i < static_cast<int>(HotkeyAction::Count); i++) {
+            auto action = static_cast<HotkeyAction>(i);
+            const wchar_t* name = GetHotkeyActionName(action);
+
+            wchar_t buffer[64];
+            DWORD length = GetPrivateProfileString(section, name, L"\x01",
+                buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+
+            if (length == 1 && buffer[0] == L'\x01') {
+                const wchar_t* defaultKey = GetDefaultHotkey(action);
+                std::filesystem::create_directories(m_configPath.parent_path());
+                WritePrivateProfileString(section, name, defaultKey, m_configPath.c_str());
+                table.Add(defaultKey, action);
+            }
+            else {
+                // An empty or unparseable entry leaves the action unbound
+                table.Add(std::wstring_view(buffer, length), action);
+            }
+        }
+        return table;
+    }
+
+    void WriteColorToINI(const wchar_t* section, const wchar_t* key, const PaletteColor& color) {
+        wchar_t value[32];
+        swprintf_s(value, L"%02X%02X%02X,%d", color.red, color.green, color.blue, color.tolerance);
+        WritePrivateProfileString(section, key, value, m_configPath.c_str());
+    }
+
+    PaletteColor ReadColorFromINI(const wchar_t* section, const wchar_t* key, const PaletteColor& fallback) {
+        wchar_t buffer[32];
+        GetPrivateProfileString(section, key, L"",
+            buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+
+        unsigned int red = 0, green = 0, blue = 0;
+        int tolerance = 0;
+        if (swscanf_s(buffer, L"%2x%2x%2x,%d", &red, &green, &blue, &tolerance) != 4) {
+            return fallback;
+        }
+        return PaletteColor{ static_cast<uint8_t>(red), static_cast<uint8_t>(green),
+            static_cast<uint8_t>(blue), tolerance };
+    }
+
+    void WritePaletteToINI(const wchar_t* section, const XpBarPalette& palette) {
+        WriteColorToINI(section, L"Fill", palette.fill);
+        WriteColorToINI(section, L"Marker", palette.marker);
+        WriteColorToINI(section, L"FilledMarker", palette.filledMarker);
+        WriteColorToINI(section, L"Background", palette.background);
+    }
+
+    XpBarPalette ReadPaletteFromINI(const wchar_t* section) {
+        XpBarPalette defaults;
+        XpBarPalette palette;
+        palette.fill = ReadColorFromINI(section, L"Fill", defaults.fill);
+        palette.marker = ReadColorFromINI(section, L"Marker", defaults.marker);
+        palette.filledMarker = ReadColorFromINI(section, L"FilledMarker", defaults.filledMarker);
+        palette.background = ReadColorFromINI(section, L"Background", defaults.background);
+        return palette;
+    }
+
+    GaugeLayout ReadGaugeLayoutFromINI(const wchar_t* section) {
+        GaugeLayout defaults;
+        GaugeLayout layout;
+
+        wchar_t buffer[32];
+        GetPrivateProfileString(section, L"Orientation", L"Horizontal",
+            buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+        layout.orientation = (_wcsicmp(buffer, L"Vertical") == 0) ?
+            GaugeOrientation::Vertical : GaugeOrientation::Horizontal;
+
+        GetPrivateProfileString(section, L"FillDirection", L"Forward",
+            buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+        layout.direction = (_wcsicmp(buffer, L"Reverse") == 0) ?
+            FillDirection::Reverse : FillDirection::Forward;
+
+        layout.markerWidth = GetPrivateProfileInt(section, L"MarkerWidth",
+            defaults.markerWidth, m_configPath.c_str());
+        return layout;
+    }
+
+    float ReadFloatFromINI(const wchar_t* section, const wchar_t* key, float fallback) {
+        wchar_t buffer[32];
+        GetPrivateProfileString(section, key, L"",
+            buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+        return buffer[0] ? static_cast<float>(_wtof(buffer)) : fallback;
+    }
+
+    SignalConditionerConfig ReadFilterFromINI(const wchar_t* section) {
+        SignalConditionerConfig defaults;
+        SignalConditionerConfig filter;
+
+        wchar_t buffer[32];
+        GetPrivateProfileString(section, L"Mode", L"Median",
+            buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+        if (_wcsicmp(buffer, L"None") == 0) {
+            filter.mode = SignalConditionerConfig::FilterMode::None;
+        }
+        else if (_wcsicmp(buffer, L"Exponential") == 0) {
+            filter.mode = SignalConditionerConfig::FilterMode::Exponential;
+        }
+        else {
+            filter.mode = SignalConditionerConfig::FilterMode::Median;
+        }
+
+        filter.medianWindow = GetPrivateProfileInt(section, L"MedianWindow",
+            defaults.medianWindow, m_configPath.c_str());
+        filter.smoothing = ReadFloatFromINI(section, L"Smoothing", defaults.smoothing);
+        filter.monotonicWithinLevel = GetPrivateProfileInt(section, L"MonotonicWithinLevel",
+            defaults.monotonicWithinLevel ? 1 : 0, m_configPath.c_str()) != 0;
+        filter.hysteresis = ReadFloatFromINI(section, L"Hysteresis", defaults.hysteresis);
+        filter.levelWrapDrop = ReadFloatFromINI(section, L"LevelWrapDrop", defaults.levelWrapDrop);
+        filter.levelWrapConfirmFrames = GetPrivateProfileInt(section, L"LevelWrapConfirmFrames",
+            defaults.levelWrapConfirmFrames, m_configPath.c_str());
+        filter.levelWrapMaxConfirmFrames = GetPrivateProfileInt(section, L"LevelWrapMaxConfirmFrames",
+            defaults.levelWrapMaxConfirmFrames, m_configPath.c_str());
+        filter.levelWrapLanding = ReadFloatFromINI(section, L"LevelWrapLanding", defaults.levelWrapLanding);
+        return filter;
+    }
+
+    AnalyzerWarmState ReadWarmStateFromINI(const wchar_t* section) {
+        AnalyzerWarmState state;
+        if (GetPrivateProfileInt(section, L"Valid", 0, m_configPath.c_str()) == 0) {
+            return state;
+        }
+
+        wchar_t buffer[64];
+        GetPrivateProfileString(section, L"Percent", L"",
+            buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+        if (swscanf_s(buffer, L"%f", &state.reading.percent) != 1) return state;
+
+        GetPrivateProfileString(section, L"Counts", L"",
+            buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+        if (swscanf_s(buffer, L"%d,%d,%d", &state.reading.filledPixels,
+            &state.reading.totalPixels, &state.frontier) != 3) return state;
+
+        // Files that still carry the old region Geometry start cold once
+        state.gaugeLength = GetPrivateProfileInt(section, L"GaugeLength", 0, m_configPath.c_str());
+        if (state.gaugeLength <= 0) return state;
+
+        int orientation = 0, direction = 0;
+        GetPrivateProfileString(section, L"Layout", L"",
+            buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+        // Files from before the marker period was dropped carry a fourth
+        // value, which is ignored
+        if (swscanf_s(buffer, L"%d,%d,%d", &orientation, &direction,
+            &state.layout.markerWidth) != 3) return state;
+        state.layout.orientation = static_cast<GaugeOrientation>(orientation);
+        state.layout.direction = static_cast<FillDirection>(direction);
+
+        state.palette = ReadPaletteFromINI(section);
+        state.valid = true;
+        return state;
+    }
+
+    FlightRecorderConfig ReadRecorderFromINI(const wchar_t* section) {
+        FlightRecorderConfig defaults;
+        FlightRecorderConfig recorder;
+        recorder.enabled = GetPrivateProfileInt(section, L"Enabled",
+            defaults.enabled ? 1 : 0, m_configPath.c_str()) != 0;
+        recorder.freezeOnDecrease = GetPrivateProfileInt(section, L"FreezeOnDecrease",
+            defaults.freezeOnDecrease ? 1 : 0, m_configPath.c_str()) != 0;
+        recorder.freezeOnDropout = GetPrivateProfileInt(section, L"FreezeOnDropout",
+            defaults.freezeOnDropout ? 1 : 0, m_configPath.c_str()) != 0;
+        recorder.decreaseTolerance = ReadFloatFromINI(section, L"DecreaseTolerance", defaults.decreaseTolerance);
+        recorder.postTriggerFrames = GetPrivateProfileInt(section, L"PostTriggerFrames",
+            defaults.postTriggerFrames, m_configPath.c_str());
+        recorder.minDumpIntervalSeconds = GetPrivateProfileInt(section, L"MinDumpInterval",
+            defaults.minDumpIntervalSeconds, m_configPath.c_str());
+        recorder.maxRecordings = GetPrivateProfileInt(section, L"MaxRecordings",
+            defaults.maxRecordings, m_configPath.c_str());
+        return recorder;
+    }
+
+    CpuGovernorConfig ReadGovernorFromINI(const wchar_t* section) {
+        CpuGovernorConfig defaults;
+        CpuGovernorConfig governor;
+        governor.enabled = GetPrivateProfileInt(section, L"Enabled",
+            defaults.enabled ? 1 : 0, m_configPath.c_str()) != 0;
+        governor.budgetPercent = ReadFloatFromINI(section, L"BudgetPercent", defaults.budgetPercent);
+        governor.intervalMs = GetPrivateProfileInt(section, L"IntervalMs",
+            defaults.intervalMs, m_configPath.c_str());
+        governor.restoreFraction = ReadFloatFromINI(section, L"RestoreFraction", defaults.restoreFraction);
+        governor.restoreIntervals = GetPrivateProfileInt(section, L"RestoreIntervals",
+            defaults.restoreIntervals, m_configPath.c_str());
+        governor.maxLevel = GetPrivateProfileInt(section, L"MaxLevel",
+            defaults.maxLevel, m_configPath.c_str());
+        governor.reducedFramesPerSecond = GetPrivateProfileInt(section, L"ReducedFps",
+            defaults.reducedFramesPerSecond, m_configPath.c_str());
+        governor.sampleStep = GetPrivateProfileInt(section, L"SampleStep",
+            defaults.sampleStep, m_configPath.c_str());
+        return governor;
+    }
+
+    void ReadXpTextFromINI(const wchar_t* section, Config& config) {
+        config.hasTextRegion = GetPrivateProfileInt(section, L"Enabled", 0, m_configPath.c_str()) != 0;
+        if (!config.hasTextRegion) return;
+
+        config.xpTextRegion = ReadRegionFromINI(section);
+        config.digitReader.threshold = GetPrivateProfileInt(section, L"Threshold",
+            config.digitReader.threshold, m_configPath.c_str());
+        config.digitReader.maxMismatch = GetPrivateProfileInt(section, L"MaxMismatch",
+            config.digitReader.maxMismatch, m_configPath.c_str());
+
+        wchar_t buffer[MAX_PATH];
+        GetPrivateProfileString(section, L"Templates", config.digitTemplateFile.c_str(),
+            buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+        config.digitTemplateFile = buffer;
+
+        // Glyph names are plain ASCII
+        GetPrivateProfileString(section, L"Glyphs", L"0123456789/,",
+            buffer, sizeof(buffer) / sizeof(wchar_t), m_configPath.c_str());
+        config.digitGlyphs.clear();
+        for (const wchar_t* c = buffer; *c; c++) {
+            if (*c < 0x80) config.digitGlyphs.push_back(static_cast<char>(*c));
+        }
+    }
+
     RECT ReadRegionFromINI(const wchar_t* section) {
         RECT rect = { 0, 0, 0, 0 };
         wchar_t buffer[64];
@@ -0,0 +1,127 @@
+#pragma once
+#include <chrono>
+#include <functional>
+
+// Settings for CpuGovernor, read from the [Governor] INI section
+struct CpuGovernorConfig {
+    bool enabled = true;
+    float budgetPercent = 0.5f;     // Capture CPU time allowed, in percent of one core
+    int intervalMs = 5000;          // Usage is averaged over this long
+    float restoreFraction = 0.5f;   // Headroom is usage below budget * this
+    int restoreIntervals = 3;       // Intervals of headroom before stepping back up
+    int maxLevel = 3;               // Deepest CaptureQuality the governor may pick
+    int reducedFramesPerSecond = 2; // Capture rate from ReducedRate on
+    int sampleStep = 8;             // Pixels between probes in Sampled
+};
+
+// Steps the governor degrades through, cheapest last
+enum class CaptureQuality {
+    Full,           // Configured rate, whole region, exact XP text read
+    ReducedRate,    // Fewer frames per second
+    BandOnly,       // Also blit only the gauge line and skip the text read
+    Sampled         // Also find a moved fill edge by probing every k-th pixel
+};
+
+inline const wchar_t* GetCaptureQualityName(CaptureQuality quality) {
+    switch (quality) {
+    case CaptureQuality::Full: return L"full";
+    case CaptureQuality::ReducedRate: return L"reduced rate";
+    case CaptureQuality::BandOnly: return L"band only";
+    case CaptureQuality::Sampled: return L"sampled";
+    }
+    return L"unknown";
+}
+
+// Keeps the capture threads within a CPU budget. Once per interval it
+// compares the CPU time they used against the wall time that passed; over
+// budget it degrades one level, and after restoreIntervals with headroom it
+// restores one. Both clocks are injected, so the policy runs unchanged
+// against fake clocks.
+class CpuGovernor {
+public:
+    using Clock = std::function<std::chrono::nanoseconds()>;
+
+    CpuGovernor(Clock cpuClock, Clock wallClock)
+        : m_cpuClock(std::move(cpuClock))
+        , m_wallClock(std::move(wallClock)) {
+    }
+
+    // Back to Full; the next Poll starts a new interval
+    void Configure(const CpuGovernorConfig& config) {
+        m_config = config;
+        if (m_config.intervalMs < 1) m_config.intervalMs = 1;
+        if (m_config.maxLevel < 0) m_config.maxLevel = 0;
+        if (m_config.maxLevel > static_cast<int>(CaptureQuality::Sampled)) {
+            m_config.maxLevel = static_cast<int>(CaptureQuality::Sampled);
+        }
+        m_level = CaptureQuality::Full;
+        m_usagePercent = 0.0f;
+        m_headroomIntervals = 0;
+        m_hasBaseline = false;
+    }
+
+    const CpuGovernorConfig& GetConfig() const { return m_config; }
+
+    // Call often; evaluates at most once per interval. True when the level changed.
+    bool Poll() {
+        if (!m_config.enabled) return false;
+
+        const std::chrono::nanoseconds wall = m_wallClock();
+        const std::chrono::nanoseconds cpu = m_cpuClock();
+        if (!m_hasBaseline) {
+            m_intervalStartWall = wall;
+            m_intervalStartCpu = cpu;
+            m_hasBaseline = true;
+            return false;
+        }
+
+        const std::chrono::nanoseconds elapsed = wall - m_intervalStartWall;
+        if (elapsed < std::chrono::milliseconds(m_config.intervalMs)) return false;
+
+        m_usagePercent = static_cast<float>((cpu - m_intervalStartCpu).count()) * 100.0f /
+            static_cast<float>(elapsed.count());
+        m_intervalStartWall = wall;
+        m_intervalStartCpu = cpu;
+        return Evaluate();
+    }
+
+    CaptureQuality GetLevel() const { return m_level; }
+
+    // Usage over the last complete interval, in percent of one core
+    float GetUsagePercent() const { return m_usagePercent; }
+
+private:
+    bool Evaluate() {
+        const int level = static_cast<int>(m_level);
+
+        if (m_usagePercent > m_config.budgetPercent) {
+            m_headroomIntervals = 0;
+            if (level >= m_config.maxLevel) return false;
+            m_level = static_cast<CaptureQuality>(level + 1);
+            return true;
+        }
+
+        // Restore only after a sustained margin, so a level that just fits
+        // the budget is not left and re-entered every interval
+        if (m_usagePercent >= m_config.budgetPercent * m_config.restoreFraction || level == 0) {
+            m_headroomIntervals = 0;
+            return false;
+        }
+        if (++m_headroomIntervals < m_config.restoreIntervals) return false;
+
+        m_headroomIntervals = 0;
+        m_level = static_cast<CaptureQuality>(level - 1);
+        return true;
+    }
+
+    Clock m_cpuClock;
+    Clock m_wallClock;
+    CpuGovernorConfig m_config{ false };
+
+    CaptureQuality m_level = CaptureQuality::Full;
+    float m_usagePercent = 0.0f;
+    int m_headroomIntervals = 0;
+    bool m_hasBaseline = false;
+    std::chrono::nanoseconds m_intervalStartWall{};
+    std::chrono::nanoseconds m_intervalStartCpu{};
+};
@@ -0,0 +1,227 @@
+#include "DigitReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DIGIT_READER_SSE2 1
+#endif
+
+namespace {
+    // Next whitespace-delimited PGM header field, skipping # comments
+    bool ReadPgmField(const uint8_t* data, size_t size, size_t& position, int& value) {
+        for (;;) {
+            while (position < size && isspace(data[position])) position++;
+            if (position < size && data[position] == '#') {
+                while (position < size && data[position] != '\n') position++;
+                continue;
+            }
+            break;
+        }
+
+        if (position >= size || !isdigit(data[position])) return false;
+        value = 0;
+        while (position < size && isdigit(data[position])) {
+            value = value * 10 + (data[position] - '0');
+            if (value > 1 << 20) return false;
+            position++;
+        }
+        return true;
+    }
+}
+
+void DigitSegmentation::Binarize(const FrameView& frame, int threshold, std::vector<uint8_t>& mask) {
+    const size_t required = static_cast<size_t>(frame.width) * frame.height;
+    if (mask.size() < required) {
+        mask.resize(required);
+    }
+
+    for (int y = 0; y < frame.height; y++) {
+        const uint8_t* row = frame.Row(y);
+        uint8_t* out = mask.data() + static_cast<size_t>(y) * frame.width;
+        for (int x = 0; x < frame.width; x++) {
+            const uint8_t* pixel = row + x * FrameView::BYTES_PER_PIXEL;
+            // BT.601 luma in 8.8 fixed point
+            const int luma = (pixel[2] * 77 + pixel[1] * 150 + pixel[0] * 29) >> 8;
+            out[x] = luma >= threshold ? 255 : 0;
+        }
+    }
+}
+
+int DigitSegmentation::FindTopRow(const uint8_t* mask, int width, int height) {
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = mask + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; x++) {
+            if (row[x]) return y;
+        }
+    }
+    return -1;
+}
+
+bool DigitTemplateSet::LoadPgm(const uint8_t* data, size_t size, const std::string& glyphs, int threshold) {
+    m_glyphs.clear();
+    m_cells.clear();
+    m_cellHeight = 0;
+    if (!data || size < 2 || data[0] != 'P' || data[1] != '5') return false;
+    if (glyphs.empty() || glyphs.size() > MAX_GLYPHS) return false;
+
+    size_t position = 2;
+    int width = 0, height = 0, maxValue = 0;
+    if (!ReadPgmField(data, size, position, width) ||
+        !ReadPgmField(data, size, position, height) ||
+        !ReadPgmField(data, size, position, maxValue)) {
+        return false;
+    }
+    position++; // Single whitespace byte before the raster
+    if (width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 255) return false;
+    if (size - position < static_cast<size_t>(width) * height) return false;
+
+    // Gray strip to the BGRX layout the segmenter reads
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * FrameView::BYTES_PER_PIXEL);
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; i++) {
+        const uint8_t gray = static_cast<uint8_t>(data[position + i] * 255 / maxValue);
+        memset(&pixels[i * FrameView::BYTES_PER_PIXEL], gray, 3);
+    }
+    FrameView frame;
+    frame.data = pixels.data();
+    frame.width = width;
+    frame.height = height;
+    frame.stride = width * FrameView::BYTES_PER_PIXEL;
+
+    std::vector<uint8_t> mask;
+    DigitSegmentation::Binarize(frame, threshold, mask);
+    const int top = DigitSegmentation::FindTopRow(mask.data(), width, height);
+    if (top < 0) return false;
+    const int cellHeight = (std::min)(height - top, MAX_CELL_HEIGHT);
+
+    std::vector<uint8_t> cells(MAX_GLYPHS * CELL_WIDTH * MAX_CELL_HEIGHT, 0);
+    size_t count = 0;
+    bool fits = true;
+    DigitSegmentation::ForEachSpan(mask.data(), width, top, cellHeight,
+        [&](const DigitSegmentation::Span& span) {
+            if (count >= glyphs.size() || span.end - span.start > CELL_WIDTH) {
+                fits = false;
+                return;
+            }
+            uint8_t* cell = cells.data() + count * CELL_WIDTH * MAX_CELL_HEIGHT;
+            for (int y = 0; y < cellHeight; y++) {
+                memcpy(cell + y * CELL_WIDTH,
+                    mask.data() + static_cast<size_t>(top + y) * width + span.start,
+                    span.end - span.start);
+            }
+            count++;
+        });
+    if (!fits || count != glyphs.size()) return false;
+
+    m_glyphs = glyphs;
+    m_cellHeight = cellHeight;
+    m_cells = std::move(cells);
+    return true;
+}
+
+XpTextReading DigitReader::ParseXpText(const std::string& text) {
+    XpTextReading reading;
+    uint64_t values[2] = { 0, 0 };
+    int digits[2] = { 0, 0 };
+    int part = 0;
+
+    for (char c : text) {
+        if (c >= '0' && c <= '9') {
+            values[part] = values[part] * 10 + (c - '0');
+            if (values[part] > UINT32_MAX) return reading;
+            digits[part]++;
+        }
+        else if (c == '/') {
+            if (part == 1) return reading;
+            part = 1;
+        }
+        else if (c != ',' && c != '.') {
+            return reading;
+        }
+    }
+
+    if (part != 1 || digits[0] == 0 || digits[1] == 0) return reading;
+    if (values[1] == 0 || values[0] > values[1]) return reading;
+
+    reading.valid = true;
+    reading.current = static_cast<uint32_t>(values[0]);
+    reading.maximum = static_cast<uint32_t>(values[1]);
+    return reading;
+}
+
+uint32_t DigitReader::SumAbsoluteDifferences(const uint8_t* a, const uint8_t* b, int rows) {
+#ifdef DIGIT_READER_SSE2
+    __m128i sum = _mm_setzero_si128();
+    for (int y = 0; y < rows; y++) {
+        const __m128i rowA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + y * DigitTemplateSet::CELL_WIDTH));
+        const __m128i rowB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + y * DigitTemplateSet::CELL_WIDTH));
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(rowA, rowB));
+    }
+    // Two partial sums, one per 8-byte half
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8)));
+#else
+    return SumAbsoluteDifferencesScalar(a, b, rows);
+#endif
+}
+
+uint32_t DigitReader::SumAbsoluteDifferencesScalar(const uint8_t* a, const uint8_t* b, int rows) {
+    uint32_t sum = 0;
+    for (int i = 0; i < rows * DigitTemplateSet::CELL_WIDTH; i++) {
+        sum += static_cast<uint32_t>(abs(a[i] - b[i]));
+    }
+    return sum;
+}
+
+XpTextReading DigitReader::Read(const FrameView& frame) {
+    m_text.clear();
+    if (!IsEnabled() || frame.IsEmpty()) return XpTextReading{};
+
+    const DigitTemplateSet& templates = *m_templates;
+    DigitSegmentation::Binarize(frame, m_config.threshold, m_mask);
+
+    const int top = DigitSegmentation::FindTopRow(m_mask.data(), frame.width, frame.height);
+    if (top < 0) return XpTextReading{};
+    const int rows = (std::min)(templates.GetCellHeight(), frame.height - top);
+    const uint32_t maxDifference = static_cast<uint32_t>(m_config.maxMismatch) * 255;
+
+    bool matched = true;
+    DigitSegmentation::ForEachSpan(m_mask.data(), frame.width, top, rows,
+        [&](const DigitSegmentation::Span& span) {
+            if (!matched) return;
+            if (span.end - span.start > DigitTemplateSet::CELL_WIDTH || m_text.size() >= MAX_TEXT_LENGTH) {
+                matched = false;
+                return;
+            }
+
+            // Left-align the glyph in a zeroed cell, as the templates are
+            memset(m_cell, 0, sizeof(m_cell));
+            for (int y = 0; y < rows; y++) {
+                memcpy(m_cell + y * DigitTemplateSet::CELL_WIDTH,
+                    m_mask.data() + static_cast<size_t>(top + y) * frame.width + span.start,
+                    span.end - span.start);
+            }
+
+            uint32_t best = UINT32_MAX;
+            size_t bestIndex = 0;
+            for (size_t i = 0; i < templates.GetCount(); i++) {
+                const uint32_t difference = SumAbsoluteDifferences(m_cell, templates.GetCell(i),
+                    templates.GetCellHeight());
+                if (difference < best) {
+                    best = difference;
+                    bestIndex = i;
+                }
+            }
+
+            if (best > maxDifference) {
+                matched = false;
+                return;
+            }
+            m_text.push_back(templates.GetGlyph(bestIndex));
+        });
+
+    if (!matched) return XpTextReading{};
+    return ParseXpText(m_text);
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FrameView.h"
+
+// Settings for DigitReader, read from the [XpText] INI section
+struct DigitReaderConfig {
+    int threshold = 128;    // Luminance at or above which a pixel is ink (0-255)
+    int maxMismatch = 24;   // Most pixels a glyph may differ from its template
+};
+
+// Binarized glyph templates cut from a strip image. The strip holds the
+// glyphs in order, separated by at least one blank column, with row 0 at
+// the top of the digits; it is segmented exactly like captured text so
+// templates and glyphs line up.
+class DigitTemplateSet {
+public:
+    static constexpr int CELL_WIDTH = 16;   // One SSE register per cell row
+    static constexpr int MAX_CELL_HEIGHT = 16;
+    static constexpr size_t MAX_GLYPHS = 16;
+
+    // Load an 8-bit binary PGM (P5) strip; glyphs names the characters in
+    // strip order, e.g. "0123456789/,". False if the strip and names disagree.
+    bool LoadPgm(const uint8_t* data, size_t size, const std::string& glyphs, int threshold);
+
+    bool IsEmpty() const { return m_glyphs.empty(); }
+    size_t GetCount() const { return m_glyphs.size(); }
+    int GetCellHeight() const { return m_cellHeight; }
+    char GetGlyph(size_t index) const { return m_glyphs[index]; }
+
+    // CELL_WIDTH x GetCellHeight() bytes, 0 or 255
+    const uint8_t* GetCell(size_t index) const {
+        return m_cells.data() + index * CELL_WIDTH * MAX_CELL_HEIGHT;
+    }
+
+private:
+    std::string m_glyphs;
+    int m_cellHeight = 0;
+    std::vector<uint8_t> m_cells;
+};
+
+// Exact XP as shown in the game's "current / max" text
+struct XpTextReading {
+    bool valid = false;
+    uint32_t current = 0;
+    uint32_t maximum = 0;
+
+    float GetPercent() const {
+        return (valid && maximum > 0) ? (current * 100.0f) / maximum : 0.0f;
+    }
+
+    bool operator==(const XpTextReading&) const = default;
+};
+
+// Reads the XP text by matching each glyph against a DigitTemplateSet with
+// sum-of-absolute-differences, one 16-byte SAD per cell row. The text is
+// capped at MAX_TEXT_LENGTH and reserved up front, and the mask only grows
+// with the text region, so steady-state reads do not allocate.
+class DigitReader {
+public:
+    // Longer than "4,294,967,295/4,294,967,295"; longer text is not XP
+    static constexpr size_t MAX_TEXT_LENGTH = 32;
+
+    DigitReader() { m_text.reserve(MAX_TEXT_LENGTH); }
+
+    void SetTemplates(std::shared_ptr<const DigitTemplateSet> templates) { m_templates = std::move(templates); }
+    void Configure(const DigitReaderConfig& config) { m_config = config; }
+
+    bool IsEnabled() const { return m_templates && !m_templates->IsEmpty(); }
+
+    // Invalid if any glyph fails to match or the text is not "current/maximum"
+    XpTextReading Read(const FrameView& frame);
+
+    // Characters recognised by the last Read, for diagnostics
+    const std::string& GetLastText() const { return m_text; }
+
+    // Count of differing bytes between two cells, divided by 255 for binarized cells.
+    // SSE2 where the target has it; the scalar version is the reference.
+    static uint32_t SumAbsoluteDifferences(const uint8_t* a, const uint8_t* b, int rows);
+    static uint32_t SumAbsoluteDifferencesScalar(const uint8_t* a, const uint8_t* b, int rows);
+
+    // Parse "current/maximum", ignoring thousands separators; invalid unless
+    // both numbers fit 32 bits and current does not exceed maximum
+    static XpTextReading ParseXpText(const std::string& text);
+
+private:
+    std::shared_ptr<const DigitTemplateSet> m_templates;
+    DigitReaderConfig m_config;
+
+    std::vector<uint8_t> m_mask;
+    std::string m_text;
+    alignas(16) uint8_t m_cell[DigitTemplateSet::CELL_WIDTH * DigitTemplateSet::MAX_CELL_HEIGHT];
+};
+
+namespace DigitSegmentation {
+    // A glyph's columns within a binarized image
+    struct Span {
+        int start;
+        int end; // One past the last column
+    };
+
+    // Luminance threshold each pixel of frame into mask (width * height, 0 or 255)
+    void Binarize(const FrameView& frame, int threshold, std::vector<uint8_t>& mask);
+
+    // First row containing ink, or -1 for a blank image
+    int FindTopRow(const uint8_t* mask, int width, int height);
+
+    // Calls onSpan(Span) for each run of inked columns in rows [top, top + rows)
+    template <typename OnSpan>
+    void ForEachSpan(const uint8_t* mask, int width, int top, int rows, OnSpan onSpan) {
+        int start = -1;
+        for (int x = 0; x <= width; x++) {
+            bool hasInk = false;
+            if (x < width) {
+                for (int y = top; y < top + rows && !hasInk; y++) {
+                    hasInk = mask[static_cast<size_t>(y) * width + x] != 0;
+                }
+            }
+            if (hasInk && start < 0) {
+                start = x;
+            }
+            else if (!hasInk && start >= 0) {
+                onSpan(Span{ start, x });
+                start = -1;
+            }
+        }
+    }
+}
@@ -0,0 +1,367 @@
+#include "FlightRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "GaugeAnalyzer.h"
+
+namespace {
+    constexpr char DUMP_MAGIC[4] = { 'P', 'X', 'F', 'R' };
+    constexpr uint32_t DUMP_VERSION = 1;
+
+    // Palette colours as stored in a dump
+    struct DumpColor {
+        uint8_t red;
+        uint8_t green;
+        uint8_t blue;
+        uint8_t reserved;
+        int32_t tolerance;
+    };
+
+    struct DumpHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t reason;
+        uint32_t frameCount;
+        int32_t orientation;
+        int32_t direction;
+        int32_t markerWidth;
+        int32_t reserved;   // Was the marker period; written as 0
+        DumpColor colors[4]; // fill, marker, filledMarker, background
+    };
+
+    DumpColor ToDump(const PaletteColor& color) {
+        return DumpColor{ color.red, color.green, color.blue, 0, color.tolerance };
+    }
+
+    PaletteColor FromDump(const DumpColor& color) {
+        return PaletteColor{ color.red, color.green, color.blue, color.tolerance };
+    }
+
+    template <typename T>
+    bool WritePod(std::ostream& out, const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        return static_cast<bool>(out);
+    }
+
+    template <typename T>
+    bool ReadPod(std::istream& in, T& value) {
+        in.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return static_cast<bool>(in);
+    }
+}
+
+const char* GetFlightFreezeReasonName(FlightFreezeReason reason) {
+    switch (reason) {
+    case FlightFreezeReason::Decrease: return "Decrease";
+    case FlightFreezeReason::Dropout: return "Dropout";
+    case FlightFreezeReason::Manual: return "Manual";
+    default: return "None";
+    }
+}
+
+void FlightRecorder::Configure(const FlightRecorderConfig& config) {
+    m_config = config;
+    if (m_config.postTriggerFrames < 0) m_config.postTriggerFrames = 0;
+    if (m_config.postTriggerFrames >= static_cast<int>(CAPACITY)) {
+        m_config.postTriggerFrames = static_cast<int>(CAPACITY) - 1;
+    }
+
+    if (m_config.enabled) {
+        m_frames.resize(CAPACITY);
+        m_lines.resize(CAPACITY * MAX_LINE_PIXELS * FrameView::BYTES_PER_PIXEL);
+    }
+    else {
+        m_frames = std::vector<FlightFrame>();
+        m_lines = std::vector<uint8_t>();
+    }
+    m_sequence = 0;
+    m_hasPrevious = false;
+    m_framesUntilFreeze = -1;
+}
+
+bool FlightRecorder::Record(const FrameView& bar, const GaugeLayout& layout, const GaugeReading& reading,
+    const SignalConditioner::Output& conditioned, const XpTextReading& exact, int32_t processUs) {
+    if (!m_config.enabled) return false;
+    if (IsFrozen()) {
+        // Whatever comes after the dump does not continue what was dumped
+        m_hasPrevious = false;
+        return false;
+    }
+
+    const size_t slot = static_cast<size_t>(m_sequence % CAPACITY);
+    FlightFrame& frame = m_frames[slot];
+    frame = FlightFrame{};
+    frame.sequence = m_sequence++;
+    frame.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    frame.processUs = processUs;
+    frame.width = bar.width;
+    frame.height = bar.height;
+    frame.rawPercent = reading.percent;
+    frame.filledPixels = reading.filledPixels;
+    frame.totalPixels = reading.totalPixels;
+    frame.conditionedPercent = conditioned.value;
+    if (conditioned.emit) frame.flags |= FlightFrame::FLAG_EMITTED;
+    if (conditioned.levelWrapped) frame.flags |= FlightFrame::FLAG_LEVEL_WRAPPED;
+    if (conditioned.wrapPending) frame.flags |= FlightFrame::FLAG_WRAP_PENDING;
+    if (exact.valid) {
+        frame.flags |= FlightFrame::FLAG_EXACT_XP;
+        frame.currentXp = exact.current;
+        frame.maximumXp = exact.maximum;
+    }
+
+    // The line the analyzer sampled, in screen order
+    if (!bar.IsEmpty()) {
+        uint8_t* line = m_lines.data() + slot * MAX_LINE_PIXELS * FrameView::BYTES_PER_PIXEL;
+        if (layout.orientation == GaugeOrientation::Horizontal) {
+            frame.lineLength = (std::min)(bar.width, MAX_LINE_PIXELS);
+            memcpy(line, bar.Row(bar.height / 2), static_cast<size_t>(frame.lineLength) * FrameView::BYTES_PER_PIXEL);
+        }
+        else {
+            frame.lineLength = (std::min)(bar.height, MAX_LINE_PIXELS);
+            for (int y = 0; y < frame.lineLength; y++) {
+                memcpy(line + static_cast<size_t>(y) * FrameView::BYTES_PER_PIXEL,
+                    bar.PixelAt(bar.width / 2, y), FrameView::BYTES_PER_PIXEL);
+            }
+        }
+    }
+
+    frame.anomaly = FindAnomaly(frame);
+    m_previous = frame;
+    m_hasPrevious = true;
+
+    if (m_manualTrigger.exchange(false, std::memory_order_relaxed)) {
+        Freeze(FlightFreezeReason::Manual);
+        return true;
+    }
+
+    // Keep recording a little past the first anomaly to see how it resolves
+    if (frame.anomaly != FlightFreezeReason::None && m_framesUntilFreeze < 0) {
+        m_framesUntilFreeze = m_config.postTriggerFrames;
+        m_pendingReason = frame.anomaly;
+    }
+    // The first frames of a new level read low before the conditioner
+    // confirms the wrap; a confirmed wrap explains the decrease, and one
+    // still being confirmed holds the freeze back
+    if (m_pendingReason == FlightFreezeReason::Decrease) {
+        if (frame.flags & FlightFrame::FLAG_LEVEL_WRAPPED) {
+            m_framesUntilFreeze = -1;
+            m_pendingReason = FlightFreezeReason::None;
+        }
+        else if (frame.flags & FlightFrame::FLAG_WRAP_PENDING) {
+            return false;
+        }
+    }
+    if (m_framesUntilFreeze >= 0 && m_framesUntilFreeze-- == 0) {
+        Freeze(m_pendingReason);
+        return true;
+    }
+    return false;
+}
+
+void FlightRecorder::BreakSequence() {
+    m_hasPrevious = false;
+    if (m_pendingReason == FlightFreezeReason::Decrease) {
+        m_framesUntilFreeze = -1;
+        m_pendingReason = FlightFreezeReason::None;
+    }
+}
+
+FlightFreezeReason FlightRecorder::FindAnomaly(const FlightFrame& frame) const {
+    if (!m_hasPrevious) return FlightFreezeReason::None;
+    const FlightFrame& previous = m_previous;
+
+    // Same region, but most of the bar no longer classifies; checked first
+    // since the reading falls with it
+    if (m_config.freezeOnDropout && frame.width == previous.width && frame.height == previous.height &&
+        previous.totalPixels > 0 && frame.totalPixels * 2 < previous.totalPixels) {
+        return FlightFreezeReason::Dropout;
+    }
+
+    if (m_config.freezeOnDecrease && !(frame.flags & FlightFrame::FLAG_LEVEL_WRAPPED)) {
+        // The conditioner holds a lower raw reading back, so compare both: a
+        // raw drop is the misread even when the overlay never showed it
+        if (frame.conditionedPercent + m_config.decreaseTolerance < previous.conditionedPercent ||
+            frame.rawPercent + m_config.decreaseTolerance < previous.rawPercent) {
+            return FlightFreezeReason::Decrease;
+        }
+        // Exact numbers going backwards within the same level
+        const uint32_t bothExact = FlightFrame::FLAG_EXACT_XP;
+        if ((frame.flags & previous.flags & bothExact) && frame.maximumXp == previous.maximumXp &&
+            frame.currentXp < previous.currentXp) {
+            return FlightFreezeReason::Decrease;
+        }
+    }
+
+    return FlightFreezeReason::None;
+}
+
+void FlightRecorder::Freeze(FlightFreezeReason reason) {
+    m_reason = reason;
+    m_framesUntilFreeze = -1;
+    m_pendingReason = FlightFreezeReason::None;
+    m_frozen.store(true, std::memory_order_release);
+}
+
+bool FlightRecorder::Write(std::ostream& out, const XpBarPalette& palette, const GaugeLayout& layout) const {
+    if (!IsFrozen()) return false;
+
+    const uint64_t count = (std::min)(m_sequence, static_cast<uint64_t>(CAPACITY));
+    DumpHeader header = {};
+    memcpy(header.magic, DUMP_MAGIC, sizeof(header.magic));
+    header.version = DUMP_VERSION;
+    header.reason = static_cast<uint32_t>(m_reason);
+    header.frameCount = static_cast<uint32_t>(count);
+    header.orientation = static_cast<int32_t>(layout.orientation);
+    header.direction = static_cast<int32_t>(layout.direction);
+    header.markerWidth = layout.markerWidth;
+    header.reserved = 0;
+    header.colors[0] = ToDump(palette.fill);
+    header.colors[1] = ToDump(palette.marker);
+    header.colors[2] = ToDump(palette.filledMarker);
+    header.colors[3] = ToDump(palette.background);
+    if (!WritePod(out, header)) return false;
+
+    for (uint64_t sequence = m_sequence - count; sequence < m_sequence; sequence++) {
+        const size_t slot = static_cast<size_t>(sequence % CAPACITY);
+        const FlightFrame& frame = m_frames[slot];
+        if (!WritePod(out, frame)) return false;
+        out.write(reinterpret_cast<const char*>(m_lines.data() + slot * MAX_LINE_PIXELS * FrameView::BYTES_PER_PIXEL),
+            static_cast<std::streamsize>(frame.lineLength) * FrameView::BYTES_PER_PIXEL);
+    }
+    return static_cast<bool>(out);
+}
+
+bool FlightRecording::Load(std::istream& in) {
+    *this = FlightRecording{};
+
+    DumpHeader header;
+    if (!ReadPod(in, header)) return false;
+    if (memcmp(header.magic, DUMP_MAGIC, sizeof(header.magic)) != 0 || header.version != DUMP_VERSION) return false;
+    if (header.frameCount > FlightRecorder::CAPACITY) return false;
+
+    reason = static_cast<FlightFreezeReason>(header.reason);
+    layout.orientation = static_cast<GaugeOrientation>(header.orientation);
+    layout.direction = static_cast<FillDirection>(header.direction);
+    layout.markerWidth = header.markerWidth;
+    palette.fill = FromDump(header.colors[0]);
+    palette.marker = FromDump(header.colors[1]);
+    palette.filledMarker = FromDump(header.colors[2]);
+    palette.background = FromDump(header.colors[3]);
+
+    for (uint32_t i = 0; i < header.frameCount; i++) {
+        FlightFrame frame;
+        if (!ReadPod(in, frame)) return false;
+        if (frame.lineLength < 0 || frame.lineLength > FlightRecorder::MAX_LINE_PIXELS) return false;
+
+        const size_t offset = lines.size();
+        lines.resize(offset + static_cast<size_t>(frame.lineLength) * FrameView::BYTES_PER_PIXEL);
+        in.read(reinterpret_cast<char*>(lines.data() + offset),
+            static_cast<std::streamsize>(frame.lineLength) * FrameView::BYTES_PER_PIXEL);
+        if (!in) return false;
+
+        frames.push_back(frame);
+        lineOffsets.push_back(offset);
+    }
+    return true;
+}
+
+FrameView FlightRecording::GetLine(size_t index) const {
+    FrameView view;
+    const FlightFrame& frame = frames[index];
+    if (frame.lineLength <= 0) return view;
+
+    view.data = lines.data() + lineOffsets[index];
+    if (layout.orientation == GaugeOrientation::Horizontal) {
+        view.width = frame.lineLength;
+        view.height = 1;
+        view.stride = frame.lineLength * FrameView::BYTES_PER_PIXEL;
+    }
+    else {
+        view.width = 1;
+        view.height = frame.lineLength;
+        view.stride = FrameView::BYTES_PER_PIXEL;
+    }
+    return view;
+}
+
+std::string FlightRecording::Replay() const {
+    std::string text;
+    char line[256];
+    snprintf(line, sizeof(line), "Frozen on %s, %zu frames\n", GetFlightFreezeReasonName(reason), frames.size());
+    text += line;
+
+    const GaugeAnalyzerEntry* analyzer = GaugeAnalyzerRegistry::Find(layout);
+    if (!analyzer) {
+        text += "No analyzer for the recorded layout\n";
+        return text;
+    }
+    PaletteClassifier classifier;
+    classifier.palette = palette;
+
+    const int64_t start = frames.empty() ? 0 : frames.front().timestampUs;
+    for (size_t i = 0; i < frames.size(); i++) {
+        const FlightFrame& frame = frames[i];
+        int frontier = 0;
+        const GaugeReading replayed = analyzer->scan(GetLine(i), classifier, frontier);
+
+        // A clipped line can't reproduce the original counts
+        const int length = layout.orientation == GaugeOrientation::Horizontal ? frame.width : frame.height;
+        const bool isClipped = frame.lineLength < length;
+        const bool isMismatch = !isClipped &&
+            (replayed.filledPixels != frame.filledPixels || replayed.totalPixels != frame.totalPixels);
+
+        snprintf(line, sizeof(line),
+            "%6llu %+9.3fs %4dx%-3d raw=%6.2f%% (%d/%d) replay=%6.2f%% shown=%6.2f%%%s exact=%u/%u %dus%s%s%s%s%s%s\n",
+            static_cast<unsigned long long>(frame.sequence), (frame.timestampUs - start) / 1e6,
+            frame.width, frame.height, frame.rawPercent, frame.filledPixels, frame.totalPixels,
+            replayed.percent, frame.conditionedPercent,
+            (frame.flags & FlightFrame::FLAG_EMITTED) ? "*" : " ",
+            frame.currentXp, frame.maximumXp, frame.processUs,
+            (frame.flags & FlightFrame::FLAG_LEVEL_WRAPPED) ? " wrap" : "",
+            (frame.flags & FlightFrame::FLAG_WRAP_PENDING) ? " wrap?" : "",
+            isClipped ? " clipped" : "",
+            isMismatch ? " MISMATCH" : "",
+            frame.anomaly != FlightFreezeReason::None ? " <- " : "",
+            frame.anomaly != FlightFreezeReason::None ? GetFlightFreezeReasonName(frame.anomaly) : "");
+        text += line;
+    }
+    return text;
+}
+
+bool FlightRecordingFiles::IsRecording(const std::filesystem::path& path) {
+    const std::string name = path.filename().string();
+    return name.size() > 12 && name.compare(0, 7, "flight-") == 0 && path.extension() == ".pxfr";
+}
+
+size_t FlightRecordingFiles::Prune(const std::filesystem::path& directory, size_t keep) {
+    struct Dump {
+        std::filesystem::file_time_type written;
+        std::filesystem::path path;
+    };
+
+    // Error codes throughout: another client may be pruning the same folder
+    std::error_code error;
+    std::vector<Dump> dumps;
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file(error) || !IsRecording(it->path())) continue;
+        const std::filesystem::file_time_type written = it->last_write_time(error);
+        if (!error) {
+            dumps.push_back(Dump{ written, it->path() });
+        }
+    }
+    if (dumps.size() <= keep) return 0;
+
+    // Newest first; names break ties within the clock's resolution
+    std::sort(dumps.begin(), dumps.end(), [](const Dump& a, const Dump& b) {
+        return a.written != b.written ? a.written > b.written : a.path > b.path;
+    });
+    size_t deleted = 0;
+    for (size_t i = keep; i < dumps.size(); i++) {
+        if (std::filesystem::remove(dumps[i].path, error)) deleted++;
+    }
+    return deleted;
+}
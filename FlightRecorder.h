@@ -0,0 +1,147 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "DigitReader.h"
+#include "FrameView.h"
+#include "GaugeLayout.h"
+#include "SignalConditioner.h"
+#include "XpBarPalette.h"
+#include "XpSample.h"
+
+// Settings for FlightRecorder, read from the [Recorder] INI section
+struct FlightRecorderConfig {
+    bool enabled = true;
+    bool freezeOnDecrease = true;   // Reading fell without a level-up
+    bool freezeOnDropout = true;    // Most of the bar stopped classifying
+    float decreaseTolerance = 0.5f; // Percent the value may fall before it counts
+    int postTriggerFrames = 8;      // Frames still recorded after an anomaly
+    int minDumpIntervalSeconds = 30; // Anomalies sooner than this after a dump are not dumped
+    int maxRecordings = 20;         // Dumps kept in the recordings folder, newest first
+};
+
+// Why a recording was frozen
+enum class FlightFreezeReason : uint32_t {
+    None,
+    Decrease,
+    Dropout,
+    Manual
+};
+
+const char* GetFlightFreezeReasonName(FlightFreezeReason reason);
+
+// One recorded frame. Fixed layout, written to dumps as is.
+struct FlightFrame {
+    static constexpr uint32_t FLAG_EMITTED = 0x1;
+    static constexpr uint32_t FLAG_LEVEL_WRAPPED = 0x2;
+    static constexpr uint32_t FLAG_EXACT_XP = 0x4;
+    static constexpr uint32_t FLAG_WRAP_PENDING = 0x8;
+
+    uint64_t sequence = 0;      // Frames recorded since the recorder was created
+    int64_t timestampUs = 0;    // Steady clock
+    int32_t processUs = 0;      // Analysis, conditioning and publishing time
+    int32_t width = 0;          // Bar region
+    int32_t height = 0;
+    int32_t lineLength = 0;     // Gauge line pixels kept, at most MAX_LINE_PIXELS
+    float rawPercent = 0.0f;
+    int32_t filledPixels = 0;
+    int32_t totalPixels = 0;
+    float conditionedPercent = 0.0f;
+    uint32_t flags = 0;
+    uint32_t currentXp = 0;
+    uint32_t maximumXp = 0;
+    FlightFreezeReason anomaly = FlightFreezeReason::None;
+};
+
+// Always-on recorder of the last CAPACITY frames of one capture: the gauge
+// line the analyzer read (the bar's middle row or column, in screen order)
+// with the readings and timings. Recording a frame is one copy of at most
+// MAX_LINE_PIXELS pixels into a preallocated ring.
+//
+// An anomaly, or Trigger() from any thread, freezes the ring: recording
+// stops, Record returns true once, and the ring may be read from another
+// thread with Write until Resume(). The capture side never blocks.
+class FlightRecorder {
+public:
+    static constexpr size_t CAPACITY = 64;
+    static constexpr int MAX_LINE_PIXELS = 2048;
+
+    // Allocates the ring when enabled; only while no frame is being recorded
+    void Configure(const FlightRecorderConfig& config);
+    bool IsEnabled() const { return m_config.enabled; }
+
+    // Capture side. Returns true when this frame froze the ring.
+    bool Record(const FrameView& bar, const GaugeLayout& layout, const GaugeReading& reading,
+        const SignalConditioner::Output& conditioned, const XpTextReading& exact, int32_t processUs);
+
+    // Capture side: the next frame does not continue the last one (new
+    // region, recalibration), so it is not compared against it, and a
+    // pending decrease can no longer turn out to be a level wrap
+    void BreakSequence();
+
+    // Any thread: freeze at the next recorded frame
+    void Trigger() { m_manualTrigger.store(true, std::memory_order_relaxed); }
+
+    bool IsFrozen() const { return m_frozen.load(std::memory_order_acquire); }
+    FlightFreezeReason GetFreezeReason() const { return m_reason; }
+
+    // While frozen: write the ring, oldest frame first, as a replayable dump
+    bool Write(std::ostream& out, const XpBarPalette& palette, const GaugeLayout& layout) const;
+
+    // Start recording again after a dump
+    void Resume() { m_frozen.store(false, std::memory_order_release); }
+
+private:
+    FlightFreezeReason FindAnomaly(const FlightFrame& frame) const;
+    void Freeze(FlightFreezeReason reason);
+
+    FlightRecorderConfig m_config{ false };
+
+    // Ring, owned by the capture side while not frozen
+    std::vector<FlightFrame> m_frames;
+    std::vector<uint8_t> m_lines;   // CAPACITY lines of MAX_LINE_PIXELS BGRX pixels
+    uint64_t m_sequence = 0;        // Also the next slot, modulo CAPACITY
+    FlightFrame m_previous;
+    bool m_hasPrevious = false;
+    int m_framesUntilFreeze = -1;   // Counting down after an anomaly
+    FlightFreezeReason m_pendingReason = FlightFreezeReason::None;
+    FlightFreezeReason m_reason = FlightFreezeReason::None;
+
+    std::atomic<bool> m_frozen{ false };
+    std::atomic<bool> m_manualTrigger{ false };
+};
+
+// A dump read back for inspection
+struct FlightRecording {
+    FlightFreezeReason reason = FlightFreezeReason::None;
+    XpBarPalette palette;
+    GaugeLayout layout;
+    std::vector<FlightFrame> frames;
+    std::vector<uint8_t> lines;     // Each frame's line, concatenated
+    std::vector<size_t> lineOffsets;
+
+    bool Load(std::istream& in);
+
+    // A frame's line as an image the analyzer reads exactly as it read the
+    // original bar: one row for a horizontal gauge, one column for a vertical one
+    FrameView GetLine(size_t index) const;
+
+    // Re-analyze every line with the recorded palette and layout; one line
+    // per frame, flagging anomalies and frames whose reading differs
+    std::string Replay() const;
+};
+
+namespace FlightRecordingFiles {
+    // Dumps are named flight-<local time>-<count>.pxfr
+    bool IsRecording(const std::filesystem::path& path);
+
+    // Delete all but the newest keep dumps in directory, by write time;
+    // other files are left alone. Returns how many were deleted.
+    size_t Prune(const std::filesystem::path& directory, size_t keep);
+}
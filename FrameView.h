@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// Pixel layouts a FrameView can describe. GDI DIB sections are BGRX.
+enum class PixelFormat {
+    BGRX32,
+    BGRA32
+};
+
+// Non-owning view over a block of 32-bit pixels. Rows are `stride` bytes apart,
+// so padded buffers and sub-rectangles can be analyzed without copying.
+struct FrameView {
+    const uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0; // Bytes from the start of one row to the next
+    PixelFormat format = PixelFormat::BGRX32;
+
+    static constexpr int BYTES_PER_PIXEL = 4;
+
+    bool IsEmpty() const {
+        return !data || width <= 0 || height <= 0;
+    }
+
+    const uint8_t* Row(int y) const {
+        return data + static_cast<ptrdiff_t>(y) * stride;
+    }
+
+    const uint8_t* PixelAt(int x, int y) const {
+        return Row(y) + static_cast<ptrdiff_t>(x) * BYTES_PER_PIXEL;
+    }
+
+    // View of a sub-rectangle, clamped to this view's bounds
+    FrameView SubView(int x, int y, int subWidth, int subHeight) const {
+        x = std::clamp(x, 0, width);
+        y = std::clamp(y, 0, height);
+        subWidth = std::clamp(subWidth, 0, width - x);
+        subHeight = std::clamp(subHeight, 0, height - y);
+
+        FrameView view = *this;
+        view.data = (subWidth > 0 && subHeight > 0) ? PixelAt(x, y) : nullptr;
+        view.width = subWidth;
+        view.height = subHeight;
+        return view;
+    }
+};
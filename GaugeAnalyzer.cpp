@@ -0,0 +1,46 @@
+#include "GaugeAnalyzer.h"
+
+namespace {
+    template <GaugeOrientation Orientation, FillDirection Direction, int MarkerWidth>
+    constexpr GaugeAnalyzerEntry MakeEntry() {
+        using Analyzer = GaugeAnalyzer<Orientation, Direction, MarkerWidth, PaletteClassifier>;
+        return GaugeAnalyzerEntry{
+            GaugeLayout{ Orientation, Direction, MarkerWidth },
+            &Analyzer::Scan,
+            &Analyzer::IsFillEdgeAt,
+            &Analyzer::AdvanceFillEdge
+        };
+    }
+
+    constexpr auto H = GaugeOrientation::Horizontal;
+    constexpr auto V = GaugeOrientation::Vertical;
+    constexpr auto F = FillDirection::Forward;
+    constexpr auto R = FillDirection::Reverse;
+
+    // Every layout a config entry may select. Add a line here to support a
+    // new bar type.
+    constexpr GaugeAnalyzerEntry ENTRIES[] = {
+        // XP bar and other segmented horizontal bars
+        MakeEntry<H, F, 4>(),
+        MakeEntry<H, R, 4>(),
+        MakeEntry<H, F, 2>(),
+        MakeEntry<H, R, 2>(),
+
+        // Plain horizontal bars (cast bars)
+        MakeEntry<H, F, 0>(),
+        MakeEntry<H, R, 0>(),
+
+        // Vertical resource globes, usually filling bottom-up
+        MakeEntry<V, R, 0>(),
+        MakeEntry<V, F, 0>(),
+        MakeEntry<V, R, 4>(),
+        MakeEntry<V, F, 4>(),
+    };
+}
+
+const GaugeAnalyzerEntry* GaugeAnalyzerRegistry::Find(const GaugeLayout& layout) {
+    for (const auto& entry : ENTRIES) {
+        if (entry.layout == layout) return &entry;
+    }
+    return nullptr;
+}
@@ -0,0 +1,274 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "FrameView.h"
+#include "GaugeLayout.h"
+#include "XpBarPalette.h"
+#include "XpSample.h"
+
+// Compile-time specialized gauge analyzers. Orientation, fill direction,
+// marker geometry and the pixel classifier are template parameters, so each
+// configuration gets its own loop with the pixel step and marker handling
+// resolved by the compiler. GaugeAnalyzerRegistry maps a runtime
+// GaugeLayout to one of the pre-instantiated specializations.
+
+enum class PixelClass : uint8_t {
+    Other,
+    Background,
+    Fill,
+    Marker,
+    FilledMarker
+};
+
+// Classifies BGRX pixels against an XpBarPalette. Every colour is tested
+// and the match with the highest priority (fill, filled marker, marker,
+// background) is selected with masks, so the analyzer loops take no branch
+// on pixel data.
+struct PaletteClassifier {
+    XpBarPalette palette;
+
+    PixelClass Classify(const uint8_t* pixel) const {
+        const uint32_t blue = pixel[0];
+        const uint32_t green = pixel[1];
+        const uint32_t red = pixel[2];
+
+        // Lowest priority first; each match overrides the ones before it
+        uint32_t pixelClass = static_cast<uint32_t>(PixelClass::Other);
+        pixelClass = Select(pixelClass, PixelClass::Background, Matches(palette.background, red, green, blue));
+        pixelClass = Select(pixelClass, PixelClass::Marker, Matches(palette.marker, red, green, blue));
+        pixelClass = Select(pixelClass, PixelClass::FilledMarker, Matches(palette.filledMarker, red, green, blue));
+        pixelClass = Select(pixelClass, PixelClass::Fill, Matches(palette.fill, red, green, blue));
+        return static_cast<PixelClass>(pixelClass);
+    }
+
+private:
+    // 1 if value is within tolerance of reference: |value - reference| <= tolerance
+    // folds into one unsigned compare of value - reference + tolerance against 2 * tolerance
+    static uint32_t IsWithin(uint32_t value, uint32_t reference, uint32_t tolerance) {
+        return static_cast<uint32_t>(value - reference + tolerance <= 2 * tolerance);
+    }
+
+    // PaletteColor::Matches as 0 or 1; a negative tolerance matches nothing
+    static uint32_t Matches(const PaletteColor& color, uint32_t red, uint32_t green, uint32_t blue) {
+        const uint32_t tolerance = static_cast<uint32_t>(color.tolerance);
+        return static_cast<uint32_t>(color.tolerance >= 0) &
+            IsWithin(red, color.red, tolerance) &
+            IsWithin(green, color.green, tolerance) &
+            IsWithin(blue, color.blue, tolerance);
+    }
+
+    // choice if match is 1, current if it is 0
+    static uint32_t Select(uint32_t current, PixelClass choice, uint32_t match) {
+        return current ^ ((current ^ static_cast<uint32_t>(choice)) & (0u - match));
+    }
+};
+
+// The line of pixels a gauge is sampled along: the middle row of a
+// horizontal gauge or the middle column of a vertical one, walked in fill
+// order. Index 0 is where the fill starts.
+template <GaugeOrientation Orientation, FillDirection Direction>
+struct GaugeLine {
+    const uint8_t* origin = nullptr;
+    ptrdiff_t stride = 0;
+    int length = 0;
+
+    explicit GaugeLine(const FrameView& frame) {
+        if constexpr (Orientation == GaugeOrientation::Horizontal) {
+            origin = frame.Row(frame.height / 2);
+            length = frame.width;
+        }
+        else {
+            origin = frame.PixelAt(frame.width / 2, 0);
+            stride = frame.stride;
+            length = frame.height;
+        }
+    }
+
+    const uint8_t* At(int index) const {
+        const int offset = (Direction == FillDirection::Forward) ? index : length - 1 - index;
+        if constexpr (Orientation == GaugeOrientation::Horizontal) {
+            return origin + static_cast<ptrdiff_t>(offset) * FrameView::BYTES_PER_PIXEL;
+        }
+        else {
+            return origin + static_cast<ptrdiff_t>(offset) * stride;
+        }
+    }
+};
+
+inline int GetGaugeLength(const GaugeLayout& layout, int width, int height) {
+    return layout.orientation == GaugeOrientation::Horizontal ? width : height;
+}
+
+template <GaugeOrientation Orientation, FillDirection Direction,
+    int MarkerWidth, typename Classifier>
+class GaugeAnalyzer {
+public:
+    using Line = GaugeLine<Orientation, Direction>;
+
+    // Count filled and total bar pixels along the line. frontier receives the
+    // index just past the last filled pixel. One pass that takes no branch
+    // on pixel data: every pixel is classified and the counts, the frontier
+    // and the marker run state are updated with masks.
+    //
+    // A marker is a run of MarkerWidth marker coloured pixels, found
+    // greedily from the start of the line. It counts as filled if it shows
+    // the filled marker colour or the fill continues on both sides of it;
+    // whether the fill continues after it is only known at the next pixel.
+    // Shorter runs are plain unfilled bar.
+    static GaugeReading Scan(const FrameView& frame, const Classifier& classifier, int& frontier) {
+        GaugeReading reading;
+        frontier = 0;
+        if (frame.IsEmpty()) return reading;
+
+        const Line line(frame);
+        uint32_t filledPixels = 0;
+        uint32_t totalPixels = 0;
+        int edge = 0;
+
+        // Marker run state; all 0 or 1 except runLength
+        int runLength = 0;
+        uint32_t isFillBeforeRun = 0;
+        uint32_t runHasFilledMarker = 0;
+        uint32_t isPrevFill = 0;
+        uint32_t isMarkerPending = 0;   // A marker ended on the previous pixel
+        uint32_t isPendingFilled = 0;   // ...showing the filled marker colour
+        uint32_t isPendingFillBefore = 0; // ...with fill before it
+
+        for (int i = 0; i < line.length; i++) {
+            const PixelClass pixelClass = classifier.Classify(line.At(i));
+
+            // Pixels that aren't part of the bar (text, glow, occlusion) count nowhere
+            const uint32_t isFill = pixelClass == PixelClass::Fill;
+            filledPixels += isFill;
+            totalPixels += pixelClass != PixelClass::Other;
+            edge = Select(edge, i + 1, isFill);
+
+            if constexpr (MarkerWidth > 0) {
+                // Settle the marker that ended on the previous pixel; its
+                // pixels are already in the total
+                const uint32_t isPendingCounted = isMarkerPending &
+                    (isPendingFilled | (isPendingFillBefore & isFill));
+                filledPixels += MarkerWidth & (0u - isPendingCounted);
+
+                const uint32_t isMarker = IsMarkerClass(pixelClass);
+                const uint32_t continuesRun = isMarker & static_cast<uint32_t>(runLength != 0);
+                isFillBeforeRun = Select(isPrevFill, isFillBeforeRun, continuesRun);
+                runHasFilledMarker = (runHasFilledMarker & continuesRun) |
+                    static_cast<uint32_t>(pixelClass == PixelClass::FilledMarker);
+                runLength = (runLength + 1) & -static_cast<int>(isMarker);
+
+                const uint32_t isRunComplete = runLength == MarkerWidth;
+                runLength = Select(runLength, 0, isRunComplete);
+                isMarkerPending = isRunComplete;
+                isPendingFilled = runHasFilledMarker;
+                isPendingFillBefore = isFillBeforeRun;
+                edge = Select(edge, i + 1, isRunComplete & runHasFilledMarker);
+            }
+            isPrevFill = isFill;
+        }
+
+        if constexpr (MarkerWidth > 0) {
+            // A marker at the very end has no fill after it
+            filledPixels += MarkerWidth & (0u - (isMarkerPending & isPendingFilled));
+        }
+
+        frontier = edge;
+        reading.filledPixels = static_cast<int>(filledPixels);
+        reading.totalPixels = static_cast<int>(totalPixels);
+        if (totalPixels > 0) {
+            reading.percent = (filledPixels * 100.0f) / totalPixels;
+        }
+        return reading;
+    }
+
+    // Whether the fill edge is still at frontier: filled before it, unfilled
+    // bar at it. Used to skip a full scan when nothing moved.
+    static bool IsFillEdgeAt(const FrameView& frame, const Classifier& classifier, int frontier) {
+        if (frame.IsEmpty()) return false;
+
+        const Line line(frame);
+        if (frontier < 0 || frontier > line.length) return false;
+
+        if (frontier > 0) {
+            const PixelClass before = classifier.Classify(line.At(frontier - 1));
+            if (before != PixelClass::Fill && before != PixelClass::FilledMarker) return false;
+        }
+
+        if (frontier < line.length) {
+            const PixelClass at = classifier.Classify(line.At(frontier));
+            if (at != PixelClass::Background && at != PixelClass::Marker) return false;
+        }
+
+        return true;
+    }
+
+    // Find where the fill edge moved to from frontier by probing every step
+    // pixels, then refining within the last step. Only handles the edge
+    // moving forward: the pixels between probes are not classified and are
+    // taken as filled bar, so the caller adds frontier's advance to its
+    // filled count. Returns false (and leaves frontier alone) when a probe
+    // is neither fill nor background or the edge moved back; the caller
+    // then scans in full.
+    static bool AdvanceFillEdge(const FrameView& frame, const Classifier& classifier, int step, int& frontier) {
+        if (frame.IsEmpty() || step < 1) return false;
+
+        const Line line(frame);
+        if (frontier < 1 || frontier > line.length) return false;
+        if (!IsFilledClass(classifier.Classify(line.At(frontier - 1)))) return false;
+
+        // Coarse: the last probe known to be filled
+        int filled = frontier - 1;
+        for (int probe = filled + step; probe < line.length; probe += step) {
+            const PixelClass pixelClass = classifier.Classify(line.At(probe));
+            if (pixelClass == PixelClass::Background) break;
+            if (!IsFilledClass(pixelClass)) return false;
+            filled = probe;
+        }
+
+        // Fine: walk to the first unfilled pixel, which must be bar
+        int edge = filled + 1;
+        while (edge < line.length && IsFilledClass(classifier.Classify(line.At(edge)))) {
+            edge++;
+        }
+        if (edge < line.length && classifier.Classify(line.At(edge)) != PixelClass::Background) return false;
+
+        frontier = edge;
+        return true;
+    }
+
+private:
+    static bool IsFilledClass(PixelClass pixelClass) {
+        return pixelClass == PixelClass::Fill || pixelClass == PixelClass::FilledMarker;
+    }
+
+    // 1 for Marker and FilledMarker, without a branch
+    static uint32_t IsMarkerClass(PixelClass pixelClass) {
+        return static_cast<uint32_t>(pixelClass == PixelClass::Marker) |
+            static_cast<uint32_t>(pixelClass == PixelClass::FilledMarker);
+    }
+
+    // choice if condition is 1, current if it is 0
+    static int Select(int current, int choice, uint32_t condition) {
+        return current ^ ((current ^ choice) & -static_cast<int>(condition));
+    }
+
+    static uint32_t Select(uint32_t current, uint32_t choice, uint32_t condition) {
+        return current ^ ((current ^ choice) & (0u - condition));
+    }
+};
+
+// One pre-instantiated analyzer
+struct GaugeAnalyzerEntry {
+    GaugeLayout layout;
+    GaugeReading (*scan)(const FrameView& frame, const PaletteClassifier& classifier, int& frontier);
+    bool (*isFillEdgeAt)(const FrameView& frame, const PaletteClassifier& classifier, int frontier);
+    bool (*advanceFillEdge)(const FrameView& frame, const PaletteClassifier& classifier, int step, int& frontier);
+};
+
+class GaugeAnalyzerRegistry {
+public:
+    // Specialization for a layout, or nullptr if that combination was not
+    // instantiated (see GaugeAnalyzer.cpp)
+    static const GaugeAnalyzerEntry* Find(const GaugeLayout& layout);
+};
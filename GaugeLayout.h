@@ -0,0 +1,22 @@
+#pragma once
+
+enum class GaugeOrientation {
+    Horizontal,
+    Vertical
+};
+
+// Forward fills left-to-right or top-to-bottom; Reverse the opposite way
+enum class FillDirection {
+    Forward,
+    Reverse
+};
+
+// Geometry of a gauge, read from the [Gauge] INI section. Each supported
+// combination maps to a compile-time specialized analyzer.
+struct GaugeLayout {
+    GaugeOrientation orientation = GaugeOrientation::Horizontal;
+    FillDirection direction = FillDirection::Forward;
+    int markerWidth = 4;  // Width of the divider markers, 0 if the gauge has none
+
+    bool operator==(const GaugeLayout&) const = default;
+};
@@ -0,0 +1,111 @@
+#include "GaugePipeline.h"
+
+#include <chrono>
+
+GaugePipeline::GaugePipeline()
+    : m_analyzer(GaugeAnalyzerRegistry::Find(GaugeLayout{}))
+    , m_sampleStep(1)
+    , m_sampleSequence(0) {
+    m_recorder.Configure(FlightRecorderConfig{});
+}
+
+bool GaugePipeline::OpenChannel(const char* name) {
+    return m_sampleWriter.Open(name);
+}
+
+bool GaugePipeline::SetGaugeLayout(const GaugeLayout& layout) {
+    const GaugeAnalyzerEntry* analyzer = GaugeAnalyzerRegistry::Find(layout);
+    if (!analyzer) return false;
+
+    m_layout = layout;
+    m_analyzer = analyzer;
+    return true;
+}
+
+GaugePipeline::Result GaugePipeline::Process(const FrameView& bar, const FrameView& text) {
+    Result result;
+    const auto start = std::chrono::steady_clock::now();
+
+    // Analyze the captured region, then filter out flicker
+    m_lastReading = AnalyzeRegion(bar);
+    result.conditioned = m_conditioner.Process(m_lastReading.percent, m_lastReading.totalPixels);
+
+    // The exact numbers need no filtering; a misread glyph invalidates the read
+    if (m_digitReader.IsEnabled() && !text.IsEmpty()) {
+        result.exact = m_digitReader.Read(text);
+    }
+
+    result.emit = result.conditioned.emit || (result.exact.valid && !(result.exact == m_lastExact));
+    if (result.exact.valid) {
+        m_lastExact = result.exact;
+    }
+
+    PublishSample(m_lastReading, result);
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    result.recorderFrozen = m_recorder.Record(bar, m_layout, m_lastReading, result.conditioned,
+        result.exact, static_cast<int32_t>(elapsed.count()));
+    return result;
+}
+
+void GaugePipeline::PublishSample(const GaugeReading& reading, const Result& result) {
+    const SignalConditioner::Output& conditioned = result.conditioned;
+    XpSample sample;
+    sample.sequence = ++m_sampleSequence;
+    sample.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    sample.percent = conditioned.value;
+    sample.filledPixels = static_cast<uint32_t>(reading.filledPixels);
+    sample.totalPixels = static_cast<uint32_t>(reading.totalPixels);
+    if (conditioned.levelWrapped) {
+        sample.flags |= XpSample::FLAG_LEVEL_WRAPPED;
+    }
+    if (result.exact.valid) {
+        sample.flags |= XpSample::FLAG_EXACT_XP;
+        sample.currentXp = result.exact.current;
+        sample.maximumXp = result.exact.maximum;
+    }
+
+    m_sampleWriter.Publish(sample);
+}
+
+GaugeReading GaugePipeline::AnalyzeRegion(const FrameView& frame) {
+    if (frame.IsEmpty()) return GaugeReading{};
+
+    // Incremental path: XP only moves the fill edge, so if the edge is still
+    // where the last full scan found it the counts have not changed
+    const int length = GetGaugeLength(m_layout, frame.width, frame.height);
+    const bool isWarm = m_warmState.Matches(length, m_classifier.palette, m_layout);
+    if (isWarm && m_analyzer->isFillEdgeAt(frame, m_classifier, m_warmState.frontier)) {
+        return m_warmState.reading;
+    }
+
+    // Sampled path, when the CPU governor asks for it: probe for an edge
+    // that moved forward and count what it passed as filled
+    if (isWarm && m_sampleStep > 1) {
+        int frontier = m_warmState.frontier;
+        if (m_analyzer->advanceFillEdge(frame, m_classifier, m_sampleStep, frontier)) {
+            GaugeReading& reading = m_warmState.reading;
+            reading.filledPixels += frontier - m_warmState.frontier;
+            if (reading.filledPixels > reading.totalPixels) reading.filledPixels = reading.totalPixels;
+            if (reading.totalPixels > 0) {
+                reading.percent = (reading.filledPixels * 100.0f) / reading.totalPixels;
+            }
+            m_warmState.frontier = frontier;
+            return reading;
+        }
+    }
+
+    int frontier = 0;
+    GaugeReading reading = m_analyzer->scan(frame, m_classifier, frontier);
+
+    m_warmState.valid = true;
+    m_warmState.reading = reading;
+    m_warmState.frontier = frontier;
+    m_warmState.gaugeLength = length;
+    m_warmState.palette = m_classifier.palette;
+    m_warmState.layout = m_layout;
+
+    return reading;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+#include "DigitReader.h"
+#include "FlightRecorder.h"
+#include "FrameView.h"
+#include "GaugeAnalyzer.h"
+#include "GaugeLayout.h"
+#include "SharedSampleChannel.h"
+#include "SignalConditioner.h"
+#include "WarmState.h"
+#include "XpBarPalette.h"
+#include "XpSample.h"
+
+// Everything that happens to a captured frame after the blit: analysis
+// (with the incremental warm-state path), the optional exact XP text read,
+// conditioning, publishing and the flight recorder.
+// Platform independent, so the same code runs in the overlay and in the
+// soak harness.
+class GaugePipeline {
+public:
+    struct Result {
+        SignalConditioner::Output conditioned;
+        XpTextReading exact;    // Valid only when the XP text was read
+        bool emit = false;      // Conditioned value or exact XP changed
+        bool recorderFrozen = false; // This frame froze the flight recorder
+    };
+
+    GaugePipeline();
+
+    // Publishing is best effort; returns false if the channel could not be opened
+    bool OpenChannel(const char* name);
+
+    // Configuration; only change while no frame is being processed
+    void SetPalette(const XpBarPalette& palette) { m_classifier.palette = palette; }
+    bool SetGaugeLayout(const GaugeLayout& layout);
+    const GaugeLayout& GetGaugeLayout() const { return m_layout; }
+    void SetConditionerConfig(const SignalConditionerConfig& config) { m_conditioner.Configure(config); }
+    void SetDigitTemplates(std::shared_ptr<const DigitTemplateSet> templates) { m_digitReader.SetTemplates(std::move(templates)); }
+    void SetDigitReaderConfig(const DigitReaderConfig& config) { m_digitReader.Configure(config); }
+    void SetRecorderConfig(const FlightRecorderConfig& config) { m_recorder.Configure(config); }
+
+    // Pixels between probes when the fill edge moved; 1 scans the line in full
+    void SetSampleStep(int step) { m_sampleStep = step > 1 ? step : 1; }
+
+    const AnalyzerWarmState& GetWarmState() const { return m_warmState; }
+    void SetWarmState(const AnalyzerWarmState& state) { m_warmState = state; }
+    void ResetWarmState() { m_warmState = AnalyzerWarmState{}; }
+
+    // Forget filter history, e.g. when the region changes
+    void ResetConditioner() {
+        m_conditioner.Reset();
+        m_lastExact = XpTextReading{};
+        m_recorder.BreakSequence();
+    }
+
+    // Analyze, condition and publish one frame. text is the XP text crop
+    // from the same capture, or an empty view to skip the exact read.
+    Result Process(const FrameView& bar, const FrameView& text = FrameView{});
+
+    const GaugeReading& GetLastReading() const { return m_lastReading; }
+
+    // Trigger and Resume may be called from any thread
+    FlightRecorder& GetRecorder() { return m_recorder; }
+
+    // While the recorder is frozen: dump it with this pipeline's palette and layout
+    bool WriteRecording(std::ostream& out) const { return m_recorder.Write(out, m_classifier.palette, m_layout); }
+
+private:
+    GaugeReading AnalyzeRegion(const FrameView& frame);
+    void PublishSample(const GaugeReading& reading, const Result& result);
+
+    PaletteClassifier m_classifier;
+    GaugeLayout m_layout;
+    const GaugeAnalyzerEntry* m_analyzer;
+    AnalyzerWarmState m_warmState;
+    int m_sampleStep;
+    SignalConditioner m_conditioner;
+    GaugeReading m_lastReading;
+    DigitReader m_digitReader;
+    XpTextReading m_lastExact;
+    FlightRecorder m_recorder;
+
+    SharedSampleWriter m_sampleWriter;
+    uint64_t m_sampleSequence;
+};
@@ -0,0 +1,93 @@
+#include "GdiCapture.h"
+
+GdiCaptureDevice::GdiCaptureDevice()
+    : m_screenDC(nullptr)
+    , m_memoryDC(nullptr) {
+}
+
+GdiCaptureDevice::~GdiCaptureDevice() {
+    Close();
+}
+
+bool GdiCaptureDevice::Open() {
+    // Get screen DC
+    m_screenDC = GetDC(nullptr);
+    if (!m_screenDC) return false;
+
+    // Create compatible DC
+    m_memoryDC = CreateCompatibleDC(m_screenDC);
+    if (!m_memoryDC) {
+        ReleaseDC(nullptr, m_screenDC);
+        m_screenDC = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void GdiCaptureDevice::Close() {
+    if (m_memoryDC) {
+        DeleteDC(m_memoryDC);
+        m_memoryDC = nullptr;
+    }
+
+    if (m_screenDC) {
+        ReleaseDC(nullptr, m_screenDC);
+        m_screenDC = nullptr;
+    }
+}
+
+bool GdiCaptureDevice::CreateBitmap(CaptureBuffer& buffer, int width, int height) {
+    return CreateDibSection(m_memoryDC, buffer, width, height);
+}
+
+void GdiCaptureDevice::DestroyBitmap(CaptureBuffer& buffer) {
+    DestroyDibSection(buffer);
+}
+
+bool GdiCaptureDevice::Blit(const CaptureBuffer& buffer, const CaptureRect& region) {
+    // Select bitmap into DC
+    HGDIOBJ oldBitmap = SelectObject(m_memoryDC, static_cast<HBITMAP>(buffer.bitmap));
+
+    // Capture screen region into the top-left corner of the buffer
+    const BOOL copied = BitBlt(m_memoryDC, 0, 0,
+        region.right - region.left, region.bottom - region.top,
+        m_screenDC,
+        region.left, region.top,
+        SRCCOPY);
+
+    // Cleanup
+    SelectObject(m_memoryDC, oldBitmap);
+    return copied != FALSE;
+}
+
+bool GdiCaptureDevice::CreateDibSection(HDC referenceDC, CaptureBuffer& buffer, int width, int height) {
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height; // Top-down
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    BYTE* bits = nullptr;
+    HBITMAP bitmap = CreateDIBSection(referenceDC, &bmi, DIB_RGB_COLORS,
+        reinterpret_cast<void**>(&bits), nullptr, 0);
+    if (!bitmap) {
+        buffer = CaptureBuffer{};
+        return false;
+    }
+
+    buffer.bitmap = bitmap;
+    buffer.bits = bits;
+    buffer.capacityWidth = width;
+    buffer.capacityHeight = height;
+    return true;
+}
+
+void GdiCaptureDevice::DestroyDibSection(CaptureBuffer& buffer) {
+    if (buffer.bitmap) {
+        DeleteObject(static_cast<HBITMAP>(buffer.bitmap));
+    }
+    buffer = CaptureBuffer{};
+}
@@ -0,0 +1,48 @@
+#define WM_USER_XP_UPDATE (WM_USER + 1)
+#define WM_USER_CAPTURE_FAILED (WM_USER + 2)
+#define WM_USER_RECORDER_FROZEN (WM_USER + 3)
+
+#pragma once
+#include <windows.h>
+
+#include "CaptureDevice.h"
+#include "CaptureSystem.h"
+
+// Captures the screen with GDI: DIB section bitmaps selected into a memory
+// DC and filled by BitBlt from the screen DC
+class GdiCaptureDevice : public CaptureDevice {
+public:
+    GdiCaptureDevice();
+    ~GdiCaptureDevice() override;
+
+    bool Open() override;
+    void Close() override;
+    bool CreateBitmap(CaptureBuffer& buffer, int width, int height) override;
+    void DestroyBitmap(CaptureBuffer& buffer) override;
+    bool Blit(const CaptureBuffer& buffer, const CaptureRect& region) override;
+
+    // Top-down 32-bit DIB section; referenceDC may be null
+    static bool CreateDibSection(HDC referenceDC, CaptureBuffer& buffer, int width, int height);
+    static void DestroyDibSection(CaptureBuffer& buffer);
+
+private:
+    HDC m_screenDC;
+    HDC m_memoryDC;
+};
+
+// Announces capture results to an overlay window with the WM_USER_*
+// messages above; the window reads the value from GetDisplay
+class WindowCaptureSink : public CaptureSink {
+public:
+    explicit WindowCaptureSink(HWND window) : m_window(window) {}
+
+    // wParam carries the value in hundredths of a percent for the history graph
+    void OnXpUpdate(float percent) override {
+        PostMessage(m_window, WM_USER_XP_UPDATE, static_cast<WPARAM>(percent * 100.0f + 0.5f), 0);
+    }
+    void OnCaptureFailed() override { PostMessage(m_window, WM_USER_CAPTURE_FAILED, 0, 0); }
+    void OnRecorderFrozen() override { PostMessage(m_window, WM_USER_RECORDER_FROZEN, 0, 0); }
+
+private:
+    HWND m_window;
+};
@@ -0,0 +1,225 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cwctype>
+#include <string_view>
+
+// Portable hotkey core: the binding table, string parsing and dispatch.
+// Nothing here touches Win32, so it can be exercised on any platform;
+// HotkeyManager wires it to RegisterHotKey/WM_HOTKEY.
+
+enum class HotkeyAction : uint8_t {
+    None = 0,
+    ToggleClickthrough,
+    ToggleCapturePause,
+    Recalibrate,
+    ToggleHud,
+    DumpRecorder,
+    Count
+};
+
+// Modifier bits, identical to the Win32 MOD_* values
+namespace HotkeyModifier {
+    constexpr uint32_t Alt = 0x0001;
+    constexpr uint32_t Control = 0x0002;
+    constexpr uint32_t Shift = 0x0004;
+    constexpr uint32_t Win = 0x0008;
+}
+
+struct HotkeyBinding {
+    uint32_t modifiers = 0;
+    uint32_t virtualKey = 0;
+    HotkeyAction action = HotkeyAction::None;
+};
+
+inline const wchar_t* GetHotkeyActionName(HotkeyAction action) {
+    switch (action) {
+    case HotkeyAction::ToggleClickthrough: return L"ToggleClickthrough";
+    case HotkeyAction::ToggleCapturePause: return L"ToggleCapturePause";
+    case HotkeyAction::Recalibrate: return L"Recalibrate";
+    case HotkeyAction::ToggleHud: return L"ToggleHud";
+    case HotkeyAction::DumpRecorder: return L"DumpRecorder";
+    default: return L"None";
+    }
+}
+
+// Binding used when the config has no entry for an action. System hotkeys
+// take their keys from every other application, the game included, so
+// every default needs modifiers. Configs written before this keep their
+// bare F7 until the entry is edited.
+inline const wchar_t* GetDefaultHotkey(HotkeyAction action) {
+    switch (action) {
+    case HotkeyAction::ToggleClickthrough: return L"Ctrl+Shift+F7";
+    case HotkeyAction::ToggleCapturePause: return L"Ctrl+Shift+F8";
+    case HotkeyAction::Recalibrate: return L"Ctrl+Shift+F9";
+    case HotkeyAction::ToggleHud: return L"Ctrl+Shift+F6";
+    case HotkeyAction::DumpRecorder: return L"Ctrl+Shift+F10";
+    default: return L"";
+    }
+}
+
+namespace HotkeyParser {
+    inline bool EqualsNoCase(std::wstring_view a, std::wstring_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (std::towupper(a[i]) != std::towupper(b[i])) return false;
+        }
+        return true;
+    }
+
+    // Map a key name ("F7", "A", "5") to its virtual-key code, 0 if unknown
+    inline uint32_t ParseKeyName(std::wstring_view name) {
+        if (name.size() == 1) {
+            wchar_t c = static_cast<wchar_t>(std::towupper(name[0]));
+            if ((c >= L'A' && c <= L'Z') || (c >= L'0' && c <= L'9')) {
+                return static_cast<uint32_t>(c); // VK codes match ASCII here
+            }
+            return 0;
+        }
+
+        if (name.size() <= 3 && std::towupper(name[0]) == L'F') {
+            uint32_t number = 0;
+            for (size_t i = 1; i < name.size(); i++) {
+                if (name[i] < L'0' || name[i] > L'9') return 0;
+                number = number * 10 + (name[i] - L'0');
+            }
+            if (number >= 1 && number <= 24) {
+                return 0x70 + (number - 1); // VK_F1..VK_F24
+            }
+            return 0;
+        }
+
+        if (EqualsNoCase(name, L"Pause")) return 0x13;
+        if (EqualsNoCase(name, L"Insert")) return 0x2D;
+        if (EqualsNoCase(name, L"Home")) return 0x24;
+        if (EqualsNoCase(name, L"End")) return 0x23;
+        if (EqualsNoCase(name, L"PageUp")) return 0x21;
+        if (EqualsNoCase(name, L"PageDown")) return 0x22;
+        return 0;
+    }
+
+    // Parse "Ctrl+Shift+F7" style text. Returns false for empty or
+    // malformed text, which leaves the action unbound.
+    inline bool Parse(std::wstring_view text, uint32_t& modifiers, uint32_t& virtualKey) {
+        modifiers = 0;
+        virtualKey = 0;
+
+        while (!text.empty()) {
+            size_t plus = text.find(L'+');
+            std::wstring_view token = text.substr(0, plus);
+            text = (plus == std::wstring_view::npos) ? std::wstring_view() : text.substr(plus + 1);
+            if (plus != std::wstring_view::npos && text.empty()) return false; // Trailing '+'
+
+            while (!token.empty() && token.front() == L' ') token.remove_prefix(1);
+            while (!token.empty() && token.back() == L' ') token.remove_suffix(1);
+            if (token.empty()) return false;
+
+            if (EqualsNoCase(token, L"Ctrl") || EqualsNoCase(token, L"Control")) {
+                modifiers |= HotkeyModifier::Control;
+            }
+            else if (EqualsNoCase(token, L"Alt")) {
+                modifiers |= HotkeyModifier::Alt;
+            }
+            else if (EqualsNoCase(token, L"Shift")) {
+                modifiers |= HotkeyModifier::Shift;
+            }
+            else if (EqualsNoCase(token, L"Win")) {
+                modifiers |= HotkeyModifier::Win;
+            }
+            else {
+                // The key must be the last token
+                if (virtualKey != 0 || !text.empty()) return false;
+                virtualKey = ParseKeyName(token);
+                if (virtualKey == 0) return false;
+            }
+        }
+
+        return virtualKey != 0;
+    }
+}
+
+// Fixed-capacity binding table. The index of a binding doubles as its
+// system hotkey id, so dispatch is a bounds check and an array read.
+class HotkeyTable {
+public:
+    static constexpr size_t MAX_BINDINGS = 16;
+
+    bool Add(const HotkeyBinding& binding) {
+        if (m_count >= MAX_BINDINGS || binding.virtualKey == 0) return false;
+        if (Find(binding.modifiers, binding.virtualKey) != HotkeyAction::None) return false;
+        m_bindings[m_count++] = binding;
+        return true;
+    }
+
+    bool Add(std::wstring_view text, HotkeyAction action) {
+        HotkeyBinding binding;
+        binding.action = action;
+        if (!HotkeyParser::Parse(text, binding.modifiers, binding.virtualKey)) return false;
+        return Add(binding);
+    }
+
+    void Clear() { m_count = 0; }
+
+    HotkeyAction GetAction(size_t id) const {
+        return id < m_count ? m_bindings[id].action : HotkeyAction::None;
+    }
+
+    HotkeyAction Find(uint32_t modifiers, uint32_t virtualKey) const {
+        for (size_t i = 0; i < m_count; i++) {
+            if (m_bindings[i].modifiers == modifiers && m_bindings[i].virtualKey == virtualKey) {
+                return m_bindings[i].action;
+            }
+        }
+        return HotkeyAction::None;
+    }
+
+    const HotkeyBinding& operator[](size_t id) const { return m_bindings[id]; }
+    size_t Size() const { return m_count; }
+
+    // Table with the default binding for every action
+    static HotkeyTable CreateDefault() {
+        HotkeyTable table;
+        for (int i = 1; i < static_cast<int>(HotkeyAction::Count); i++) {
+            auto action = static_cast<HotkeyAction>(i);
+            table.Add(GetDefaultHotkey(action), action);
+        }
+        return table;
+    }
+
+private:
+    std::array<HotkeyBinding, MAX_BINDINGS> m_bindings = {};
+    size_t m_count = 0;
+};
+
+// Routes actions to plain function pointers; nothing is allocated per event
+class HotkeyDispatcher {
+public:
+    using Handler = void (*)(void* context);
+
+    void Bind(HotkeyAction action, Handler handler, void* context) {
+        size_t index = static_cast<size_t>(action);
+        if (index < m_handlers.size()) {
+            m_handlers[index] = { handler, context };
+        }
+    }
+
+    bool Dispatch(HotkeyAction action) const {
+        size_t index = static_cast<size_t>(action);
+        if (index >= m_handlers.size() || !m_handlers[index].handler) return false;
+        m_handlers[index].handler(m_handlers[index].context);
+        return true;
+    }
+
+    bool Dispatch(const HotkeyTable& table, size_t id) const {
+        return Dispatch(table.GetAction(id));
+    }
+
+private:
+    struct Entry {
+        Handler handler = nullptr;
+        void* context = nullptr;
+    };
+
+    std::array<Entry, static_cast<size_t>(HotkeyAction::Count)> m_handlers = {};
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <windows.h>
+
+#include "HotkeyBindings.h"
+
+// Registers a HotkeyTable as system hotkeys. Windows only sends WM_HOTKEY
+// for bound combinations, so unbound keystrokes never wake the overlay.
+class HotkeyManager {
+public:
+    ~HotkeyManager() {
+        UnregisterAll();
+    }
+
+    // Register every binding; returns the number that could not be
+    // registered (usually because another application owns the combination)
+    int RegisterAll(HWND window, const HotkeyTable& table) {
+        UnregisterAll();
+        m_window = window;
+        m_table = table;
+
+        int failures = 0;
+        for (size_t id = 0; id < m_table.Size(); id++) {
+            const HotkeyBinding& binding = m_table[id];
+            if (RegisterHotKey(m_window, static_cast<int>(id),
+                binding.modifiers | MOD_NOREPEAT, binding.virtualKey)) {
+                m_registered[id] = true;
+            }
+            else {
+                failures++;
+            }
+        }
+        return failures;
+    }
+
+    void UnregisterAll() {
+        for (size_t id = 0; id < m_table.Size(); id++) {
+            if (m_registered[id]) {
+                UnregisterHotKey(m_window, static_cast<int>(id));
+                m_registered[id] = false;
+            }
+        }
+        m_window = nullptr;
+    }
+
+    // Handle WM_HOTKEY; wParam carries the id passed to RegisterHotKey
+    bool OnHotkey(WPARAM wParam) const {
+        return m_dispatcher.Dispatch(m_table, static_cast<size_t>(wParam));
+    }
+
+    HotkeyDispatcher& GetDispatcher() { return m_dispatcher; }
+
+private:
+    HWND m_window = nullptr;
+    HotkeyTable m_table;
+    HotkeyDispatcher m_dispatcher;
+    bool m_registered[HotkeyTable::MAX_BINDINGS] = {};
+};
@@ -0,0 +1,415 @@
+#include "PaletteTuner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <thread>
+
+#include "FrameView.h"
+#include "GaugeAnalyzer.h"
+
+namespace {
+    // Reads a binary PPM (P6, maxval 255) into BGRX pixels
+    bool DecodePpm(const std::string& path, std::vector<uint8_t>& pixels, FrameView& view) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        const std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        // Header: magic, width, height and maxval, separated by whitespace and comments
+        size_t position = 0;
+        auto nextToken = [&](std::string& token) {
+            token.clear();
+            while (position < data.size()) {
+                if (data[position] == '#') {
+                    while (position < data.size() && data[position] != '\n') position++;
+                }
+                else if (isspace(data[position])) {
+                    position++;
+                }
+                else {
+                    break;
+                }
+            }
+            while (position < data.size() && !isspace(data[position])) {
+                token += static_cast<char>(data[position++]);
+            }
+            return !token.empty();
+        };
+
+        std::string magic, width, height, maxval;
+        if (!nextToken(magic) || magic != "P6" || !nextToken(width) || !nextToken(height) ||
+            !nextToken(maxval) || maxval != "255") {
+            return false;
+        }
+        position++; // The single whitespace before the raster
+
+        const int w = atoi(width.c_str());
+        const int h = atoi(height.c_str());
+        if (w <= 0 || h <= 0) return false;
+        const size_t count = static_cast<size_t>(w) * h;
+        if (data.size() < position + count * 3) return false;
+
+        pixels.resize(count * FrameView::BYTES_PER_PIXEL);
+        const uint8_t* source = data.data() + position;
+        for (size_t i = 0; i < count; i++) {
+            pixels[i * 4 + 0] = source[i * 3 + 2];
+            pixels[i * 4 + 1] = source[i * 3 + 1];
+            pixels[i * 4 + 2] = source[i * 3 + 0];
+            pixels[i * 4 + 3] = 0;
+        }
+
+        view = FrameView{};
+        view.data = pixels.data();
+        view.width = w;
+        view.height = h;
+        view.stride = w * FrameView::BYTES_PER_PIXEL;
+        return true;
+    }
+
+    // Decoded frames of one worker. Frames are kept until the budget is
+    // spent; the rest are decoded again into a scratch buffer on each use.
+    class FrameCache {
+    public:
+        FrameCache(const TuningCorpus& corpus, size_t budgetBytes)
+            : m_corpus(corpus)
+            , m_budgetBytes(budgetBytes)
+            , m_usedBytes(0)
+            , m_pixels(corpus.samples.size())
+            , m_views(corpus.samples.size())
+            , m_isCached(corpus.samples.size(), false) {
+        }
+
+        const FrameView* Get(size_t index) {
+            if (m_isCached[index]) return &m_views[index];
+
+            if (!DecodePpm(m_corpus.samples[index].path, m_scratch, m_scratchView)) return nullptr;
+            if (m_usedBytes + m_scratch.size() > m_budgetBytes) return &m_scratchView;
+
+            m_usedBytes += m_scratch.size();
+            m_pixels[index].swap(m_scratch);
+            m_views[index] = m_scratchView;
+            m_views[index].data = m_pixels[index].data();
+            m_isCached[index] = true;
+            return &m_views[index];
+        }
+
+    private:
+        const TuningCorpus& m_corpus;
+        size_t m_budgetBytes;
+        size_t m_usedBytes;
+        std::vector<std::vector<uint8_t>> m_pixels;
+        std::vector<FrameView> m_views;
+        std::vector<bool> m_isCached;
+        std::vector<uint8_t> m_scratch;
+        FrameView m_scratchView;
+    };
+
+    struct Analyzer {
+        GaugeLayout layout;
+        const GaugeAnalyzerEntry* entry = nullptr;
+    };
+
+    struct Candidate {
+        XpBarPalette palette;
+        const Analyzer* analyzer = nullptr;
+    };
+
+    // Candidates are derived from their index alone, so a search covers the
+    // same candidates on any number of threads
+    class CandidateSpace {
+    public:
+        CandidateSpace(const PaletteTunerConfig& config, const std::vector<Analyzer>& analyzers)
+            : m_config(config)
+            , m_analyzers(analyzers)
+            , m_maxTolerance((std::max)(config.maxTolerance, 0))
+            , m_colorJitter((std::max)(config.colorJitter, 0)) {
+            // Negative limits would turn the random distributions' ranges
+            // around, so they count as 0
+            m_toleranceSteps = config.toleranceStep > 0 ? m_maxTolerance / config.toleranceStep + 1 : 1;
+        }
+
+        uint64_t GetCount() const {
+            if (m_config.search == TuningSearch::Random) {
+                return m_config.candidates > 0 ? static_cast<uint64_t>(m_config.candidates) : 0;
+            }
+            const uint64_t steps = static_cast<uint64_t>(m_toleranceSteps);
+            return m_analyzers.size() * steps * steps * steps * steps;
+        }
+
+        Candidate Get(uint64_t index) const {
+            return m_config.search == TuningSearch::Random ? GetRandom(index) : GetGrid(index);
+        }
+
+    private:
+        Candidate GetGrid(uint64_t index) const {
+            Candidate candidate;
+            candidate.palette = m_config.palette;
+            candidate.analyzer = &m_analyzers[index % m_analyzers.size()];
+            index /= m_analyzers.size();
+
+            PaletteColor* colors[] = { &candidate.palette.fill, &candidate.palette.marker,
+                &candidate.palette.filledMarker, &candidate.palette.background };
+            for (PaletteColor* color : colors) {
+                color->tolerance = static_cast<int>(index % m_toleranceSteps) * m_config.toleranceStep;
+                index /= m_toleranceSteps;
+            }
+            return candidate;
+        }
+
+        Candidate GetRandom(uint64_t index) const {
+            std::mt19937 random(static_cast<uint32_t>(m_config.seed * 0x9E3779B9u + index * 0x85EBCA6Bu));
+            std::uniform_int_distribution<int> offset(-m_colorJitter, m_colorJitter);
+            std::uniform_int_distribution<int> tolerance(0, m_maxTolerance);
+            std::uniform_int_distribution<size_t> analyzer(0, m_analyzers.size() - 1);
+
+            Candidate candidate;
+            candidate.palette = m_config.palette;
+            candidate.analyzer = &m_analyzers[analyzer(random)];
+
+            auto jitter = [&](uint8_t channel) {
+                return static_cast<uint8_t>((std::clamp)(channel + offset(random), 0, 255));
+            };
+            PaletteColor* colors[] = { &candidate.palette.fill, &candidate.palette.marker,
+                &candidate.palette.filledMarker, &candidate.palette.background };
+            for (PaletteColor* color : colors) {
+                color->red = jitter(color->red);
+                color->green = jitter(color->green);
+                color->blue = jitter(color->blue);
+                color->tolerance = tolerance(random);
+            }
+            return candidate;
+        }
+
+        const PaletteTunerConfig& m_config;
+        const std::vector<Analyzer>& m_analyzers;
+        int m_maxTolerance;
+        int m_colorJitter;
+        int m_toleranceSteps;
+    };
+
+    // Lower mean error wins, then lower worst error, then the cheaper candidate
+    bool IsBetter(const TuningResult& a, const TuningResult& b) {
+        if (std::fabs(a.meanError - b.meanError) > 1e-9) return a.meanError < b.meanError;
+        if (std::fabs(a.maxError - b.maxError) > 1e-9) return a.maxError < b.maxError;
+        return a.nanosecondsPerFrame < b.nanosecondsPerFrame;
+    }
+
+    // Keeps the best `keep` results, best first
+    void Offer(std::vector<TuningResult>& best, const TuningResult& result, size_t keep) {
+        if (best.size() == keep && !IsBetter(result, best.back())) return;
+        best.insert(std::upper_bound(best.begin(), best.end(), result, IsBetter), result);
+        if (best.size() > keep) best.pop_back();
+    }
+
+    bool Evaluate(const Candidate& candidate, const TuningCorpus& corpus, FrameCache& cache, TuningResult& result) {
+        PaletteClassifier classifier;
+        classifier.palette = candidate.palette;
+
+        double totalError = 0.0;
+        double maxError = 0.0;
+        std::chrono::nanoseconds elapsed{ 0 };
+        for (size_t i = 0; i < corpus.samples.size(); i++) {
+            const FrameView* frame = cache.Get(i);
+            if (!frame) return false;
+
+            int frontier = 0;
+            const auto start = std::chrono::steady_clock::now();
+            const GaugeReading reading = candidate.analyzer->entry->scan(*frame, classifier, frontier);
+            elapsed += std::chrono::steady_clock::now() - start;
+
+            const double error = std::fabs(reading.percent - corpus.samples[i].percent);
+            totalError += error;
+            maxError = (std::max)(maxError, error);
+        }
+
+        result.palette = candidate.palette;
+        result.layout = candidate.analyzer->layout;
+        result.meanError = totalError / corpus.samples.size();
+        result.maxError = maxError;
+        result.nanosecondsPerFrame = static_cast<double>(elapsed.count()) / corpus.samples.size();
+        return true;
+    }
+
+    void AppendColor(std::string& text, const char* key, const PaletteColor& color) {
+        char line[64];
+        snprintf(line, sizeof(line), "%s=%02X%02X%02X,%d\n", key, color.red, color.green, color.blue, color.tolerance);
+        text += line;
+    }
+
+    void AppendResult(std::string& text, const char* label, const TuningResult& result) {
+        char line[256];
+        snprintf(line, sizeof(line),
+            "%-8s mean=%6.3f%% max=%6.3f%% cost=%7.0fns marker=%d fill=%02X%02X%02X,%d marker=%02X%02X%02X,%d "
+            "filledMarker=%02X%02X%02X,%d background=%02X%02X%02X,%d\n",
+            label, result.meanError, result.maxError, result.nanosecondsPerFrame, result.layout.markerWidth,
+            result.palette.fill.red, result.palette.fill.green, result.palette.fill.blue, result.palette.fill.tolerance,
+            result.palette.marker.red, result.palette.marker.green, result.palette.marker.blue, result.palette.marker.tolerance,
+            result.palette.filledMarker.red, result.palette.filledMarker.green, result.palette.filledMarker.blue,
+            result.palette.filledMarker.tolerance,
+            result.palette.background.red, result.palette.background.green, result.palette.background.blue,
+            result.palette.background.tolerance);
+        text += line;
+    }
+}
+
+bool TuningCorpus::Load(const std::string& manifestPath, std::string& error) {
+    samples.clear();
+
+    std::ifstream in(manifestPath);
+    if (!in) {
+        error = "Could not open " + manifestPath;
+        return false;
+    }
+
+    const std::filesystem::path directory = std::filesystem::path(manifestPath).parent_path();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        // The percentage is the last field, so image paths may contain spaces
+        const size_t last = line.find_last_not_of(" \t\r");
+        const size_t split = line.find_last_of(" \t", last);
+        if (split == std::string::npos || split < first) {
+            error = "Line " + std::to_string(lineNumber) + ": expected \"<image> <percent>\"";
+            return false;
+        }
+
+        TuningSample sample;
+        std::filesystem::path path(line.substr(first, line.find_last_not_of(" \t", split) + 1 - first));
+        sample.path = (path.is_relative() ? directory / path : path).string();
+        char* end = nullptr;
+        const std::string percent = line.substr(split + 1, last - split);
+        sample.percent = strtof(percent.c_str(), &end);
+        if (end == percent.c_str() || *end != '\0' || sample.percent < 0.0f || sample.percent > 100.0f) {
+            error = "Line " + std::to_string(lineNumber) + ": percent must be 0-100";
+            return false;
+        }
+        samples.push_back(std::move(sample));
+    }
+
+    if (samples.empty()) {
+        error = "No frames in " + manifestPath;
+        return false;
+    }
+    return true;
+}
+
+TuningReport PaletteTuner::Run(const TuningCorpus& corpus, const PaletteTunerConfig& config) {
+    TuningReport report;
+    report.frames = corpus.samples.size();
+    const auto start = std::chrono::steady_clock::now();
+
+    if (corpus.samples.empty()) {
+        report.failure = "Empty corpus";
+        return report;
+    }
+
+    // Every requested marker width that has a compiled analyzer
+    std::vector<Analyzer> analyzers;
+    for (int width : config.markerWidths) {
+        GaugeLayout layout = config.layout;
+        layout.markerWidth = width;
+        if (const GaugeAnalyzerEntry* entry = GaugeAnalyzerRegistry::Find(layout)) {
+            analyzers.push_back(Analyzer{ layout, entry });
+        }
+    }
+    Analyzer baselineAnalyzer{ config.layout, GaugeAnalyzerRegistry::Find(config.layout) };
+    if (analyzers.empty() || !baselineAnalyzer.entry) {
+        report.failure = "No analyzer is compiled for the gauge layout";
+        return report;
+    }
+
+    // The starting point, which also checks every frame decodes
+    {
+        FrameCache cache(corpus, 0);
+        if (!Evaluate(Candidate{ config.palette, &baselineAnalyzer }, corpus, cache, report.baseline)) {
+            report.failure = "A frame could not be read; frames must be binary PPM (P6) files";
+            return report;
+        }
+    }
+
+    const CandidateSpace space(config, analyzers);
+    const uint64_t count = space.GetCount();
+    size_t threadCount = config.threads;
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 1;
+    }
+    report.threads = threadCount;
+
+    // Workers pull small batches so uneven candidates still balance out
+    constexpr uint64_t BATCH = 16;
+    const size_t keep = config.keep > 0 ? config.keep : 1;
+    std::atomic<uint64_t> next{ 0 };
+    std::vector<std::vector<TuningResult>> best(threadCount);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threadCount; t++) {
+        workers.emplace_back([&, t] {
+            FrameCache cache(corpus, config.cacheBytesPerThread);
+            for (;;) {
+                const uint64_t first = next.fetch_add(BATCH, std::memory_order_relaxed);
+                if (first >= count) break;
+                const uint64_t last = (std::min)(first + BATCH, count);
+                for (uint64_t i = first; i < last; i++) {
+                    TuningResult result;
+                    if (Evaluate(space.Get(i), corpus, cache, result)) {
+                        Offer(best[t], result, keep);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    Offer(report.best, report.baseline, keep);
+    for (const auto& results : best) {
+        for (const auto& result : results) {
+            Offer(report.best, result, keep);
+        }
+    }
+
+    report.candidates = count + 1;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report.succeeded = true;
+    return report;
+}
+
+std::string TuningReport::ToString() const {
+    if (!succeeded) return "FAIL: " + failure + "\n";
+
+    std::string text;
+    char line[256];
+    snprintf(line, sizeof(line), "%llu candidates over %zu frames on %zu threads in %.1fs\n",
+        static_cast<unsigned long long>(candidates), frames, threads, seconds);
+    text += line;
+
+    AppendResult(text, "current", baseline);
+    for (size_t i = 0; i < best.size(); i++) {
+        snprintf(line, sizeof(line), "#%zu", i + 1);
+        AppendResult(text, line, best[i]);
+    }
+
+    // The winner, ready to paste into config.ini
+    const TuningResult& winner = best.front();
+    text += "\n[Palette]\n";
+    AppendColor(text, "Fill", winner.palette.fill);
+    AppendColor(text, "Marker", winner.palette.marker);
+    AppendColor(text, "FilledMarker", winner.palette.filledMarker);
+    AppendColor(text, "Background", winner.palette.background);
+    snprintf(line, sizeof(line), "\n[Gauge]\nMarkerWidth=%d\n", winner.layout.markerWidth);
+    text += line;
+    return text;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GaugeLayout.h"
+#include "XpBarPalette.h"
+
+// One labelled frame: a capture of the bar region and the percentage the
+// game showed for it
+struct TuningSample {
+    std::string path;   // Binary PPM (P6), 8 bits per channel
+    float percent = 0.0f;
+};
+
+// A manifest of labelled frames, one "<image> <percent>" per line. Blank
+// lines and lines starting with '#' are skipped; relative image paths are
+// relative to the manifest.
+struct TuningCorpus {
+    std::vector<TuningSample> samples;
+
+    bool Load(const std::string& manifestPath, std::string& error);
+};
+
+enum class TuningSearch {
+    Grid,   // Every tolerance combination on a grid, colours as configured
+    Random  // Colours jittered around the configured ones, random tolerances
+};
+
+struct PaletteTunerConfig {
+    XpBarPalette palette;           // Starting point, always evaluated first
+    GaugeLayout layout;             // Orientation and direction are kept
+    std::vector<int> markerWidths = { 0, 2, 4 }; // Tried where an analyzer exists
+    TuningSearch search = TuningSearch::Grid;
+    int toleranceStep = 4;          // Grid spacing
+    int maxTolerance = 32;          // Negative counts as 0
+    int candidates = 20000;         // Random search only
+    int colorJitter = 16;           // Random search: per-channel offset limit, negative counts as 0
+    uint32_t seed = 1;
+    size_t threads = 0;             // 0 uses every core
+    size_t cacheBytesPerThread = 64u << 20; // Decoded frames each worker keeps
+    size_t keep = 5;                // Best candidates reported
+};
+
+struct TuningResult {
+    XpBarPalette palette;
+    GaugeLayout layout;
+    double meanError = 0.0;         // Mean absolute error, in percent
+    double maxError = 0.0;
+    double nanosecondsPerFrame = 0.0; // Analyzer time only
+};
+
+struct TuningReport {
+    bool succeeded = false;
+    std::string failure;
+    size_t frames = 0;
+    size_t threads = 0;
+    uint64_t candidates = 0;        // Evaluated, including the starting point
+    double seconds = 0.0;
+    TuningResult baseline;          // The starting point
+    std::vector<TuningResult> best; // Lowest error first, then cheapest
+
+    // Summary and the winning set as [Palette] and [Gauge] INI entries
+    std::string ToString() const;
+};
+
+// Searches classifier colours, tolerances and marker widths for the set
+// that reads a labelled corpus most accurately, on every core. Each worker
+// decodes frames into its own cache and scans them with the same compiled
+// analyzers the overlay uses, so the reported cost is the runtime cost.
+// Platform independent; the overlay runs it with --tune and tools/TuneMain.cpp
+// from the command line.
+class PaletteTuner {
+public:
+    static TuningReport Run(const TuningCorpus& corpus, const PaletteTunerConfig& config);
+};
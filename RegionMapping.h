@@ -0,0 +1,52 @@
+#pragma once
+
+// Capture regions are stored relative to the game window's top-left
+// corner, which is also the overlay's client origin. These helpers map
+// them to the screen and carry them across window resizes. They work on
+// any rectangle type with left/top/right/bottom members, so RECT on
+// Windows and a plain struct elsewhere.
+namespace RegionMapping {
+    template <typename Rect>
+    Rect Offset(const Rect& rect, int dx, int dy) {
+        Rect result = rect;
+        result.left = rect.left + dx;
+        result.top = rect.top + dy;
+        result.right = rect.right + dx;
+        result.bottom = rect.bottom + dy;
+        return result;
+    }
+
+    // Window-relative region to screen coordinates for a window whose
+    // top-left corner is at (windowLeft, windowTop)
+    template <typename Rect>
+    Rect ToScreen(const Rect& relative, int windowLeft, int windowTop) {
+        return Offset(relative, windowLeft, windowTop);
+    }
+
+    // Scale one coordinate from a span of `from` pixels to `to` pixels, rounding to nearest
+    inline int ScaleCoordinate(int value, int from, int to) {
+        if (from <= 0 || from == to) return value;
+        const long long scaled = static_cast<long long>(value) * to;
+        return static_cast<int>(scaled >= 0 ? (scaled + from / 2) / from : (scaled - from / 2) / from);
+    }
+
+    // Rescale a window-relative region measured on a fromWidth x fromHeight
+    // window to a toWidth x toHeight window. A non-empty region stays at
+    // least one pixel in each direction.
+    template <typename Rect>
+    Rect Rescale(const Rect& relative, int fromWidth, int fromHeight, int toWidth, int toHeight) {
+        Rect result = relative;
+        result.left = ScaleCoordinate(relative.left, fromWidth, toWidth);
+        result.right = ScaleCoordinate(relative.right, fromWidth, toWidth);
+        result.top = ScaleCoordinate(relative.top, fromHeight, toHeight);
+        result.bottom = ScaleCoordinate(relative.bottom, fromHeight, toHeight);
+
+        if (relative.right > relative.left && result.right <= result.left) {
+            result.right = result.left + 1;
+        }
+        if (relative.bottom > relative.top && result.bottom <= result.top) {
+            result.bottom = result.top + 1;
+        }
+        return result;
+    }
+}
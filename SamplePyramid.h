@@ -0,0 +1,106 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Multi-resolution summary of a sample stream for drawing history at any
+// zoom. Level 0 keeps the newest Capacity samples; each level above keeps
+// Capacity buckets that summarize twice as many samples (min, max, mean)
+// as the level below. A new sample completes at most one bucket per level,
+// and only every 2^level samples, so adding is O(1) amortized and the whole
+// structure is fixed-size.
+template <size_t Capacity = 512, size_t Levels = 12>
+class SamplePyramid {
+public:
+    struct Bucket {
+        float minimum = 0.0f;
+        float maximum = 0.0f;
+        float sum = 0.0f;
+        uint32_t count = 0;
+
+        float GetMean() const { return count ? sum / count : 0.0f; }
+    };
+
+    static constexpr size_t CAPACITY = Capacity;
+    static constexpr size_t LEVELS = Levels;
+
+    SamplePyramid() { Clear(); }
+
+    void Clear() {
+        m_totals.fill(0);
+        m_pending.fill(Bucket{});
+        m_sampleCount = 0;
+    }
+
+    void Add(float value) {
+        Bucket bucket;
+        bucket.minimum = value;
+        bucket.maximum = value;
+        bucket.sum = value;
+        bucket.count = 1;
+        m_sampleCount++;
+
+        // Push into level 0, then carry completed pairs upwards
+        for (size_t level = 0; level < Levels; level++) {
+            Push(level, bucket);
+            if (level + 1 == Levels) break;
+
+            Bucket& pending = m_pending[level];
+            if (pending.count == 0) {
+                pending = bucket;
+                break;
+            }
+            bucket = Merge(pending, bucket);
+            pending = Bucket{};
+        }
+    }
+
+    uint64_t GetSampleCount() const { return m_sampleCount; }
+
+    // Buckets ever completed at a level; changes whenever that level gains a bucket
+    uint64_t GetBucketTotal(size_t level) const { return m_totals[level]; }
+
+    // Buckets currently held at a level
+    size_t GetBucketCount(size_t level) const {
+        return m_totals[level] < Capacity ? static_cast<size_t>(m_totals[level]) : Capacity;
+    }
+
+    // index 0 is the oldest held bucket
+    const Bucket& GetBucket(size_t level, size_t index) const {
+        const uint64_t first = m_totals[level] - GetBucketCount(level);
+        return m_buckets[level][static_cast<size_t>((first + index) % Capacity)];
+    }
+
+    // Finest level that shows the newest `samples` samples in at most
+    // `points` buckets
+    size_t SelectLevel(uint64_t samples, size_t points) const {
+        if (points == 0) return Levels - 1;
+        if (points > Capacity) points = Capacity;
+
+        for (size_t level = 0; level < Levels; level++) {
+            const uint64_t buckets = (samples + (uint64_t(1) << level) - 1) >> level;
+            if (buckets <= points) return level;
+        }
+        return Levels - 1;
+    }
+
+private:
+    static Bucket Merge(const Bucket& a, const Bucket& b) {
+        Bucket merged;
+        merged.minimum = a.minimum < b.minimum ? a.minimum : b.minimum;
+        merged.maximum = a.maximum > b.maximum ? a.maximum : b.maximum;
+        merged.sum = a.sum + b.sum;
+        merged.count = a.count + b.count;
+        return merged;
+    }
+
+    void Push(size_t level, const Bucket& bucket) {
+        m_buckets[level][static_cast<size_t>(m_totals[level] % Capacity)] = bucket;
+        m_totals[level]++;
+    }
+
+    std::array<std::array<Bucket, Capacity>, Levels> m_buckets;
+    std::array<uint64_t, Levels> m_totals;
+    std::array<Bucket, Levels> m_pending;   // First half of the next bucket one level up
+    uint64_t m_sampleCount;
+};
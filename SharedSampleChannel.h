@@ -0,0 +1,225 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "XpSample.h"
+
+// Publishes XpSamples through a named shared-memory segment guarded by a
+// seqlock. The writer never waits for readers; readers poll the segment
+// with plain loads and retry if they raced a write. This header is also
+// the reader library for external tools: include it and use
+// SharedSampleReader.
+
+namespace SharedSampleChannel {
+    constexpr const char* DEFAULT_NAME = "pOverlay.XpSample";
+    constexpr uint32_t MAGIC = 0x58504F56; // "XPOV"
+    constexpr uint32_t VERSION = 2;
+    constexpr size_t PAYLOAD_WORDS = sizeof(XpSample) / sizeof(uint64_t);
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must be lock-free");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared atomics must be lock-free");
+
+    struct Layout {
+        std::atomic<uint32_t> magic;
+        uint32_t version;
+        std::atomic<uint32_t> sequence; // Seqlock counter; odd while a write is in progress
+        uint32_t reserved;
+        std::atomic<uint64_t> payload[PAYLOAD_WORDS];
+    };
+
+    // Name of the segment for a given channel name on this platform
+    inline std::string GetSegmentName(const char* name) {
+#ifdef _WIN32
+        return std::string("Local\\") + name;
+#else
+        return std::string("/") + name;
+#endif
+    }
+
+    // Owns one mapping of the segment
+    class Mapping {
+    public:
+        Mapping() = default;
+        ~Mapping() { Close(); }
+
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+
+        bool Create(const char* name) {
+            Close();
+            std::string segmentName = GetSegmentName(name);
+#ifdef _WIN32
+            m_handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                0, static_cast<DWORD>(sizeof(Layout)), segmentName.c_str());
+            if (!m_handle) return false;
+            m_view = MapViewOfFile(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(Layout));
+#else
+            int fd = shm_open(segmentName.c_str(), O_CREAT | O_RDWR, 0644);
+            if (fd < 0) return false;
+            if (ftruncate(fd, sizeof(Layout)) != 0) {
+                close(fd);
+                return false;
+            }
+            void* view = mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            m_view = (view == MAP_FAILED) ? nullptr : view;
+            m_unlinkName = segmentName;
+#endif
+            if (!m_view) {
+                Close();
+                return false;
+            }
+            return true;
+        }
+
+        bool Open(const char* name) {
+            Close();
+            std::string segmentName = GetSegmentName(name);
+#ifdef _WIN32
+            m_handle = OpenFileMappingA(FILE_MAP_READ, FALSE, segmentName.c_str());
+            if (!m_handle) return false;
+            m_view = MapViewOfFile(m_handle, FILE_MAP_READ, 0, 0, sizeof(Layout));
+#else
+            int fd = shm_open(segmentName.c_str(), O_RDONLY, 0);
+            if (fd < 0) return false;
+            void* view = mmap(nullptr, sizeof(Layout), PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            m_view = (view == MAP_FAILED) ? nullptr : view;
+#endif
+            if (!m_view) {
+                Close();
+                return false;
+            }
+            return true;
+        }
+
+        void Close() {
+#ifdef _WIN32
+            if (m_view) UnmapViewOfFile(m_view);
+            if (m_handle) CloseHandle(m_handle);
+            m_handle = nullptr;
+#else
+            if (m_view) munmap(m_view, sizeof(Layout));
+            if (!m_unlinkName.empty()) shm_unlink(m_unlinkName.c_str());
+            m_unlinkName.clear();
+#endif
+            m_view = nullptr;
+        }
+
+        Layout* Get() const { return static_cast<Layout*>(m_view); }
+
+    private:
+        void* m_view = nullptr;
+#ifdef _WIN32
+        HANDLE m_handle = nullptr;
+#else
+        std::string m_unlinkName; // Set for the creator, which removes the name on close
+#endif
+    };
+}
+
+// Single writer; owned by the capture pipeline
+class SharedSampleWriter {
+public:
+    bool Open(const char* name = SharedSampleChannel::DEFAULT_NAME) {
+        if (!m_mapping.Create(name)) return false;
+
+        SharedSampleChannel::Layout* layout = m_mapping.Get();
+        new (layout) SharedSampleChannel::Layout();
+        layout->version = SharedSampleChannel::VERSION;
+        layout->sequence.store(0, std::memory_order_relaxed);
+        for (auto& word : layout->payload) {
+            word.store(0, std::memory_order_relaxed);
+        }
+        // Readers ignore the segment until the magic is visible
+        layout->magic.store(SharedSampleChannel::MAGIC, std::memory_order_release);
+        return true;
+    }
+
+    void Close() { m_mapping.Close(); }
+    bool IsOpen() const { return m_mapping.Get() != nullptr; }
+
+    void Publish(const XpSample& sample) {
+        SharedSampleChannel::Layout* layout = m_mapping.Get();
+        if (!layout) return;
+
+        uint64_t words[SharedSampleChannel::PAYLOAD_WORDS];
+        std::memcpy(words, &sample, sizeof(words));
+
+        uint32_t sequence = layout->sequence.load(std::memory_order_relaxed);
+        layout->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < SharedSampleChannel::PAYLOAD_WORDS; i++) {
+            layout->payload[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        layout->sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+private:
+    SharedSampleChannel::Mapping m_mapping;
+};
+
+// Any number of readers, in any process. Reads never block the writer.
+class SharedSampleReader {
+public:
+    bool Open(const char* name = SharedSampleChannel::DEFAULT_NAME) {
+        return m_mapping.Open(name);
+    }
+
+    void Close() { m_mapping.Close(); }
+    bool IsOpen() const { return m_mapping.Get() != nullptr; }
+
+    // Copy the latest sample. Returns false if nothing has been published
+    // yet or the writer kept the segment busy for every attempt.
+    bool Read(XpSample& out, int maxAttempts = 64) const {
+        const SharedSampleChannel::Layout* layout = m_mapping.Get();
+        if (!layout) return false;
+        if (layout->magic.load(std::memory_order_acquire) != SharedSampleChannel::MAGIC ||
+            layout->version != SharedSampleChannel::VERSION) {
+            return false;
+        }
+
+        for (int attempt = 0; attempt < maxAttempts; attempt++) {
+            uint32_t before = layout->sequence.load(std::memory_order_acquire);
+            if (before == 0) return false; // Nothing published yet
+            if (before & 1) continue;       // Write in progress
+
+            uint64_t words[SharedSampleChannel::PAYLOAD_WORDS];
+            for (size_t i = 0; i < SharedSampleChannel::PAYLOAD_WORDS; i++) {
+                words[i] = layout->payload[i].load(std::memory_order_relaxed);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (layout->sequence.load(std::memory_order_relaxed) == before) {
+                std::memcpy(&out, words, sizeof(out));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Read only if a sample newer than lastSequence is available
+    bool ReadNewer(uint64_t lastSequence, XpSample& out) const {
+        XpSample sample;
+        if (!Read(sample) || sample.sequence <= lastSequence) return false;
+        out = sample;
+        return true;
+    }
+
+private:
+    SharedSampleChannel::Mapping m_mapping;
+};
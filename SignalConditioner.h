@@ -0,0 +1,217 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+// Settings for SignalConditioner, read from the [Filter] INI section
+struct SignalConditionerConfig {
+    enum class FilterMode {
+        None,
+        Median,
+        Exponential
+    };
+
+    FilterMode mode = FilterMode::Median;
+    int medianWindow = 5;           // Samples; clamped to MAX_MEDIAN_WINDOW
+    float smoothing = 0.5f;         // Exponential filter weight of the newest sample (0-1]
+    bool monotonicWithinLevel = true;
+    float hysteresis = 0.05f;       // Minimum change in percent before an update is emitted
+    float levelWrapDrop = 50.0f;    // A drop at least this large is confirmed after levelWrapConfirmFrames
+    int levelWrapConfirmFrames = 2; // Consecutive low frames required to accept a large wrap
+    int levelWrapMaxConfirmFrames = 40; // Likewise for the smallest drop; the count scales in between
+    float levelWrapLanding = 10.0f; // A drop smaller than levelWrapDrop is only a wrap if it lands below this
+
+    static constexpr int MAX_MEDIAN_WINDOW = 15;
+};
+
+// Sits between analysis and publishing. Smooths single-frame flicker from
+// anti-aliasing, glow and occlusion, keeps the value from creeping
+// backwards within a level, recognises level-ups, and suppresses updates
+// smaller than the hysteresis so the overlay only repaints on real change.
+// Fixed-size state; nothing is allocated per sample.
+class SignalConditioner {
+public:
+    struct Output {
+        float value = 0.0f;     // Conditioned percentage
+        bool emit = false;      // Changed enough to be worth displaying
+        bool levelWrapped = false;
+        bool wrapPending = false; // A drop is being held until it is confirmed or clears
+    };
+
+    // totalPixels for readings whose bar pixels were not counted
+    static constexpr int UNKNOWN_TOTAL = -1;
+
+    explicit SignalConditioner(const SignalConditionerConfig& config = {}) {
+        Configure(config);
+    }
+
+    void Configure(const SignalConditionerConfig& config) {
+        m_config = config;
+        if (m_config.medianWindow < 1) m_config.medianWindow = 1;
+        if (m_config.medianWindow > SignalConditionerConfig::MAX_MEDIAN_WINDOW) {
+            m_config.medianWindow = SignalConditionerConfig::MAX_MEDIAN_WINDOW;
+        }
+        if (m_config.smoothing <= 0.0f || m_config.smoothing > 1.0f) m_config.smoothing = 1.0f;
+        if (m_config.levelWrapConfirmFrames < 1) m_config.levelWrapConfirmFrames = 1;
+        if (m_config.levelWrapMaxConfirmFrames < m_config.levelWrapConfirmFrames) {
+            m_config.levelWrapMaxConfirmFrames = m_config.levelWrapConfirmFrames;
+        }
+        Reset();
+    }
+
+    void Reset() {
+        m_historyCount = 0;
+        m_historyNext = 0;
+        m_filtered = 0.0f;
+        m_hasOutput = false;
+        m_hasEmitted = false;
+        m_output = 0.0f;
+        m_lastEmitted = 0.0f;
+        m_wrapCandidateFrames = 0;
+        m_barPixels = 0;
+    }
+
+    // totalPixels is the reading's count of bar pixels. Occlusion hides part
+    // of the bar and lowers it; a level-up leaves the whole bar visible.
+    Output Process(float raw, int totalPixels = UNKNOWN_TOTAL) {
+        Output result;
+
+        // Level-wrap detection: a drop that persists on an intact bar is a new
+        // level. A large drop is confirmed quickly. A smaller one must land
+        // near the start of the bar and takes longer the smaller it is; a map
+        // over part of the bar or a pixel of regression never becomes one.
+        const bool isBarIntact = IsBarIntact(totalPixels);
+        const float drop = m_hasOutput ? m_output - raw : 0.0f;
+        const bool canBeWrap = isBarIntact &&
+            (drop >= m_config.levelWrapDrop || raw < m_config.levelWrapLanding);
+        if (drop > m_config.hysteresis && !canBeWrap) {
+            // Held until the reading recovers
+            m_wrapCandidateFrames = 0;
+            if (drop >= m_config.levelWrapDrop) {
+                result.value = m_output;
+                return result;
+            }
+        }
+        else if (drop > m_config.hysteresis) {
+            if (++m_wrapCandidateFrames >= GetWrapConfirmFrames(drop)) {
+                ClearHistory();
+                m_output = raw;
+                m_wrapCandidateFrames = 0;
+                result.levelWrapped = true;
+            }
+            else {
+                result.wrapPending = true;
+                if (drop >= m_config.levelWrapDrop) {
+                    // Occlusion until confirmed; keep it out of the filter
+                    result.value = m_output;
+                    return result;
+                }
+            }
+        }
+        else {
+            m_wrapCandidateFrames = 0;
+        }
+
+        float value = Filter(raw);
+
+        // Within a level XP only goes up; a lower reading is noise
+        if (m_config.monotonicWithinLevel && m_hasOutput && !result.levelWrapped && value < m_output) {
+            value = m_output;
+        }
+
+        m_output = value;
+        m_hasOutput = true;
+
+        result.value = value;
+        result.emit = !m_hasEmitted || result.levelWrapped ||
+            std::fabs(value - m_lastEmitted) >= m_config.hysteresis;
+        if (result.emit) {
+            m_lastEmitted = value;
+            m_hasEmitted = true;
+        }
+        return result;
+    }
+
+    const SignalConditionerConfig& GetConfig() const { return m_config; }
+
+private:
+    // Whether the reading counted about as many bar pixels as the most
+    // complete one since Reset; anti-aliasing moves the count by a pixel or two
+    bool IsBarIntact(int totalPixels) {
+        if (totalPixels == UNKNOWN_TOTAL) return true;
+        if (totalPixels > m_barPixels) m_barPixels = totalPixels;
+
+        const int slack = (std::max)(2, m_barPixels / 100);
+        return totalPixels > 0 && totalPixels + slack >= m_barPixels;
+    }
+
+    // The full levelWrapDrop confirms after levelWrapConfirmFrames; smaller
+    // drops need proportionally more frames, up to levelWrapMaxConfirmFrames
+    int GetWrapConfirmFrames(float drop) const {
+        const int fast = m_config.levelWrapConfirmFrames;
+        const int slow = m_config.levelWrapMaxConfirmFrames;
+        if (drop >= m_config.levelWrapDrop || slow <= fast) return fast;
+
+        const float shortfall = 1.0f - drop / m_config.levelWrapDrop;
+        return fast + static_cast<int>(std::ceil((slow - fast) * shortfall));
+    }
+
+    void ClearHistory() {
+        m_historyCount = 0;
+        m_historyNext = 0;
+    }
+
+    float Filter(float raw) {
+        switch (m_config.mode) {
+        case SignalConditionerConfig::FilterMode::Median:
+            return Median(raw);
+
+        case SignalConditionerConfig::FilterMode::Exponential:
+            if (m_historyCount == 0) {
+                m_filtered = raw;
+                m_historyCount = 1;
+            }
+            else {
+                m_filtered += m_config.smoothing * (raw - m_filtered);
+            }
+            return m_filtered;
+
+        default:
+            return raw;
+        }
+    }
+
+    float Median(float raw) {
+        m_history[m_historyNext] = raw;
+        m_historyNext = (m_historyNext + 1) % m_config.medianWindow;
+        if (m_historyCount < m_config.medianWindow) m_historyCount++;
+
+        // Insertion sort a copy; the window is tiny
+        std::array<float, SignalConditionerConfig::MAX_MEDIAN_WINDOW> sorted;
+        for (int i = 0; i < m_historyCount; i++) {
+            float v = m_history[i];
+            int j = i;
+            while (j > 0 && sorted[j - 1] > v) {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = v;
+        }
+        return sorted[m_historyCount / 2];
+    }
+
+    SignalConditionerConfig m_config;
+
+    std::array<float, SignalConditionerConfig::MAX_MEDIAN_WINDOW> m_history = {};
+    int m_historyCount = 0;
+    int m_historyNext = 0;
+    float m_filtered = 0.0f;
+
+    bool m_hasOutput = false;
+    bool m_hasEmitted = false;
+    float m_output = 0.0f;
+    float m_lastEmitted = 0.0f;
+    int m_wrapCandidateFrames = 0;
+    int m_barPixels = 0;    // Most bar pixels counted since Reset
+};
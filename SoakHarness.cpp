@@ -0,0 +1,587 @@
+#include "SoakHarness.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+#include "AllocationCounter.h"
+#include "CaptureScheduler.h"
+#include "CaptureSystem.h"
+#include "SpscQueue.h"
+#include "SyntheticCaptureDevice.h"
+#include "XpTextFormat.h"
+
+namespace {
+    constexpr int MIN_REGION_WIDTH = 100;
+    constexpr int MAX_REGION_WIDTH = 1600;
+    constexpr int MIN_REGION_HEIGHT = 4;
+    constexpr int MAX_REGION_HEIGHT = 24;
+    constexpr int SCREEN_WIDTH = 2560;
+    constexpr int SCREEN_HEIGHT = 1440;
+    constexpr size_t LATENCY_SAMPLES = 4096;
+    constexpr size_t RECONFIGURE_SAMPLES = 256;
+    constexpr size_t MESSAGE_CAPACITY = 256;
+    constexpr int64_t BITMAPS_PER_CLIENT = 2; // CaptureBufferPool's default limit
+
+    // Growth allowances after warm-up; anything past these that keeps
+    // climbing is treated as unbounded
+    constexpr uint64_t RESIDENT_SLACK_BYTES = 8 * 1024 * 1024;
+    constexpr int64_t ALLOCATION_SLACK = 256;
+    constexpr int64_t LATENCY_FLOOR_US = 500;
+
+    // Handles and GDI/USER objects have no reason to move at all once every
+    // client is capturing. Windows opens and closes handles of its own
+    // behind the process's back; descriptors elsewhere are all ours.
+#ifdef _WIN32
+    constexpr uint64_t HANDLE_SLACK = 8;
+#else
+    constexpr uint64_t HANDLE_SLACK = 0;
+#endif
+
+    // Latest latency samples, added on the capture task and taken by the
+    // driving thread at each checkpoint
+    template <size_t Capacity>
+    class LatencyLog {
+    public:
+        void Add(std::chrono::microseconds latency) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_samples[m_count % Capacity] = latency.count();
+            m_count++;
+        }
+
+        // Samples since the last call, appended to out
+        void TakeAll(std::vector<int64_t>& out) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const size_t count = (std::min)(m_count, Capacity);
+            out.insert(out.end(), m_samples, m_samples + count);
+            m_count = 0;
+        }
+
+    private:
+        std::mutex m_mutex;
+        int64_t m_samples[Capacity];
+        size_t m_count = 0;
+    };
+
+    // The game's XP bar for one client: it creeps, jumps in bursts of kills
+    // and wraps on level-up, one step per blit on the capture task. The
+    // first blit after the driving thread sends a command also records the
+    // reconfiguration latency.
+    class SoakCaptureDevice : public SyntheticCaptureDevice {
+    public:
+        SoakCaptureDevice(uint32_t seed, float burstChance)
+            : m_random(seed)
+            , m_burstChance(burstChance)
+            , m_value(0.0f)
+            , m_burstFrames(0) {
+        }
+
+        // Driving thread: a command went out just now
+        void MarkCommandSent() {
+            m_commandSent.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                std::memory_order_release);
+        }
+
+        void TakeReconfigureLatencies(std::vector<int64_t>& out) { m_reconfigureLatencies.TakeAll(out); }
+
+    protected:
+        float GetPercent() override {
+            const int64_t sent = m_commandSent.exchange(0, std::memory_order_acquire);
+            if (sent != 0) {
+                const auto elapsed = std::chrono::steady_clock::now().time_since_epoch() -
+                    std::chrono::steady_clock::duration(sent);
+                m_reconfigureLatencies.Add(std::chrono::duration_cast<std::chrono::microseconds>(elapsed));
+            }
+
+            AdvanceValue();
+            return m_value;
+        }
+
+    private:
+        void AdvanceValue() {
+            std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+            if (m_burstFrames == 0 && chance(m_random) < m_burstChance) {
+                m_burstFrames = 8;
+            }
+
+            // Quiet frames creep, bursts jump by whole percents
+            float gain = (chance(m_random) < 0.1f) ? chance(m_random) * 0.2f : 0.0f;
+            if (m_burstFrames > 0) {
+                gain = 1.0f + chance(m_random) * 9.0f;
+                m_burstFrames--;
+            }
+
+            m_value += gain;
+            if (m_value >= 100.0f) {
+                m_value -= 100.0f; // Level up
+            }
+        }
+
+        std::mt19937 m_random;
+        float m_burstChance;
+        float m_value;
+        int m_burstFrames;
+
+        std::atomic<int64_t> m_commandSent{ 0 }; // steady_clock ticks, 0 when none is pending
+        LatencyLog<RECONFIGURE_SAMPLES> m_reconfigureLatencies;
+    };
+
+    // What the overlay posts to its window for each sink call
+    enum class SoakMessage {
+        XpUpdate,
+        CaptureFailed,
+        RecorderFrozen
+    };
+
+    // Queues the sink calls for the driving thread, as PostMessage queues
+    // them for the overlay's message loop, and keeps the frame latencies
+    class SoakSink : public CaptureSink {
+    public:
+        void OnXpUpdate(float /*percent*/) override { Post(SoakMessage::XpUpdate); }
+        void OnCaptureFailed() override { Post(SoakMessage::CaptureFailed); }
+        void OnRecorderFrozen() override { Post(SoakMessage::RecorderFrozen); }
+
+        void OnFrameProcessed(std::chrono::microseconds elapsed) override { m_latencies.Add(elapsed); }
+
+        bool TryGet(SoakMessage& message) { return m_messages.TryPop(message); }
+        uint64_t GetDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+        void TakeLatencies(std::vector<int64_t>& out) { m_latencies.TakeAll(out); }
+
+    private:
+        void Post(SoakMessage message) {
+            if (!m_messages.TryPush(message)) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        SpscQueue<SoakMessage, MESSAGE_CAPACITY> m_messages;
+        std::atomic<uint64_t> m_dropped{ 0 };
+        LatencyLog<LATENCY_SAMPLES> m_latencies;
+    };
+
+    // One simulated game window: a CaptureSystem on the synthetic device,
+    // driven from the harness thread the way the overlay's UI thread drives
+    // its clients
+    class SoakClient {
+    public:
+        SoakClient(CaptureScheduler& scheduler, const SoakConfig& config, int index)
+            : m_regionRandom(config.seed + index + 0x9e3779b9u)
+            , m_region{ 0, 0, 0, 0 }
+            , m_isStartPending(false)
+            , m_lastReselect(0)
+            , m_lastRestart(0)
+            , m_recorderFreezes(0)
+            , m_captureFailures(0)
+            , m_displayUpdates(0) {
+            auto device = std::make_unique<SoakCaptureDevice>(config.seed + index, config.burstChance);
+            auto sink = std::make_unique<SoakSink>();
+            m_device = device.get();
+            m_sink = sink.get();
+            m_system = std::make_unique<CaptureSystem>(scheduler, std::move(device), std::move(sink));
+
+            std::string channelName;
+            if (!config.channelPrefix.empty()) {
+                channelName = config.channelPrefix + "." + std::to_string(index);
+            }
+            if (!m_system->Initialize(channelName)) {
+                m_captureFailures++;
+                return;
+            }
+            m_system->SetCaptureRate(static_cast<int>(1000000 / config.runPeriod.count()));
+
+            // Start at a random size, then at the largest a region can be:
+            // the pool grows once and holds the most it ever will before
+            // the first checkpoint, however long the run, so any bitmap
+            // created after warm-up is churn
+            m_region = NewRegion();
+            SendStart();
+            m_region = PlaceRegion(MAX_REGION_WIDTH, MAX_REGION_HEIGHT);
+            m_isStartPending = true;
+            SendStart();
+        }
+
+        // Handle what the capture task posted, as the overlay's window
+        // procedure does: format the new value, dump and resume a frozen
+        // recorder, count failed starts
+        void Pump() {
+            SoakMessage message;
+            while (m_sink->TryGet(message)) {
+                switch (message) {
+                case SoakMessage::XpUpdate: {
+                    const CaptureSystem::Display display = m_system->GetDisplay();
+                    XpTextFormat::Format(m_text, display.percent, display.exact);
+                    m_displayUpdates++;
+                    break;
+                }
+                case SoakMessage::CaptureFailed:
+                    m_captureFailures++;
+                    break;
+                case SoakMessage::RecorderFrozen:
+                    // The synthetic signal is clean, so this should never
+                    // happen; if it does, count it and let it record on
+                    m_recorderFreezes++;
+                    m_system->ResumeRecorder();
+                    break;
+                }
+            }
+        }
+
+        // Re-select a region, or restart on the same one, when due. A
+        // restart is StopCapture then StartCapture, as when the user picks
+        // the same game window again; a full queue retries on the next pass.
+        void Reconfigure(const SoakConfig& config) {
+            if (!m_isStartPending) {
+                const uint64_t frames = GetFrames();
+                const bool reselect = config.reselectEveryFrames > 0 &&
+                    frames - m_lastReselect >= static_cast<uint64_t>(config.reselectEveryFrames);
+                const bool restart = config.restartEveryFrames > 0 &&
+                    frames - m_lastRestart >= static_cast<uint64_t>(config.restartEveryFrames);
+                if (!reselect && !restart) return;
+
+                if (reselect) {
+                    m_region = NewRegion();
+                    m_lastReselect = frames;
+                }
+                else if (!m_system->StopCapture()) {
+                    return;
+                }
+                m_lastRestart = frames;
+                m_isStartPending = true;
+            }
+            SendStart();
+        }
+
+        void Shutdown() { m_system->Shutdown(); }
+
+        uint64_t GetFrames() const { return m_device->GetBlitCount(); }
+        uint64_t GetRecorderFreezes() const { return m_recorderFreezes; }
+        uint64_t GetCaptureFailures() const { return m_captureFailures; }
+        uint64_t GetDroppedMessages() const { return m_sink->GetDroppedCount(); }
+        const SyntheticCaptureDevice& GetDevice() const { return *m_device; }
+
+        // Display updates since the last call
+        uint64_t TakeDisplayUpdates() {
+            const uint64_t updates = m_displayUpdates;
+            m_displayUpdates = 0;
+            return updates;
+        }
+
+        void TakeLatencies(std::vector<int64_t>& out) { m_sink->TakeLatencies(out); }
+        void TakeReconfigureLatencies(std::vector<int64_t>& out) { m_device->TakeReconfigureLatencies(out); }
+
+    private:
+        CaptureRect NewRegion() {
+            std::uniform_int_distribution<int> width(MIN_REGION_WIDTH, MAX_REGION_WIDTH);
+            std::uniform_int_distribution<int> height(MIN_REGION_HEIGHT, MAX_REGION_HEIGHT);
+            const int w = width(m_regionRandom);
+            const int h = height(m_regionRandom);
+            return PlaceRegion(w, h);
+        }
+
+        // A w x h region somewhere on the screen
+        CaptureRect PlaceRegion(int w, int h) {
+            std::uniform_int_distribution<int> left(0, SCREEN_WIDTH - w);
+            std::uniform_int_distribution<int> top(0, SCREEN_HEIGHT - h);
+            CaptureRect region;
+            region.left = left(m_regionRandom);
+            region.top = top(m_regionRandom);
+            region.right = region.left + w;
+            region.bottom = region.top + h;
+            return region;
+        }
+
+        void SendStart() {
+            m_device->MarkCommandSent();
+            m_isStartPending = !m_system->StartCapture(m_region);
+        }
+
+        SoakCaptureDevice* m_device;    // Owned by m_system
+        SoakSink* m_sink;               // Likewise
+        std::unique_ptr<CaptureSystem> m_system;
+
+        std::mt19937 m_regionRandom;
+        CaptureRect m_region;
+        bool m_isStartPending;
+        uint64_t m_lastReselect;
+        uint64_t m_lastRestart;
+
+        uint64_t m_recorderFreezes;
+        uint64_t m_captureFailures;
+        uint64_t m_displayUpdates;
+        wchar_t m_text[XpTextFormat::CAPACITY];
+    };
+
+    int64_t Percentile(std::vector<int64_t>& values, double fraction) {
+        if (values.empty()) return 0;
+        const size_t index = static_cast<size_t>(fraction * (values.size() - 1));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    // True if the metric rose across most post-warm-up intervals and ended
+    // more than slack above where warm-up left it
+    template <typename Getter>
+    bool IsGrowing(const std::vector<SoakCheckpoint>& checkpoints, size_t warmup, int64_t slack, Getter get) {
+        if (checkpoints.size() < warmup + 2) return false;
+
+        size_t rises = 0;
+        const size_t steps = checkpoints.size() - 1 - warmup;
+        for (size_t i = warmup + 1; i < checkpoints.size(); i++) {
+            if (get(checkpoints[i]) > get(checkpoints[i - 1])) rises++;
+        }
+        const int64_t growth = get(checkpoints.back()) - get(checkpoints[warmup]);
+        return rises * 4 >= steps * 3 && growth > slack;
+    }
+
+    std::string CheckGrowth(const SoakConfig& config, const std::vector<SoakCheckpoint>& checkpoints) {
+        const size_t warmup = static_cast<size_t>((std::max)(config.warmupCheckpoints, 0));
+        if (checkpoints.size() < warmup + 2) return "Too few checkpoints to judge growth";
+
+        for (const auto& checkpoint : checkpoints) {
+            if (checkpoint.taskCount != static_cast<size_t>(config.clients)) {
+                return "Scheduler task count drifted from the client count";
+            }
+            if (checkpoint.recorderFreezes > 0) {
+                return "Flight recorder froze on a clean signal";
+            }
+            if (checkpoint.captureFailures > 0) {
+                return "Capture failed to start";
+            }
+            if (checkpoint.liveBitmaps > BITMAPS_PER_CLIENT * config.clients) {
+                return "More capture bitmaps alive than the buffer pools allow";
+            }
+        }
+
+        const SoakCheckpoint& base = checkpoints[warmup];
+        for (size_t i = warmup + 1; i < checkpoints.size(); i++) {
+            if (checkpoints[i].handles > base.handles + HANDLE_SLACK) return "Open handles keep growing";
+            if (checkpoints[i].gdiObjects > base.gdiObjects + HANDLE_SLACK) return "GDI objects keep growing";
+            if (checkpoints[i].userObjects > base.userObjects + HANDLE_SLACK) return "USER objects keep growing";
+        }
+        const int64_t residentSlack = static_cast<int64_t>(
+            (std::max)(RESIDENT_SLACK_BYTES, base.residentBytes / 4));
+        if (IsGrowing(checkpoints, warmup, residentSlack,
+            [](const SoakCheckpoint& c) { return static_cast<int64_t>(c.residentBytes); })) {
+            return "Resident memory keeps growing";
+        }
+        // Counting builds hold the steady state to no heap traffic at all
+        if (AllocationCounter::IsEnabled()) {
+            for (size_t i = warmup + 1; i < checkpoints.size(); i++) {
+                if (checkpoints[i].allocations > 0) return "Heap allocations after warm-up";
+            }
+        }
+        if (IsGrowing(checkpoints, warmup, ALLOCATION_SLACK,
+            [](const SoakCheckpoint& c) { return c.liveAllocations; })) {
+            return "Live heap allocations keep growing";
+        }
+        // Every pool holds its largest bitmaps from the start, so the count
+        // is settled by the end of warm-up and must stay there
+        for (size_t i = warmup + 1; i < checkpoints.size(); i++) {
+            if (checkpoints[i].bufferReallocations > base.bufferReallocations) {
+                return "Capture bitmaps reallocated after warm-up";
+            }
+        }
+        const int64_t latencySlack = (std::max)(base.latencyP99Us * 2, LATENCY_FLOOR_US);
+        if (IsGrowing(checkpoints, warmup, latencySlack,
+            [](const SoakCheckpoint& c) { return c.latencyP99Us; })) {
+            return "Frame latency keeps growing";
+        }
+        const int64_t reconfigureSlack = (std::max)(base.reconfigureP99Us * 2, LATENCY_FLOOR_US);
+        if (IsGrowing(checkpoints, warmup, reconfigureSlack,
+            [](const SoakCheckpoint& c) { return c.reconfigureP99Us; })) {
+            return "Reconfiguration latency keeps growing";
+        }
+        return std::string();
+    }
+}
+
+uint64_t SoakHarness::GetResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.WorkingSetSize;
+#else
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file) return 0;
+    unsigned long long total = 0, resident = 0;
+    const int fields = fscanf(file, "%llu %llu", &total, &resident);
+    fclose(file);
+    if (fields != 2) return 0;
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+uint64_t SoakHarness::GetHandleCount() {
+#ifdef _WIN32
+    DWORD count = 0;
+    if (!GetProcessHandleCount(GetCurrentProcess(), &count)) return 0;
+    return count;
+#else
+    DIR* directory = opendir("/proc/self/fd");
+    if (!directory) return 0;
+    uint64_t count = 0;
+    while (const dirent* entry = readdir(directory)) {
+        if (entry->d_name[0] != '.') count++;
+    }
+    closedir(directory);
+    return count > 0 ? count - 1 : 0; // Not the descriptor of the listing itself
+#endif
+}
+
+uint64_t SoakHarness::GetGdiObjectCount() {
+#ifdef _WIN32
+    return GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS);
+#else
+    return 0;
+#endif
+}
+
+uint64_t SoakHarness::GetUserObjectCount() {
+#ifdef _WIN32
+    return GetGuiResources(GetCurrentProcess(), GR_USEROBJECTS);
+#else
+    return 0;
+#endif
+}
+
+SoakReport SoakHarness::Run(const SoakConfig& config) {
+    SoakReport report;
+    if (config.clients <= 0 || config.checkpoints <= 0 || config.framePeriod.count() <= 0 ||
+        config.runPeriod.count() <= 0 || config.runPeriod > std::chrono::seconds(1)) {
+        report.passed = false;
+        report.failure = "Invalid soak configuration";
+        return report;
+    }
+
+    const uint64_t targetFrames = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(config.simulatedDuration) / config.framePeriod);
+    const uint64_t framesPerCheckpoint = (std::max)(targetFrames / config.checkpoints, uint64_t(1));
+
+    // Scheduler first so it outlives the clients
+    CaptureScheduler scheduler;
+    const uint64_t handlesBefore = GetHandleCount();
+    std::vector<std::unique_ptr<SoakClient>> clients;
+    for (int i = 0; i < config.clients; i++) {
+        clients.push_back(std::make_unique<SoakClient>(scheduler, config, i));
+    }
+
+    // Everything the loop below fills is reserved here, so in counting
+    // builds any allocation after warm-up belongs to the capture path
+    report.checkpoints.reserve(static_cast<size_t>(config.checkpoints) + 1);
+    uint64_t lastAllocations = AllocationCounter::GetAllocationCount();
+    std::vector<int64_t> latencies;
+    latencies.reserve(LATENCY_SAMPLES * clients.size());
+    std::vector<int64_t> reconfigureLatencies;
+    reconfigureLatencies.reserve(RECONFIGURE_SAMPLES * clients.size());
+    uint64_t nextCheckpoint = framesPerCheckpoint;
+
+    for (;;) {
+        std::this_thread::sleep_for(config.runPeriod * 4);
+
+        // This thread stands in for the overlay's UI thread
+        uint64_t slowest = UINT64_MAX;
+        for (auto& client : clients) {
+            client->Pump();
+            client->Reconfigure(config);
+            slowest = (std::min)(slowest, client->GetFrames());
+        }
+
+        if (slowest >= nextCheckpoint) {
+            SoakCheckpoint checkpoint;
+            checkpoint.frames = slowest;
+            checkpoint.simulatedHours = std::chrono::duration<double, std::ratio<3600>>(
+                config.framePeriod * slowest).count();
+            checkpoint.residentBytes = GetResidentBytes();
+            checkpoint.liveAllocations = AllocationCounter::GetLiveCount();
+            const uint64_t allocations = AllocationCounter::GetAllocationCount();
+            checkpoint.allocations = allocations - lastAllocations;
+            lastAllocations = allocations;
+            checkpoint.handles = GetHandleCount();
+            checkpoint.gdiObjects = GetGdiObjectCount();
+            checkpoint.userObjects = GetUserObjectCount();
+            checkpoint.taskCount = scheduler.GetTaskCount();
+
+            latencies.clear();
+            reconfigureLatencies.clear();
+            for (auto& client : clients) {
+                const SyntheticCaptureDevice& device = client->GetDevice();
+                checkpoint.bufferBytes += device.GetBitmapBytes();
+                checkpoint.bufferReallocations += device.GetBitmapCreationCount();
+                checkpoint.liveBitmaps += device.GetLiveBitmapCount();
+                checkpoint.recorderFreezes += client->GetRecorderFreezes();
+                checkpoint.captureFailures += client->GetCaptureFailures();
+                checkpoint.displayUpdates += client->TakeDisplayUpdates();
+                client->TakeLatencies(latencies);
+                client->TakeReconfigureLatencies(reconfigureLatencies);
+            }
+            checkpoint.latencyP50Us = Percentile(latencies, 0.50);
+            checkpoint.latencyP99Us = Percentile(latencies, 0.99);
+            checkpoint.latencyMaxUs = Percentile(latencies, 1.0);
+            checkpoint.reconfigureP99Us = Percentile(reconfigureLatencies, 0.99);
+            checkpoint.reconfigureMaxUs = Percentile(reconfigureLatencies, 1.0);
+
+            report.checkpoints.push_back(checkpoint);
+            nextCheckpoint += framesPerCheckpoint;
+        }
+
+        if (slowest >= targetFrames) break;
+    }
+
+    uint64_t droppedMessages = 0;
+    for (auto& client : clients) {
+        client->Shutdown();
+        droppedMessages += client->GetDroppedMessages();
+    }
+    clients.clear();
+
+    report.failure = CheckGrowth(config, report.checkpoints);
+    if (report.failure.empty() && droppedMessages > 0) {
+        report.failure = "Capture events were dropped before the driver saw them";
+    }
+    // Closing every client must give back every bitmap and handle it held
+    if (report.failure.empty() && GetHandleCount() > handlesBefore + HANDLE_SLACK) {
+        report.failure = "Handles left open after the clients closed";
+    }
+    report.passed = report.failure.empty();
+    return report;
+}
+
+std::string SoakReport::ToString() const {
+    std::string text;
+    char line[384];
+    for (const auto& c : checkpoints) {
+        snprintf(line, sizeof(line),
+            "%7.2fh frames=%llu rss=%lluKB live=%lld allocs=%llu bitmaps=%lld/%lluKB realloc=%llu "
+            "handles=%llu gdi=%llu user=%llu tasks=%zu freezes=%llu failures=%llu updates=%llu "
+            "p50=%lldus p99=%lldus max=%lldus reconf_p99=%lldus reconf_max=%lldus\n",
+            c.simulatedHours, static_cast<unsigned long long>(c.frames),
+            static_cast<unsigned long long>(c.residentBytes / 1024),
+            static_cast<long long>(c.liveAllocations), static_cast<unsigned long long>(c.allocations),
+            static_cast<long long>(c.liveBitmaps), static_cast<unsigned long long>(c.bufferBytes / 1024),
+            static_cast<unsigned long long>(c.bufferReallocations),
+            static_cast<unsigned long long>(c.handles), static_cast<unsigned long long>(c.gdiObjects),
+            static_cast<unsigned long long>(c.userObjects), c.taskCount,
+            static_cast<unsigned long long>(c.recorderFreezes),
+            static_cast<unsigned long long>(c.captureFailures),
+            static_cast<unsigned long long>(c.displayUpdates),
+            static_cast<long long>(c.latencyP50Us), static_cast<long long>(c.latencyP99Us),
+            static_cast<long long>(c.latencyMaxUs),
+            static_cast<long long>(c.reconfigureP99Us), static_cast<long long>(c.reconfigureMaxUs));
+        text += line;
+    }
+    text += passed ? "PASS\n" : "FAIL: " + failure + "\n";
+    return text;
+}
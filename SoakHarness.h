@@ -0,0 +1,80 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Headless soak run of the capture path. Each simulated client is a real
+// CaptureSystem on a shared CaptureScheduler, as the overlay runs one per
+// game window, with a SyntheticCaptureDevice in place of the screen and a
+// sink that queues what the overlay would post to its window. The driving
+// thread plays the overlay's UI thread: it formats the XP text for each
+// update the way the window procedure does, and re-selects regions and
+// restarts capture through StartCapture and StopCapture, while the device
+// injects bursts of XP. Scheduler periods are scaled down so hours of
+// simulated capture run in minutes. Resource use is sampled at
+// checkpoints. Each client opens on the largest region first, so capture
+// bitmaps and handles settle during warm-up and the run fails if they move
+// after it; memory and latency fail if they keep growing. Builds with
+// POVERLAY_COUNT_ALLOCATIONS also fail on any heap allocation after warm-up.
+struct SoakConfig {
+    int clients = 4;
+    std::chrono::seconds simulatedDuration = std::chrono::hours(1);
+    std::chrono::milliseconds framePeriod{ 250 };   // Simulated time per frame
+    std::chrono::microseconds runPeriod{ 1000 };    // Real scheduler period per frame
+    int reselectEveryFrames = 60;   // Select a new region, of a new size, this often
+    int restartEveryFrames = 25;    // Restart capture this often
+    float burstChance = 0.02f;      // Per frame chance of a burst of XP gains
+    int checkpoints = 20;
+    int warmupCheckpoints = 4;      // Checkpoints ignored by the growth checks
+    uint32_t seed = 1;
+    std::string channelPrefix = "pOverlay.Soak"; // Empty to skip publishing
+};
+
+struct SoakCheckpoint {
+    double simulatedHours = 0.0;
+    uint64_t frames = 0;            // Frames processed by the slowest client
+    uint64_t residentBytes = 0;
+    int64_t liveAllocations = 0;    // Only counted in POVERLAY_COUNT_ALLOCATIONS builds
+    uint64_t allocations = 0;       // Heap allocations since the previous checkpoint, likewise
+    uint64_t bufferBytes = 0;       // Capture bitmaps held by all clients
+    uint64_t bufferReallocations = 0; // Capture bitmaps created so far, all clients
+    int64_t liveBitmaps = 0;
+    uint64_t handles = 0;           // Kernel handles, or open file descriptors
+    uint64_t gdiObjects = 0;        // Windows only
+    uint64_t userObjects = 0;       // Windows only
+    size_t taskCount = 0;           // Tasks registered with the scheduler
+    uint64_t recorderFreezes = 0;   // Flight recorder freezes so far, all clients
+    uint64_t captureFailures = 0;   // StartCapture that found no buffer, likewise
+    uint64_t displayUpdates = 0;    // XP text formatted since the previous checkpoint
+    int64_t latencyP50Us = 0;       // Per-frame pipeline time since the previous checkpoint
+    int64_t latencyP99Us = 0;
+    int64_t latencyMaxUs = 0;
+    int64_t reconfigureP99Us = 0;   // Time from sending a command to the next blit
+    int64_t reconfigureMaxUs = 0;
+};
+
+struct SoakReport {
+    std::vector<SoakCheckpoint> checkpoints;
+    bool passed = true;
+    std::string failure;
+
+    // One line per checkpoint followed by the verdict
+    std::string ToString() const;
+};
+
+class SoakHarness {
+public:
+    static SoakReport Run(const SoakConfig& config);
+
+    // Resident set / working set of this process, 0 if unavailable
+    static uint64_t GetResidentBytes();
+
+    // Kernel handles on Windows, open file descriptors elsewhere; 0 if unavailable
+    static uint64_t GetHandleCount();
+
+    // GDI and USER objects of this process; 0 off Windows
+    static uint64_t GetGdiObjectCount();
+    static uint64_t GetUserObjectCount();
+};
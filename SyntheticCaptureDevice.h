@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+#include "GdiCapture.h"
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "CaptureDevice.h"
+#include "FrameView.h"
+#include "SyntheticGaugeSource.h"
+
+// CaptureDevice that shows a synthetic gauge instead of the screen, so a
+// CaptureSystem runs without the game, e.g. in the tests and the soak
+// harness. Every blit receives the gauge filling the whole region, as if
+// the region had been drawn exactly around the bar; the value drawn comes
+// from GetPercent on the capture task. Bitmaps live outside the heap and
+// hold a handle each, like the overlay's: DIB sections on Windows and
+// memfd mappings on Linux, so a leaked bitmap shows in the handle counts.
+class SyntheticCaptureDevice : public CaptureDevice {
+public:
+    explicit SyntheticCaptureDevice(const SyntheticGaugeSource& gauge = SyntheticGaugeSource{})
+        : m_gauge(gauge) {
+    }
+
+    ~SyntheticCaptureDevice() override = default;
+
+    bool Open() override {
+        m_isOpen.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Close() override { m_isOpen.store(false, std::memory_order_relaxed); }
+
+    bool CreateBitmap(CaptureBuffer& buffer, int width, int height) override {
+        buffer = CaptureBuffer{};
+        if (width <= 0 || height <= 0) return false;
+
+#ifdef _WIN32
+        if (!GdiCaptureDevice::CreateDibSection(nullptr, buffer, width, height)) return false;
+#else
+        const size_t bytes = static_cast<size_t>(width) * height * FrameView::BYTES_PER_PIXEL;
+#ifdef __linux__
+        const int fd = memfd_create("pOverlay.capture", MFD_CLOEXEC);
+        if (fd < 0) return false;
+        void* bits = ftruncate(fd, static_cast<off_t>(bytes)) == 0 ?
+            mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (bits == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        // The descriptor is the handle; offset by one so descriptor 0 is not null
+        buffer.bitmap = reinterpret_cast<void*>(static_cast<intptr_t>(fd) + 1);
+#else
+        void* bits = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (bits == MAP_FAILED) return false;
+        buffer.bitmap = bits;
+#endif
+        buffer.bits = static_cast<uint8_t*>(bits);
+        buffer.capacityWidth = width;
+        buffer.capacityHeight = height;
+#endif
+
+        m_liveBitmaps.fetch_add(1, std::memory_order_relaxed);
+        m_bitmapBytes.fetch_add(GetBytes(buffer), std::memory_order_relaxed);
+        m_bitmapCreations.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void DestroyBitmap(CaptureBuffer& buffer) override {
+        if (!buffer.bitmap) {
+            buffer = CaptureBuffer{};
+            return;
+        }
+
+        m_liveBitmaps.fetch_sub(1, std::memory_order_relaxed);
+        m_bitmapBytes.fetch_sub(GetBytes(buffer), std::memory_order_relaxed);
+#ifdef _WIN32
+        GdiCaptureDevice::DestroyDibSection(buffer);
+#else
+        munmap(buffer.bits, GetBytes(buffer));
+#ifdef __linux__
+        close(static_cast<int>(reinterpret_cast<intptr_t>(buffer.bitmap) - 1));
+#endif
+        buffer = CaptureBuffer{};
+#endif
+    }
+
+    bool Blit(const CaptureBuffer& buffer, const CaptureRect& region) override {
+        const int width = static_cast<int>(region.right - region.left);
+        const int height = static_cast<int>(region.bottom - region.top);
+        if (!m_isOpen.load(std::memory_order_relaxed) || !buffer.bits ||
+            width > buffer.capacityWidth || height > buffer.capacityHeight) {
+            return false;
+        }
+
+        m_gauge.Draw(buffer.bits, buffer.GetStride(), width, height, GetPercent());
+        m_blits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Value the next blits draw, when GetPercent is not overridden
+    void SetPercent(float percent) { m_percent.store(percent, std::memory_order_relaxed); }
+
+    // Statistics; may be read from any thread
+    bool IsOpen() const { return m_isOpen.load(std::memory_order_relaxed); }
+    uint64_t GetBlitCount() const { return m_blits.load(std::memory_order_relaxed); }
+    int64_t GetLiveBitmapCount() const { return m_liveBitmaps.load(std::memory_order_relaxed); }
+    uint64_t GetBitmapBytes() const { return m_bitmapBytes.load(std::memory_order_relaxed); }
+    uint64_t GetBitmapCreationCount() const { return m_bitmapCreations.load(std::memory_order_relaxed); }
+
+protected:
+    // Called once per blit, on the capture task
+    virtual float GetPercent() { return m_percent.load(std::memory_order_relaxed); }
+
+private:
+    static size_t GetBytes(const CaptureBuffer& buffer) {
+        return static_cast<size_t>(buffer.GetStride()) * buffer.capacityHeight;
+    }
+
+    SyntheticGaugeSource m_gauge;
+    std::atomic<float> m_percent{ 0.0f };
+    std::atomic<bool> m_isOpen{ false };
+    std::atomic<uint64_t> m_blits{ 0 };
+    std::atomic<int64_t> m_liveBitmaps{ 0 };
+    std::atomic<uint64_t> m_bitmapBytes{ 0 };
+    std::atomic<uint64_t> m_bitmapCreations{ 0 };
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "FrameView.h"
+#include "GaugeLayout.h"
+#include "XpBarPalette.h"
+
+// Draws a gauge the way the game does, in memory, so the capture pipeline
+// can run without the game or a screen. Markers are drawn every
+// markerSpacing pixels along the gauge; markers inside the fill use the
+// filled marker colour. Like CaptureBufferPool, the buffer only grows, so
+// shrinking and regrowing within the high-water mark does not reallocate.
+class SyntheticGaugeSource {
+public:
+    explicit SyntheticGaugeSource(const XpBarPalette& palette = {},
+        const GaugeLayout& layout = {}, int markerSpacing = 50)
+        : m_palette(palette)
+        , m_layout(layout)
+        , m_markerSpacing(markerSpacing)
+        , m_width(0)
+        , m_height(0)
+        , m_reallocations(0) {
+    }
+
+    // Change the frame size, as re-selecting a region would
+    void Resize(int width, int height) {
+        m_width = width > 0 ? width : 0;
+        m_height = height > 0 ? height : 0;
+
+        const size_t required = static_cast<size_t>(m_width) * m_height * FrameView::BYTES_PER_PIXEL;
+        if (required > m_pixels.capacity()) {
+            m_reallocations++;
+        }
+        if (required > m_pixels.size()) {
+            m_pixels.resize(required);
+        }
+    }
+
+    // Draw the gauge filled to percent (0-100)
+    void Render(float percent) {
+        Draw(m_pixels.data(), GetStride(), m_width, m_height, percent);
+    }
+
+    // Draw the gauge filled to percent into any width x height block of
+    // BGRX pixels, rows stride bytes apart
+    void Draw(uint8_t* bits, int stride, int width, int height, float percent) const {
+        if (width <= 0 || height <= 0) return;
+
+        const bool isHorizontal = m_layout.orientation == GaugeOrientation::Horizontal;
+        const int length = isHorizontal ? width : height;
+        const int filled = static_cast<int>(length * (percent / 100.0f) + 0.5f);
+
+        if (isHorizontal) {
+            // Paint the first row, then copy it down
+            for (int x = 0; x < width; x++) {
+                SetPixel(bits + static_cast<size_t>(x) * FrameView::BYTES_PER_PIXEL, GetColor(x, length, filled));
+            }
+            for (int y = 1; y < height; y++) {
+                memcpy(bits + static_cast<size_t>(y) * stride, bits, static_cast<size_t>(width) * FrameView::BYTES_PER_PIXEL);
+            }
+            return;
+        }
+
+        for (int y = 0; y < height; y++) {
+            const PaletteColor& color = GetColor(y, length, filled);
+            uint8_t* row = bits + static_cast<size_t>(y) * stride;
+            for (int x = 0; x < width; x++) {
+                SetPixel(row + static_cast<size_t>(x) * FrameView::BYTES_PER_PIXEL, color);
+            }
+        }
+    }
+
+    FrameView GetFrame() const {
+        FrameView frame;
+        frame.data = m_pixels.empty() ? nullptr : m_pixels.data();
+        frame.width = m_width;
+        frame.height = m_height;
+        frame.stride = GetStride();
+        return frame;
+    }
+
+    int GetStride() const { return m_width * FrameView::BYTES_PER_PIXEL; }
+    size_t GetBufferBytes() const { return m_pixels.capacity(); }
+    uint64_t GetReallocationCount() const { return m_reallocations; }
+
+private:
+    // Colour at position (x or y) along a gauge of length pixels, filled pixels full
+    const PaletteColor& GetColor(int position, int length, int filled) const {
+        const int index = m_layout.direction == FillDirection::Reverse ? length - 1 - position : position;
+        const int markerWidth = m_layout.markerWidth;
+        if (markerWidth > 0 && m_markerSpacing > markerWidth && index >= m_markerSpacing) {
+            const int start = index - index % m_markerSpacing;
+            if (index - start < markerWidth && start + markerWidth <= length) {
+                return start + markerWidth <= filled ? m_palette.filledMarker : m_palette.marker;
+            }
+        }
+        return index < filled ? m_palette.fill : m_palette.background;
+    }
+
+    static void SetPixel(uint8_t* pixel, const PaletteColor& color) {
+        pixel[0] = color.blue;
+        pixel[1] = color.green;
+        pixel[2] = color.red;
+        pixel[3] = 0;
+    }
+
+    XpBarPalette m_palette;
+    GaugeLayout m_layout;
+    int m_markerSpacing;
+    int m_width;
+    int m_height;
+    std::vector<uint8_t> m_pixels;
+    uint64_t m_reallocations;
+};
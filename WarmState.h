@@ -0,0 +1,26 @@
+#pragma once
+#include "GaugeLayout.h"
+#include "XpBarPalette.h"
+#include "XpSample.h"
+
+// Analyzer state carried across runs so the first frame after launch can
+// take the incremental path and the overlay can show the last value
+// before any capture has happened.
+struct AnalyzerWarmState {
+    bool valid = false;
+    GaugeReading reading;
+    int frontier = 0;       // Index just past the fill edge along the sampled line
+    int gaugeLength = 0;    // Length of the sampled gauge line the state was measured on
+    XpBarPalette palette;   // Palette the state was measured with
+    GaugeLayout layout;     // Layout the state was measured with
+
+    // State is only reusable on the same gauge line, palette and layout.
+    // Only the length along the gauge counts: the analyzer samples one line
+    // across it, so a band-only capture of that line matches a full one.
+    bool Matches(int length, const XpBarPalette& currentPalette,
+        const GaugeLayout& currentLayout) const {
+        return valid && gaugeLength == length &&
+            palette == currentPalette && layout == currentLayout &&
+            frontier >= 0 && frontier <= length;
+    }
+};
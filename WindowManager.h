@@ -2,6 +2,7 @@
 #include <windows.h>
 #include <string>
 #include <optional>
+#include <vector>
 
 class WindowManager {
 public:
@@ -28,6 +29,31 @@ public:
         return GameWindow{ hwnd, bounds };
     }
 
+    // Every visible, non-minimized Pantheon window, for multiboxing
+    static std::vector<GameWindow> FindPantheonWindows() {
+        std::vector<GameWindow> windows;
+        EnumWindows([](HWND hwnd, LPARAM lParam) -> BOOL {
+            if (!IsPantheonWindow(hwnd)) return TRUE;
+
+            RECT bounds;
+            GetWindowRect(hwnd, &bounds);
+            if (bounds.left <= -32000 || bounds.top <= -32000) return TRUE;
+
+            reinterpret_cast<std::vector<GameWindow>*>(lParam)->push_back(GameWindow{ hwnd, bounds });
+            return TRUE;
+        }, reinterpret_cast<LPARAM>(&windows));
+        return windows;
+    }
+
+    static bool IsPantheonWindow(HWND hwnd) {
+        if (!IsWindowVisible(hwnd)) return false;
+
+        // Exact title "Pantheon"
+        wchar_t title[16];
+        int length = GetWindowTextW(hwnd, title, sizeof(title) / sizeof(wchar_t));
+        return length == 8 && wcscmp(title, L"Pantheon") == 0;
+    }
+
     static std::optional<RECT> GetGameWindowBounds(const GameWindow& gameWindow) {
         // Verify window still exists and is valid
         if (!IsWindow(gameWindow.handle)) {
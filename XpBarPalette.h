@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+
+// A reference colour and the per-channel tolerance used to match it
+struct PaletteColor {
+    uint8_t red = 0;
+    uint8_t green = 0;
+    uint8_t blue = 0;
+    int tolerance = 0;
+
+    bool Matches(uint8_t r, uint8_t g, uint8_t b) const {
+        return abs(r - red) <= tolerance &&
+            abs(g - green) <= tolerance &&
+            abs(b - blue) <= tolerance;
+    }
+
+    bool operator==(const PaletteColor&) const = default;
+};
+
+// Colours the XP bar classifier looks for
+struct XpBarPalette {
+    PaletteColor fill = { 0x2D, 0x67, 0xE2, 20 };         // #2D67E2
+    PaletteColor marker = { 0x99, 0xA6, 0xC0, 12 };       // #99A6C0
+    PaletteColor filledMarker = { 0x9B, 0xB0, 0xED, 12 }; // #9BB0ED
+    PaletteColor background = { 0x00, 0x22, 0x40, 8 };    // #002240
+
+    bool operator==(const XpBarPalette&) const = default;
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+// Result of analyzing one captured frame of a gauge
+struct GaugeReading {
+    float percent = 0.0f;   // 0-100
+    int filledPixels = 0;
+    int totalPixels = 0;
+};
+
+// One published XP sample. Plain data so it can live in shared memory and
+// be read by processes built with a different compiler.
+struct XpSample {
+    static constexpr uint32_t FLAG_LEVEL_WRAPPED = 0x1; // Bar emptied because a level was gained
+    static constexpr uint32_t FLAG_EXACT_XP = 0x2;      // currentXp/maximumXp were read from the XP text
+
+    uint64_t sequence = 0;      // Increments by one per published sample
+    int64_t timestampUs = 0;    // Unix time in microseconds
+    float percent = 0.0f;
+    uint32_t filledPixels = 0;
+    uint32_t totalPixels = 0;
+    uint32_t flags = 0;
+    uint32_t currentXp = 0;
+    uint32_t maximumXp = 0;
+
+    bool IsLevelWrapped() const { return (flags & FLAG_LEVEL_WRAPPED) != 0; }
+    bool HasExactXp() const { return (flags & FLAG_EXACT_XP) != 0; }
+};
+
+static_assert(std::is_trivially_copyable_v<XpSample>, "XpSample is copied through shared memory");
+static_assert(sizeof(XpSample) % sizeof(uint64_t) == 0, "XpSample is stored as whole 64-bit words");
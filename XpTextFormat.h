@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "DigitReader.h"
+
+// Overlay text for a reading: "current / maximum (pp.pp%)" when the exact
+// numbers were read, "pp.pp%" otherwise. Written into a fixed buffer by
+// hand so the per-frame path neither allocates nor depends on the locale.
+namespace XpTextFormat {
+    // Two 10-digit numbers, the separators and a percentage, plus the terminator
+    constexpr size_t CAPACITY = 48;
+
+    struct Writer {
+        wchar_t* buffer;
+        size_t length;
+
+        void Append(wchar_t c) {
+            if (length + 1 < CAPACITY) buffer[length++] = c;
+        }
+
+        void Append(const wchar_t* text) {
+            while (*text) Append(*text++);
+        }
+
+        void AppendUnsigned(uint64_t value, int minimumDigits = 1) {
+            wchar_t digits[20];
+            int count = 0;
+            do {
+                digits[count++] = static_cast<wchar_t>(L'0' + value % 10);
+                value /= 10;
+            } while (value > 0 || count < minimumDigits);
+            while (count > 0) Append(digits[--count]);
+        }
+
+        // Two decimal places, rounded to nearest; negatives show as 0.00
+        void AppendPercent(float percent) {
+            const uint64_t hundredths = percent > 0.0f ? static_cast<uint64_t>(percent * 100.0f + 0.5f) : 0;
+            AppendUnsigned(hundredths / 100);
+            Append(L'.');
+            AppendUnsigned(hundredths % 100, 2);
+            Append(L'%');
+        }
+    };
+
+    // Returns the text length; the buffer is always terminated
+    inline size_t Format(wchar_t (&buffer)[CAPACITY], float percent, const XpTextReading& exact = XpTextReading{}) {
+        Writer writer{ buffer, 0 };
+        if (exact.valid) {
+            writer.AppendUnsigned(exact.current);
+            writer.Append(L" / ");
+            writer.AppendUnsigned(exact.maximum);
+            writer.Append(L" (");
+            writer.AppendPercent(percent);
+            writer.Append(L')');
+        }
+        else {
+            writer.AppendPercent(percent);
+        }
+        buffer[writer.length] = L'\0';
+        return writer.length;
+    }
+}
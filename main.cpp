@@ -4,12 +4,29 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <chrono>
+#include <future>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 #include "resource.h"
 #include "WindowManager.h"
+#include "CaptureBufferPool.h"
+#include "CaptureScheduler.h"
 #include "CaptureSystem.h"
+#include "ClassificationLoupe.h"
 #include "FontManager.h"
 #include "ConfigManager.h"
+#include "CpuGovernor.h"
+#include "GdiCapture.h"
+#include "HotkeyManager.h"
+#include "PaletteTuner.h"
+#include "RegionMapping.h"
+#include "SamplePyramid.h"
+#include "SoakHarness.h"
+#include "XpTextFormat.h"
 
 #pragma comment(lib, "dwmapi.lib")
 #pragma comment(lib, "user32.lib")
@@ -20,94 +37,706 @@ void ShowError(const wchar_t* message) {
     MessageBoxW(nullptr, message, L"Error", MB_ICONEXCLAMATION | MB_OK);
 }
 
-// Application state
-struct AppState {
+// Double buffer kept between paints; only recreated when the window grows
+struct BackBuffer {
+    HDC dc = nullptr;
+    HBITMAP bitmap = nullptr;
+    HGDIOBJ oldBitmap = nullptr;
+    SIZE size = { 0, 0 };
+};
+
+// GDI objects shared by every overlay's paint, created once at startup
+struct PaintResources {
+    HFONT font = nullptr;
+    HBRUSH backgroundBrush = nullptr;   // The color keyed out as transparent
+    HBRUSH selectedBrush = nullptr;
+    HBRUSH drawingBrush = nullptr;
+    HPEN rangePen = nullptr;            // Sparkline min/max
+    HPEN meanPen = nullptr;             // Sparkline mean
+
+    bool Create() {
+        // Try Crimson Text first, fall back to Times New Roman
+        font = CreateFont(24, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
+            DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+            CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Crimson Text");
+        if (!font) {
+            font = CreateFont(20, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
+                DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+                CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Times New Roman");
+        }
+        backgroundBrush = CreateSolidBrush(RGB(128, 128, 128));
+        selectedBrush = CreateSolidBrush(RGB(0, 255, 0));  // Green for selected region
+        drawingBrush = CreateSolidBrush(RGB(255, 0, 0));   // Red for drawing
+        rangePen = CreatePen(PS_SOLID, 1, RGB(45, 103, 226));
+        meanPen = CreatePen(PS_SOLID, 1, RGB(255, 255, 255));
+        return font && backgroundBrush && selectedBrush && drawingBrush && rangePen && meanPen;
+    }
+
+    void Destroy() {
+        HGDIOBJ objects[] = { font, backgroundBrush, selectedBrush, drawingBrush, rangePen, meanPen };
+        for (HGDIOBJ object : objects) {
+            if (object) DeleteObject(object);
+        }
+        *this = PaintResources{};
+    }
+};
+
+// Setup-mode magnifier: the pixels around the cursor, zoomed and tinted by
+// class in a small window beside it. Its DCs and bitmaps are made once, so
+// following the mouse only blits, renders and moves the window.
+struct LoupeView {
+    // Further from the cursor than the captured patch reaches
+    static constexpr int CURSOR_OFFSET = ClassificationLoupe::PATCH_SIZE / 2 + 16;
+
+    HWND window = nullptr;
+    HDC outputDC = nullptr;
+    HGDIOBJ oldOutputBitmap = nullptr;
+    GdiCaptureDevice device;    // Blits the patch from the screen
+    CaptureBufferPool buffers{ device };
+    CaptureBufferPool::Buffer* patch = nullptr;
+    CaptureBufferPool::Buffer* output = nullptr;
+    ClassificationLoupe loupe;
+
+    bool Create(HINSTANCE instance, const XpBarPalette& palette, int zoom) {
+        loupe.Configure(palette, zoom);
+        const int size = loupe.GetOutputSize();
+
+        if (!device.Open()) return false;
+        outputDC = CreateCompatibleDC(nullptr);
+        if (!outputDC) return false;
+
+        patch = buffers.Acquire(ClassificationLoupe::PATCH_SIZE, ClassificationLoupe::PATCH_SIZE);
+        output = buffers.Acquire(size, size);
+        if (!patch || !output) return false;
+        oldOutputBitmap = SelectObject(outputDC, static_cast<HBITMAP>(output->bitmap));
+
+        // Layered, so screen blits without CAPTUREBLT, this one's and the
+        // capture system's, never see it
+        window = CreateWindowEx(WS_EX_TOPMOST | WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE,
+            L"LoupeWindow", L"", WS_POPUP, 0, 0, size, size, nullptr, nullptr, instance, nullptr);
+        if (!window) return false;
+        SetLayeredWindowAttributes(window, 0, 255, LWA_ALPHA);
+        return true;
+    }
+
+    void Destroy() {
+        if (window) DestroyWindow(window);
+        if (outputDC) {
+            if (oldOutputBitmap) SelectObject(outputDC, oldOutputBitmap);
+            DeleteDC(outputDC);
+        }
+        buffers.Clear();
+        device.Close();
+
+        window = nullptr;
+        outputDC = nullptr;
+        oldOutputBitmap = nullptr;
+        patch = output = nullptr;
+    }
+};
+
+// State for one tracked Pantheon window and the overlay drawn over it
+struct OverlayClient {
+    HWND overlay = nullptr;
+    WindowManager::GameWindow gameWindow = {};
+    std::string channelName; // Shared-memory channel this client publishes to
+
     bool isDrawing = false;
-    bool isClickthrough = true;
     bool hasSelectedRegion = false;
     POINT startPoint = { 0, 0 };
     POINT endPoint = { 0, 0 };
-    RECT selectedRegion = { 0, 0, 0, 0 };
-
-    std::unique_ptr<FontManager> fontManager;
-    std::unique_ptr<ConfigManager> configManager;
+    RECT selectedRegion = { 0, 0, 0, 0 }; // Relative to the game window, like every client-side rect
+    RECT textRegion = { 0, 0, 0, 0 };     // XP text for the exact read, when enabled
 
     // Text display members
     POINT textPosition = { 350, 350 };
-    std::wstring xpText = L"0.00%";
+    wchar_t xpText[XpTextFormat::CAPACITY] = L"0.00%";
+    int xpTextLength = 5;
     bool isDraggingText = false;
     POINT dragOffset = { 0, 0 };
 
-	// Game window members
-    std::optional<WindowManager::GameWindow> gameWindow;
+    // XP history for the sparkline, sampled on the window tracking timer
+    float currentPercent = 0.0f;
+    SamplePyramid<> history;
+    RECT sparklineRect = { 0, 0, 0, 0 }; // Where the last paint put it
+    uint64_t sparklineDrawnTotal = 0;    // Bucket total of the level last drawn
+
+    BackBuffer backBuffer;
+
+    std::unique_ptr<CaptureSystem> captureSystem;
+
+    // Flight recorder dump in progress; it reads captureSystem
+    std::future<void> recorderDump;
+    std::chrono::steady_clock::time_point lastRecorderDump;
+    bool hasRecorderDump = false;
+};
+
+// Application state
+struct AppState {
+    bool isClickthrough = true;
+    bool isHudVisible = true;
+
+    HINSTANCE instance = nullptr;
+    int showCommand = SW_SHOWNOACTIVATE;
+
+    // Message-only window that owns hotkeys and window tracking
+    HWND controller = nullptr;
+
+    std::unique_ptr<FontManager> fontManager;
+    PaintResources paint;
+    LoupeView loupe;    // Only has a window when [Loupe] is enabled
+    unsigned recordingCount = 0; // Flight recorder dumps written this session
+    std::unique_ptr<ConfigManager> configManager;
+    ConfigManager::Config config; // Applied to every newly found window
+    HotkeyManager hotkeyManager;
+
+    // Glyph templates for the exact XP read; null when it is disabled
+    std::shared_ptr<const DigitTemplateSet> digitTemplates;
+
+    // Startup timing
+    std::chrono::steady_clock::time_point launchTime = std::chrono::steady_clock::now();
+    bool hasFirstReading = false;
+
+    // Game window tracking
     static constexpr UINT_PTR WINDOW_TRACK_TIMER = 1;
     static constexpr DWORD WINDOW_TRACK_INTERVAL = 500; // Check every 500ms
+    static constexpr int HISTORY_SAMPLES_PER_MINUTE = 60000 / WINDOW_TRACK_INTERVAL;
 
-    // Add CaptureSystem
-    std::unique_ptr<CaptureSystem> captureSystem;
+    // Every client's capture runs on this one scheduler; declared before
+    // clients so it outlives them
+    std::unique_ptr<CaptureScheduler> scheduler;
+
+    // Keeps the scheduler's threads within the configured CPU budget,
+    // polled on the window tracking timer
+    std::unique_ptr<CpuGovernor> governor;
+    static constexpr size_t GOVERNOR_TEXT_CAPACITY = 64;
+    wchar_t governorText[GOVERNOR_TEXT_CAPACITY] = L"";
+    int governorTextLength = 0;
+
+    std::vector<std::unique_ptr<OverlayClient>> clients;
 };
 
 // Global state
 std::unique_ptr<AppState> g_state = std::make_unique<AppState>();
 
-LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
-    switch (msg) {
-    case WM_CREATE: {
-        // Register for raw input (keyboard)
-        RAWINPUTDEVICE rid = {};
-        rid.usUsagePage = 0x01;
-        rid.usUsage = 0x06;  // Keyboard
-        rid.dwFlags = RIDEV_INPUTSINK;
-        rid.hwndTarget = hwnd;
+void SetXpText(OverlayClient& client, float percent, const XpTextReading& exact = XpTextReading{}) {
+    client.xpTextLength = static_cast<int>(XpTextFormat::Format(client.xpText, percent, exact));
+}
+
+// Memory DC of at least width x height for double-buffered painting
+HDC AcquireBackBuffer(OverlayClient& client, HDC reference, int width, int height) {
+    BackBuffer& buffer = client.backBuffer;
+    if (buffer.dc && width <= buffer.size.cx && height <= buffer.size.cy) {
+        return buffer.dc;
+    }
+
+    if (!buffer.dc) {
+        buffer.dc = CreateCompatibleDC(reference);
+        if (!buffer.dc) return nullptr;
+    }
+    HBITMAP bitmap = CreateCompatibleBitmap(reference, width, height);
+    if (!bitmap) return nullptr;
+
+    HGDIOBJ previous = SelectObject(buffer.dc, bitmap);
+    if (buffer.bitmap) {
+        DeleteObject(buffer.bitmap);
+    }
+    else {
+        buffer.oldBitmap = previous;
+    }
+    buffer.bitmap = bitmap;
+    buffer.size = { width, height };
+    return buffer.dc;
+}
+
+void ReleaseBackBuffer(OverlayClient& client) {
+    BackBuffer& buffer = client.backBuffer;
+    if (buffer.dc) {
+        SelectObject(buffer.dc, buffer.oldBitmap);
+        DeleteDC(buffer.dc);
+    }
+    if (buffer.bitmap) {
+        DeleteObject(buffer.bitmap);
+    }
+    buffer = BackBuffer{};
+}
+
+// Log how long the first captured value took to arrive after launch
+void ReportTimeToFirstReading() {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - g_state->launchTime);
+    wchar_t message[96];
+    swprintf_s(message, L"pOverlay: first reading %lld ms after launch\n",
+        static_cast<long long>(elapsed.count()));
+    OutputDebugStringW(message);
+}
+
+// Headless soak run of the capture path: --soak[=hours]. The report
+// goes to the debugger and pOverlay-soak.txt; the exit code is 0 on pass.
+int RunSoak(const char* arguments) {
+    SoakConfig config;
+    const char* hours = strchr(arguments, '=');
+    if (hours && atof(hours + 1) > 0.0) {
+        config.simulatedDuration = std::chrono::seconds(static_cast<long long>(atof(hours + 1) * 3600.0));
+    }
+
+    SoakReport report = SoakHarness::Run(config);
+    std::string text = report.ToString();
+    OutputDebugStringA(text.c_str());
+
+    FILE* file = nullptr;
+    if (fopen_s(&file, "pOverlay-soak.txt", "w") == 0 && file) {
+        fputs(text.c_str(), file);
+        fclose(file);
+    }
+    return report.passed ? 0 : 1;
+}
+
+// Re-analyze a flight recorder dump: --replay=<file>. The report goes to
+// the debugger and pOverlay-replay.txt; the exit code is 0 if it loaded.
+int RunReplay(const char* arguments) {
+    std::string path = strchr(arguments, '=') ? strchr(arguments, '=') + 1 : "";
+    if (path.size() >= 2 && path.front() == '"') {
+        path = path.substr(1, path.find('"', 1) - 1);
+    }
+
+    FlightRecording recording;
+    std::ifstream in(path, std::ios::binary);
+    if (!in || !recording.Load(in)) {
+        ShowError(L"Could not read the flight recording!");
+        return 1;
+    }
+
+    std::string text = recording.Replay();
+    OutputDebugStringA(text.c_str());
+
+    FILE* file = nullptr;
+    if (fopen_s(&file, "pOverlay-replay.txt", "w") == 0 && file) {
+        fputs(text.c_str(), file);
+        fclose(file);
+    }
+    return 0;
+}
+
+// Tune the classifier on a labelled corpus: --tune=<manifest> [--random]
+// [--export]. Searches around the configured palette and gauge; the report
+// goes to the debugger and pOverlay-tune.txt, and --export writes the
+// winning set to config.ini. The exit code is 0 if the search ran.
+int RunTune(const char* commandLine, const char* arguments) {
+    std::string path = strchr(arguments, '=') ? strchr(arguments, '=') + 1 : "";
+    if (path.size() >= 2 && path.front() == '"') {
+        path = path.substr(1, path.find('"', 1) - 1);
+    }
+    else {
+        path = path.substr(0, path.find(' '));
+    }
+
+    TuningCorpus corpus;
+    std::string error;
+    if (!corpus.Load(path, error)) {
+        OutputDebugStringA((error + "\n").c_str());
+        ShowError(L"Could not read the tuning corpus!");
+        return 1;
+    }
+
+    ConfigManager configManager;
+    const ConfigManager::Config config = configManager.LoadConfig();
+    PaletteTunerConfig tuning;
+    tuning.palette = config.palette;
+    tuning.layout = config.gaugeLayout;
+    if (strstr(commandLine, "--random")) {
+        tuning.search = TuningSearch::Random;
+    }
+
+    const TuningReport report = PaletteTuner::Run(corpus, tuning);
+    std::string text = report.ToString();
+    OutputDebugStringA(text.c_str());
+
+    FILE* file = nullptr;
+    if (fopen_s(&file, "pOverlay-tune.txt", "w") == 0 && file) {
+        fputs(text.c_str(), file);
+        fclose(file);
+    }
+
+    if (report.succeeded && strstr(commandLine, "--export")) {
+        configManager.SaveTuning(report.best.front().palette, report.best.front().layout.markerWidth);
+    }
+    return report.succeeded ? 0 : 1;
+}
+
+// Write a frozen flight recorder to the recordings folder on a worker and
+// let it record again; capture carries on meanwhile. An anomaly that keeps
+// recurring is dumped at most once per MinDumpInterval, and only the newest
+// MaxRecordings dumps are kept; the hotkey always dumps.
+void StartRecorderDump(OverlayClient& client) {
+    if (!client.captureSystem) return;
+
+    const FlightRecorderConfig& recorder = g_state->config.recorder;
+    const auto now = std::chrono::steady_clock::now();
+    if (client.hasRecorderDump &&
+        client.captureSystem->GetRecorderFreezeReason() != FlightFreezeReason::Manual &&
+        now - client.lastRecorderDump < std::chrono::seconds(recorder.minDumpIntervalSeconds)) {
+        client.captureSystem->ResumeRecorder();
+        return;
+    }
+    client.lastRecorderDump = now;
+    client.hasRecorderDump = true;
+
+    // The previous dump resumed the recorder before it finished, so this
+    // waits at most for its last few instructions
+    if (client.recorderDump.valid()) {
+        client.recorderDump.get();
+    }
+
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+    wchar_t name[64];
+    swprintf_s(name, L"flight-%04u%02u%02u-%02u%02u%02u-%u.pxfr", time.wYear, time.wMonth, time.wDay,
+        time.wHour, time.wMinute, time.wSecond, g_state->recordingCount++);
+    const std::filesystem::path path = g_state->configManager->GetDataDirectory(L"recordings") / name;
+
+    CaptureSystem* captureSystem = client.captureSystem.get();
+    const size_t keep = static_cast<size_t>((std::max)(recorder.maxRecordings, 1));
+    client.recorderDump = std::async(std::launch::async, [captureSystem, path, keep]() {
+        std::ofstream out(path, std::ios::binary);
+        const bool written = out && captureSystem->WriteRecording(out);
+        captureSystem->ResumeRecorder();
+        out.close();
+        FlightRecordingFiles::Prune(path.parent_path(), keep);
+
+        wchar_t message[MAX_PATH + 64];
+        swprintf_s(message, L"pOverlay: %ls flight recording %ls\n",
+            written ? L"wrote" : L"failed to write", path.c_str());
+        OutputDebugStringW(message);
+    });
+}
+
+OverlayClient* FindClient(HWND overlay) {
+    for (auto& client : g_state->clients) {
+        if (client->overlay == overlay) return client.get();
+    }
+    return nullptr;
+}
+
+bool IsTracked(HWND gameWindow) {
+    for (auto& client : g_state->clients) {
+        if (client->gameWindow.handle == gameWindow) return true;
+    }
+    return false;
+}
 
-        if (!RegisterRawInputDevices(&rid, 1, sizeof(rid))) {
-            ShowError(L"Failed to register raw input devices!");
-            return -1;
+// Size of the game window, which regions are measured against
+SIZE GetWindowSize(const WindowManager::GameWindow& gameWindow) {
+    return { gameWindow.bounds.right - gameWindow.bounds.left,
+        gameWindow.bounds.bottom - gameWindow.bounds.top };
+}
+
+// Window-relative rect to the screen rect the capture reads
+RECT ToScreen(const OverlayClient& client, const RECT& relative) {
+    return RegionMapping::ToScreen(relative, client.gameWindow.bounds.left, client.gameWindow.bounds.top);
+}
+
+// Remember a client's layout as the default for other windows and persist it
+void SaveClientState(const OverlayClient& client) {
+    g_state->config.hasRegion = client.hasSelectedRegion;
+    g_state->config.xpBarRegion = client.selectedRegion;
+    g_state->config.textPosition = client.textPosition;
+    g_state->config.regionReference = GetWindowSize(client.gameWindow);
+    g_state->configManager->SaveCurrentState(
+        client.hasSelectedRegion,
+        client.selectedRegion,
+        client.textPosition,
+        g_state->config.regionReference
+    );
+}
+
+// White text with a one pixel black outline
+void DrawOutlinedText(HDC dc, int x, int y, const wchar_t* text, int length) {
+    SetTextColor(dc, RGB(0, 0, 0));  // Black outline
+    for (int offsetX = -1; offsetX <= 1; offsetX++) {
+        for (int offsetY = -1; offsetY <= 1; offsetY++) {
+            if (offsetX == 0 && offsetY == 0) continue;
+            TextOut(dc, x + offsetX, y + offsetY, text, length);
         }
-        return 0;
     }
 
-    case WM_INPUT: {
-        UINT size = 0;
-        GetRawInputData((HRAWINPUT)lParam, RID_INPUT, nullptr, &size, sizeof(RAWINPUTHEADER));
+    SetTextColor(dc, RGB(255, 255, 255));  // White text
+    TextOut(dc, x, y, text, length);
+}
 
-        std::vector<BYTE> buffer(size);
-        if (GetRawInputData((HRAWINPUT)lParam, RID_INPUT, buffer.data(), &size, sizeof(RAWINPUTHEADER)) != size) {
-            ShowError(L"Failed to get raw input data!");
-            return 0;
+// Bring a client's capture in line with the governor's level
+void ApplyCaptureQuality(OverlayClient& client) {
+    if (!client.captureSystem) return;
+
+    const CpuGovernorConfig& config = g_state->governor->GetConfig();
+    const CaptureQuality level = g_state->governor->GetLevel();
+    client.captureSystem->SetCaptureRate(level >= CaptureQuality::ReducedRate ?
+        config.reducedFramesPerSecond : CaptureSystem::CAPTURE_FPS);
+    client.captureSystem->SetQuality(level, config.sampleStep);
+}
+
+// Start (or restart) capture of a region for a client. The capture task
+// applies the request asynchronously and posts WM_USER_CAPTURE_FAILED if it
+// cannot get a capture buffer.
+bool StartClientCapture(OverlayClient& client, const RECT& region, const AnalyzerWarmState* warmState) {
+    if (!client.captureSystem) {
+        auto captureSystem = std::make_unique<CaptureSystem>(*g_state->scheduler,
+            std::make_unique<GdiCaptureDevice>(), std::make_unique<WindowCaptureSink>(client.overlay));
+        captureSystem->SetPalette(g_state->config.palette);
+        captureSystem->SetGaugeLayout(g_state->config.gaugeLayout);
+        captureSystem->SetConditionerConfig(g_state->config.filter);
+        captureSystem->SetDigitReader(g_state->digitTemplates, g_state->config.digitReader);
+        captureSystem->SetRecorderConfig(g_state->config.recorder);
+        if (!captureSystem->Initialize(client.channelName)) {
+            return false;
         }
+        client.captureSystem = std::move(captureSystem);
 
-        RAWINPUT* raw = reinterpret_cast<RAWINPUT*>(buffer.data());
-        if (raw->header.dwType == RIM_TYPEKEYBOARD) {
-            if (raw->data.keyboard.Message == WM_KEYDOWN) {
-                if (raw->data.keyboard.VKey == VK_F7) {
-                    g_state->isClickthrough = !g_state->isClickthrough;
-
-                    LONG_PTR exStyle = GetWindowLongPtr(hwnd, GWL_EXSTYLE);
-                    if (g_state->isClickthrough) {
-                        exStyle |= WS_EX_TRANSPARENT;
-                        // Keep text visible but make background fully transparent
-                        SetLayeredWindowAttributes(hwnd, RGB(128, 128, 128), 0, LWA_COLORKEY);
-                    }
-                    else {
-                        exStyle &= ~WS_EX_TRANSPARENT;
-                        // Semi-transparent background for setup mode
-                        SetLayeredWindowAttributes(hwnd, 0, 100, LWA_ALPHA);
-                    }
-                    SetWindowLongPtr(hwnd, GWL_EXSTYLE, exStyle);
-
-                    InvalidateRect(hwnd, nullptr, TRUE);
-                }
+        // A window found while degraded starts degraded
+        if (g_state->governor->GetLevel() != CaptureQuality::Full) {
+            ApplyCaptureQuality(client);
+        }
+    }
+
+    // Cached state only carries over when the caller vouches for it
+    const RECT screenRegion = ToScreen(client, region);
+    const RECT screenText = ToScreen(client, client.textRegion);
+    return client.captureSystem->StartCapture(screenRegion,
+        g_state->digitTemplates ? &screenText : nullptr, warmState);
+}
+
+void ApplyClickthrough(HWND hwnd) {
+    LONG_PTR exStyle = GetWindowLongPtr(hwnd, GWL_EXSTYLE);
+    if (g_state->isClickthrough) {
+        exStyle |= WS_EX_TRANSPARENT;
+        // Keep text visible but make background fully transparent
+        SetLayeredWindowAttributes(hwnd, RGB(128, 128, 128), 0, LWA_COLORKEY);
+    }
+    else {
+        exStyle &= ~WS_EX_TRANSPARENT;
+        // Semi-transparent background for setup mode
+        SetLayeredWindowAttributes(hwnd, 0, 100, LWA_ALPHA);
+    }
+    SetWindowLongPtr(hwnd, GWL_EXSTYLE, exStyle);
+
+    InvalidateRect(hwnd, nullptr, TRUE);
+}
+
+// Follow the cursor in setup mode: blit the patch under it, render it and
+// move the loupe beside it
+void UpdateLoupe(HWND overlay, POINT point) {
+    LoupeView& view = g_state->loupe;
+    if (!view.window) return;
+
+    ClientToScreen(overlay, &point);
+    const int patchSize = ClassificationLoupe::PATCH_SIZE;
+    const RECT patchRegion = { point.x - patchSize / 2, point.y - patchSize / 2,
+        point.x - patchSize / 2 + patchSize, point.y - patchSize / 2 + patchSize };
+    view.device.Blit(*view.patch, patchRegion);
+    view.loupe.Render(CaptureBufferPool::MakeView(*view.patch, patchSize, patchSize),
+        view.output->bits, view.output->GetStride());
+
+    // Below and right of the cursor, flipped at the edges of its monitor
+    const int size = view.loupe.GetOutputSize();
+    MONITORINFO monitor = {};
+    monitor.cbSize = sizeof(monitor);
+    GetMonitorInfo(MonitorFromPoint(point, MONITOR_DEFAULTTONEAREST), &monitor);
+    int x = point.x + LoupeView::CURSOR_OFFSET;
+    int y = point.y + LoupeView::CURSOR_OFFSET;
+    if (x + size > monitor.rcMonitor.right) x = point.x - LoupeView::CURSOR_OFFSET - size;
+    if (y + size > monitor.rcMonitor.bottom) y = point.y - LoupeView::CURSOR_OFFSET - size;
+    SetWindowPos(view.window, HWND_TOPMOST, x, y, 0, 0, SWP_NOSIZE | SWP_NOACTIVATE | SWP_SHOWWINDOW);
+    InvalidateRect(view.window, nullptr, FALSE);
+
+    // Hide it again when the cursor leaves the overlay
+    TRACKMOUSEEVENT track = {};
+    track.cbSize = sizeof(track);
+    track.dwFlags = TME_LEAVE;
+    track.hwndTrack = overlay;
+    TrackMouseEvent(&track);
+}
+
+void HideLoupe() {
+    if (g_state->loupe.window) {
+        ShowWindow(g_state->loupe.window, SW_HIDE);
+    }
+}
+
+// Hotkey handlers; they apply to every tracked window
+void OnToggleClickthrough(void* context) {
+    g_state->isClickthrough = !g_state->isClickthrough;
+    for (auto& client : g_state->clients) {
+        ApplyClickthrough(client->overlay);
+    }
+    if (g_state->isClickthrough) {
+        HideLoupe();
+    }
+}
+
+void OnToggleCapturePause(void* context) {
+    for (auto& client : g_state->clients) {
+        if (client->captureSystem) {
+            client->captureSystem->SetPaused(!client->captureSystem->IsPaused());
+        }
+    }
+}
+
+void OnRecalibrate(void* context) {
+    for (auto& client : g_state->clients) {
+        // Re-sync with the game window and rescan the saved region from scratch
+        WindowManager::RefreshOverlayPosition(client->overlay, client->gameWindow);
+        if (client->captureSystem && client->hasSelectedRegion) {
+            const RECT screenRegion = ToScreen(*client, client->selectedRegion);
+            const RECT screenText = ToScreen(*client, client->textRegion);
+            if (!client->captureSystem->Retarget(screenRegion, g_state->digitTemplates ? &screenText : nullptr) ||
+                !client->captureSystem->Recalibrate()) {
+                ShowError(L"Failed to restart capture!");
             }
         }
-        return 0;
+        InvalidateRect(client->overlay, nullptr, TRUE);
+    }
+}
+
+void OnDumpRecorder(void* context) {
+    for (auto& client : g_state->clients) {
+        if (client->captureSystem) {
+            client->captureSystem->TriggerRecorder();
+        }
+    }
+}
+
+// The HUD shows the budget while setting up, or whenever the capture is degraded
+bool IsGovernorTextVisible() {
+    const CpuGovernor& governor = *g_state->governor;
+    return governor.GetConfig().enabled &&
+        (!g_state->isClickthrough || governor.GetLevel() != CaptureQuality::Full);
+}
+
+// Poll the governor, apply a new level to every capture and refresh the HUD line
+void UpdateGovernor() {
+    CpuGovernor& governor = *g_state->governor;
+    if (governor.Poll()) {
+        for (auto& client : g_state->clients) {
+            ApplyCaptureQuality(*client);
+        }
+    }
+
+    wchar_t text[AppState::GOVERNOR_TEXT_CAPACITY];
+    const int length = swprintf_s(text, L"CPU %.2f%% of %.2f%%, %ls", governor.GetUsagePercent(),
+        governor.GetConfig().budgetPercent, GetCaptureQualityName(governor.GetLevel()));
+    if (length < 0 || wcscmp(text, g_state->governorText) == 0) return;
+
+    wcscpy_s(g_state->governorText, text);
+    g_state->governorTextLength = length;
+    for (auto& client : g_state->clients) {
+        InvalidateRect(client->overlay, nullptr, TRUE);
+    }
+}
+
+void OnToggleHud(void* context) {
+    g_state->isHudVisible = !g_state->isHudVisible;
+    for (auto& client : g_state->clients) {
+        InvalidateRect(client->overlay, nullptr, TRUE);
+    }
+}
+
+// Samples the sparkline spans: the configured window, or the whole session
+uint64_t GetSparklineSamples(const OverlayClient& client) {
+    const int minutes = g_state->config.sparklineMinutes;
+    if (minutes <= 0) return client.history.GetSampleCount();
+    return static_cast<uint64_t>(minutes) * AppState::HISTORY_SAMPLES_PER_MINUTE;
+}
+
+size_t GetSparklineLevel(const OverlayClient& client) {
+    return client.history.SelectLevel(GetSparklineSamples(client),
+        static_cast<size_t>(g_state->config.sparklineWidth));
+}
+
+// Min/max range and mean of the pyramid level whose bucket count fits the
+// graph width, newest at the right. Never touches more buckets than pixels.
+void DrawSparkline(HDC hdc, OverlayClient& client, int left, int centerY) {
+    const int width = (std::min)(g_state->config.sparklineWidth, static_cast<int>(SamplePyramid<>::CAPACITY));
+    const int height = g_state->config.sparklineHeight;
+    client.sparklineRect = { left, centerY - height / 2, left + width, centerY - height / 2 + height };
+    if (width <= 0 || height <= 0) return;
+
+    const size_t level = GetSparklineLevel(client);
+    const uint64_t span = (GetSparklineSamples(client) + (uint64_t(1) << level) - 1) >> level;
+    const size_t count = (std::min)(client.history.GetBucketCount(level), static_cast<size_t>(span));
+    client.sparklineDrawnTotal = client.history.GetBucketTotal(level);
+    if (count == 0) return;
+
+    const float pitch = span > 1 ? static_cast<float>(width - 1) / (span - 1) : 0.0f;
+    const int bottom = client.sparklineRect.bottom - 1;
+    auto toY = [&](float percent) {
+        return bottom - static_cast<int>(percent * (height - 1) / 100.0f + 0.5f);
+    };
+
+    POINT means[SamplePyramid<>::CAPACITY];
+    HPEN oldPen = (HPEN)SelectObject(hdc, g_state->paint.rangePen);
+    const size_t first = client.history.GetBucketCount(level) - count;
+    for (size_t i = 0; i < count; i++) {
+        const auto& bucket = client.history.GetBucket(level, first + i);
+        const int x = client.sparklineRect.right - 1 - static_cast<int>((count - 1 - i) * pitch + 0.5f);
+        MoveToEx(hdc, x, toY(bucket.maximum), nullptr);
+        LineTo(hdc, x, toY(bucket.minimum) + 1);
+        means[i] = { x, toY(bucket.GetMean()) };
+    }
+
+    SelectObject(hdc, g_state->paint.meanPen);
+    Polyline(hdc, means, static_cast<int>(count));
+
+    SelectObject(hdc, oldPen);
+}
+
+// Feed every capturing client's value into its history; repaint the
+// sparkline only when the level it draws has gained a bucket
+void SampleHistory() {
+    for (auto& client : g_state->clients) {
+        if (!client->hasSelectedRegion) continue;
+
+        client->history.Add(client->currentPercent);
+        if (g_state->config.showSparkline && !IsRectEmpty(&client->sparklineRect) &&
+            client->history.GetBucketTotal(GetSparklineLevel(*client)) != client->sparklineDrawnTotal) {
+            InvalidateRect(client->overlay, &client->sparklineRect, FALSE);
+        }
     }
+}
 
+LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    // Messages that arrive before the client is registered get default handling
+    OverlayClient* client = FindClient(hwnd);
+    if (!client) {
+        return DefWindowProc(hwnd, msg, wParam, lParam);
+    }
+
+    switch (msg) {
     case WM_USER_XP_UPDATE: {
-        // Update XP text
-        wchar_t* newText = reinterpret_cast<wchar_t*>(lParam);
-        g_state->xpText = newText;
-        free(newText);  // Free the duplicated string
+        // Update XP text from the capture's latest value
+        if (client->captureSystem) {
+            const CaptureSystem::Display display = client->captureSystem->GetDisplay();
+            SetXpText(*client, display.percent, display.exact);
+        }
+        client->currentPercent = static_cast<float>(wParam) / 100.0f;
+
+        if (!g_state->hasFirstReading) {
+            g_state->hasFirstReading = true;
+            ReportTimeToFirstReading();
+        }
+        InvalidateRect(hwnd, nullptr, TRUE);
+        return 0;
+    }
+
+    case WM_USER_RECORDER_FROZEN: {
+        // A misread or the hotkey froze the flight recorder
+        StartRecorderDump(*client);
+        return 0;
+    }
+
+    case WM_USER_CAPTURE_FAILED: {
+        // The capture task could not get a buffer for the region
+        ShowError(L"Failed to start capture!");
+        client->hasSelectedRegion = false;
         InvalidateRect(hwnd, nullptr, TRUE);
         return 0;
     }
@@ -118,115 +747,89 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             RECT textRect;
             GetClientRect(hwnd, &textRect);
             HDC hdc = GetDC(hwnd);
-
-            // Try Crimson Text first, fall back to Times New Roman
-            HFONT font = CreateFont(24, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Crimson Text");
-
-            if (!font) {
-                font = CreateFont(20, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                    DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                    CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Times New Roman");
-            }
-
-            HFONT oldFont = (HFONT)SelectObject(hdc, font);
-            DrawText(hdc, g_state->xpText.c_str(), -1, &textRect,
+            HFONT oldFont = (HFONT)SelectObject(hdc, g_state->paint.font);
+            DrawText(hdc, client->xpText, client->xpTextLength, &textRect,
                 DT_CALCRECT | DT_SINGLELINE);
             SelectObject(hdc, oldFont);
-            DeleteObject(font);
             ReleaseDC(hwnd, hdc);
 
-            textRect.left += g_state->textPosition.x;
-            textRect.right += g_state->textPosition.x;
-            textRect.top += g_state->textPosition.y;
-            textRect.bottom += g_state->textPosition.y;
+            textRect.left += client->textPosition.x;
+            textRect.right += client->textPosition.x;
+            textRect.top += client->textPosition.y;
+            textRect.bottom += client->textPosition.y;
 
             POINT clickPoint = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
             if (PtInRect(&textRect, clickPoint)) {
-                g_state->isDraggingText = true;
-                g_state->dragOffset.x = clickPoint.x - g_state->textPosition.x;
-                g_state->dragOffset.y = clickPoint.y - g_state->textPosition.y;
+                client->isDraggingText = true;
+                client->dragOffset.x = clickPoint.x - client->textPosition.x;
+                client->dragOffset.y = clickPoint.y - client->textPosition.y;
                 return 0;
             }
 
             // Start new drawing regardless of existing region
-            g_state->isDrawing = true;
-            g_state->startPoint.x = GET_X_LPARAM(lParam);
-            g_state->startPoint.y = GET_Y_LPARAM(lParam);
-            g_state->endPoint = g_state->startPoint;
+            client->isDrawing = true;
+            client->startPoint.x = GET_X_LPARAM(lParam);
+            client->startPoint.y = GET_Y_LPARAM(lParam);
+            client->endPoint = client->startPoint;
             SetCapture(hwnd);
         }
         return 0;
     }
 
     case WM_MOUSEMOVE: {
-        if (g_state->isDraggingText) {
-            g_state->textPosition.x = GET_X_LPARAM(lParam) - g_state->dragOffset.x;
-            g_state->textPosition.y = GET_Y_LPARAM(lParam) - g_state->dragOffset.y;
+        if (!g_state->isClickthrough) {
+            UpdateLoupe(hwnd, POINT{ GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) });
+        }
+
+        if (client->isDraggingText) {
+            client->textPosition.x = GET_X_LPARAM(lParam) - client->dragOffset.x;
+            client->textPosition.y = GET_Y_LPARAM(lParam) - client->dragOffset.y;
             InvalidateRect(hwnd, nullptr, TRUE);
             return 0;
         }
 
-        if (g_state->isDrawing) {
-            g_state->endPoint.x = GET_X_LPARAM(lParam);
-            g_state->endPoint.y = GET_Y_LPARAM(lParam);
+        if (client->isDrawing) {
+            client->endPoint.x = GET_X_LPARAM(lParam);
+            client->endPoint.y = GET_Y_LPARAM(lParam);
             InvalidateRect(hwnd, nullptr, TRUE);
         }
         return 0;
     }
 
+    case WM_MOUSELEAVE: {
+        HideLoupe();
+        return 0;
+    }
+
     case WM_LBUTTONUP: {
-        if (g_state->isDraggingText) {
-            g_state->isDraggingText = false;
-            g_state->configManager->SaveCurrentState(
-                g_state->hasSelectedRegion,
-                g_state->selectedRegion,
-                g_state->textPosition
-            );
+        if (client->isDraggingText) {
+            client->isDraggingText = false;
+            SaveClientState(*client);
             return 0;
         }
 
-        if (g_state->isDrawing) {
-            g_state->isDrawing = false;
+        if (client->isDrawing) {
+            client->isDrawing = false;
             ReleaseCapture();
 
             RECT rect;
-            rect.left = min(g_state->startPoint.x, g_state->endPoint.x);
-            rect.top = min(g_state->startPoint.y, g_state->endPoint.y);
-            rect.right = max(g_state->startPoint.x, g_state->endPoint.x);
-            rect.bottom = max(g_state->startPoint.y, g_state->endPoint.y);
+            rect.left = min(client->startPoint.x, client->endPoint.x);
+            rect.top = min(client->startPoint.y, client->endPoint.y);
+            rect.right = max(client->startPoint.x, client->endPoint.x);
+            rect.bottom = max(client->startPoint.y, client->endPoint.y);
 
             // Only set region if it has size
             if (rect.right - rect.left > 0 && rect.bottom - rect.top > 0) {
-                g_state->selectedRegion = rect;
-                g_state->hasSelectedRegion = true;
-
-                // Stop any existing capture before starting a new one
-                if (g_state->captureSystem) {
-                    g_state->captureSystem->StopCapture();
-                }
-                else {
-                    g_state->captureSystem = std::make_unique<CaptureSystem>();
-                    if (!g_state->captureSystem->Initialize(hwnd)) {
-                        ShowError(L"Failed to initialize capture system!");
-                        g_state->captureSystem.reset();
-                        return 0;
-                    }
-                }
+                client->selectedRegion = rect;
+                client->hasSelectedRegion = true;
 
-                // Start capture with new region
-                if (!g_state->captureSystem->StartCapture(rect)) {
+                // Start capture with new region; cached state belongs to the old one
+                if (!StartClientCapture(*client, rect, nullptr)) {
                     ShowError(L"Failed to start capture!");
-                    g_state->captureSystem.reset();
-                    g_state->hasSelectedRegion = false;
+                    client->hasSelectedRegion = false;
                 }
                 else {
-                    g_state->configManager->SaveCurrentState(
-                        g_state->hasSelectedRegion,
-                        g_state->selectedRegion,
-                        g_state->textPosition
-                    );
+                    SaveClientState(*client);
                 }
 
                 InvalidateRect(hwnd, nullptr, TRUE);
@@ -241,119 +844,302 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         // Get client area size
         RECT clientRect;
         GetClientRect(hwnd, &clientRect);
-        // Create memory DC for double buffering
-        HDC memDC = CreateCompatibleDC(hdc);
-        HBITMAP memBitmap = CreateCompatibleBitmap(hdc, clientRect.right, clientRect.bottom);
-        HBITMAP oldBitmap = (HBITMAP)SelectObject(memDC, memBitmap);
+        // Memory DC for double buffering, kept between paints
+        HDC memDC = AcquireBackBuffer(*client, hdc, clientRect.right, clientRect.bottom);
+        if (!memDC) {
+            EndPaint(hwnd, &ps);
+            return 0;
+        }
         // Fill background with the color we're using as transparent
-        HBRUSH bgBrush = CreateSolidBrush(RGB(128, 128, 128));
-        FillRect(memDC, &clientRect, bgBrush);
-        DeleteObject(bgBrush);
+        FillRect(memDC, &clientRect, g_state->paint.backgroundBrush);
 
         // Only show rectangles when not in click-through mode
         if (!g_state->isClickthrough) {
             // Draw selected region if exists
-            if (g_state->hasSelectedRegion) {
-                HBRUSH brush = CreateSolidBrush(RGB(0, 255, 0));  // Green for selected region
-                FrameRect(memDC, &g_state->selectedRegion, brush);
-                DeleteObject(brush);
+            if (client->hasSelectedRegion) {
+                FrameRect(memDC, &client->selectedRegion, g_state->paint.selectedBrush);
             }
             // Draw current rectangle if drawing
-            if (g_state->isDrawing) {
+            if (client->isDrawing) {
                 RECT currentRect;
-                currentRect.left = min(g_state->startPoint.x, g_state->endPoint.x);
-                currentRect.top = min(g_state->startPoint.y, g_state->endPoint.y);
-                currentRect.right = max(g_state->startPoint.x, g_state->endPoint.x);
-                currentRect.bottom = max(g_state->startPoint.y, g_state->endPoint.y);
-                HBRUSH brush = CreateSolidBrush(RGB(255, 0, 0));  // Red for drawing
-                FrameRect(memDC, &currentRect, brush);
-                DeleteObject(brush);
+                currentRect.left = min(client->startPoint.x, client->endPoint.x);
+                currentRect.top = min(client->startPoint.y, client->endPoint.y);
+                currentRect.right = max(client->startPoint.x, client->endPoint.x);
+                currentRect.bottom = max(client->startPoint.y, client->endPoint.y);
+                FrameRect(memDC, &currentRect, g_state->paint.drawingBrush);
             }
         }
 
         // Draw XP text if:
         // 1. We're in setup mode (not click-through), OR
-        // 2. We have a selected region AND the game window is focused
-        bool shouldDrawText = !g_state->isClickthrough ||
-            (g_state->hasSelectedRegion && g_state->gameWindow &&
-                GetForegroundWindow() == g_state->gameWindow->handle);
+        // 2. We have a selected region AND this client's game window is focused
+        // The HUD toggle hides the text in either mode
+        bool shouldDrawText = g_state->isHudVisible && (!g_state->isClickthrough ||
+            (client->hasSelectedRegion &&
+                GetForegroundWindow() == client->gameWindow.handle));
+        client->sparklineRect = { 0, 0, 0, 0 };
         if (shouldDrawText) {
-            // Create and setup font - try Crimson Text first, fall back to Times New Roman
-            HFONT font = CreateFont(24, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Crimson Text");
-
-            if (!font) {
-                font = CreateFont(20, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                    DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                    CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Times New Roman");
-            }
-            HFONT oldFont = (HFONT)SelectObject(memDC, font);
+            HFONT oldFont = (HFONT)SelectObject(memDC, g_state->paint.font);
 
-            // Setup text color and mode
-            SetTextColor(memDC, RGB(255, 255, 255));  // White text
+            // Setup text mode
             SetBkMode(memDC, TRANSPARENT);
 
             // Draw text with outline
-            SetTextColor(memDC, RGB(0, 0, 0));  // Black outline
-            for (int offsetX = -1; offsetX <= 1; offsetX++) {
-                for (int offsetY = -1; offsetY <= 1; offsetY++) {
-                    if (offsetX == 0 && offsetY == 0) continue;
-                    TextOut(memDC,
-                        g_state->textPosition.x + offsetX,
-                        g_state->textPosition.y + offsetY,
-                        g_state->xpText.c_str(),
-                        g_state->xpText.length());
-                }
+            DrawOutlinedText(memDC, client->textPosition.x, client->textPosition.y,
+                client->xpText, client->xpTextLength);
+
+            // Capture CPU usage and level on the line below
+            if (IsGovernorTextVisible()) {
+                SIZE lineSize = {};
+                GetTextExtentPoint32W(memDC, client->xpText, client->xpTextLength, &lineSize);
+                DrawOutlinedText(memDC, client->textPosition.x, client->textPosition.y + lineSize.cy,
+                    g_state->governorText, g_state->governorTextLength);
             }
 
-            // Draw main text
-            SetTextColor(memDC, RGB(255, 255, 255));  // White text
-            TextOut(memDC,
-                g_state->textPosition.x,
-                g_state->textPosition.y,
-                g_state->xpText.c_str(),
-                g_state->xpText.length());
+            // History graph to the right of the text
+            if (g_state->config.showSparkline) {
+                SIZE textSize = {};
+                GetTextExtentPoint32W(memDC, client->xpText, client->xpTextLength, &textSize);
+                DrawSparkline(memDC, *client, client->textPosition.x + textSize.cx + 8,
+                    client->textPosition.y + textSize.cy / 2);
+            }
 
-            // Cleanup font
             SelectObject(memDC, oldFont);
-            DeleteObject(font);
         }
 
         // Copy memory DC to window
         BitBlt(hdc, 0, 0, clientRect.right, clientRect.bottom, memDC, 0, 0, SRCCOPY);
 
-        // Cleanup
-        SelectObject(memDC, oldBitmap);
-        DeleteObject(memBitmap);
-        DeleteDC(memDC);
-
         EndPaint(hwnd, &ps);
         return 0;
     }
 
-    case WM_TIMER: {
-        if (wParam == AppState::WINDOW_TRACK_TIMER && g_state->gameWindow) {
-            // Update overlay position to match game window
-            if (!WindowManager::RefreshOverlayPosition(hwnd, g_state->gameWindow.value())) {
-                // Game window was closed or minimized
-                ShowError(L"Lost connection to Pantheon window!");
-                DestroyWindow(hwnd);
+    default:
+        return DefWindowProc(hwnd, msg, wParam, lParam);
+    }
+}
+
+HWND CreateOverlayWindow(HINSTANCE hInstance, const RECT& bounds) {
+    HWND hwnd = CreateWindowEx(
+        WS_EX_TOPMOST | WS_EX_LAYERED | WS_EX_TRANSPARENT,
+        L"OverlayWindow",
+        L"Game Overlay",
+        WS_POPUP,
+        bounds.left, bounds.top,
+        bounds.right - bounds.left,
+        bounds.bottom - bounds.top,
+        nullptr, nullptr,
+        hInstance,
+        nullptr
+    );
+
+    if (!hwnd) {
+        ShowError(L"Failed to create overlay window!");
+        return nullptr;
+    }
+
+    // Start with color keying for the background
+    SetLayeredWindowAttributes(hwnd, RGB(128, 128, 128), 0, LWA_COLORKEY);
+
+    return hwnd;
+}
+
+// Create an overlay for a newly found game window and start capturing it
+bool AddClient(const WindowManager::GameWindow& gameWindow) {
+    const ConfigManager::Config& config = g_state->config;
+
+    auto client = std::make_unique<OverlayClient>();
+    client->gameWindow = gameWindow;
+    client->textPosition = config.textPosition;
+
+    // The first client keeps the well-known channel name; others are keyed by window
+    bool defaultChannelTaken = false;
+    for (auto& other : g_state->clients) {
+        defaultChannelTaken |= other->channelName == SharedSampleChannel::DEFAULT_NAME;
+    }
+    client->channelName = SharedSampleChannel::DEFAULT_NAME;
+    if (defaultChannelTaken) {
+        char suffix[32];
+        sprintf_s(suffix, ".%llX", static_cast<unsigned long long>(
+            reinterpret_cast<uintptr_t>(gameWindow.handle)));
+        client->channelName += suffix;
+    }
+
+    // Register before creating the window so WndProc can find it
+    OverlayClient& added = *client;
+    g_state->clients.push_back(std::move(client));
+
+    // Create overlay sized to match game window
+    added.overlay = CreateOverlayWindow(g_state->instance, gameWindow.bounds);
+    if (!added.overlay) {
+        g_state->clients.pop_back();
+        return false;
+    }
+    ApplyClickthrough(added.overlay);
+
+    // Saved regions were measured on a window of regionReference size; with
+    // Normalize set they follow the window to a new resolution
+    const SIZE windowSize = GetWindowSize(gameWindow);
+    RECT region = config.xpBarRegion;
+    added.textRegion = config.xpTextRegion;
+    if (config.normalizeRegion && config.regionReference.cx > 0 && config.regionReference.cy > 0) {
+        region = RegionMapping::Rescale(region, config.regionReference.cx, config.regionReference.cy,
+            windowSize.cx, windowSize.cy);
+        added.textRegion = RegionMapping::Rescale(added.textRegion, config.regionReference.cx,
+            config.regionReference.cy, windowSize.cx, windowSize.cy);
+    }
+
+    // Initialize capture if we have a saved region
+    if (config.hasRegion) {
+        const int length = GetGaugeLength(config.gaugeLayout,
+            region.right - region.left, region.bottom - region.top);
+
+        // Show the last known value straight away; the first frame checks it
+        // against the fill edge and only rescans if it moved. The state was
+        // saved from the client on the well-known channel, so only that
+        // client takes it, and only once: other windows' bars are elsewhere.
+        const AnalyzerWarmState* warmState = nullptr;
+        const bool isPrimary = added.channelName == SharedSampleChannel::DEFAULT_NAME;
+        if (isPrimary && config.warmState.Matches(length, config.palette, config.gaugeLayout)) {
+            SetXpText(added, config.warmState.reading.percent);
+            warmState = &config.warmState;
+        }
+
+        added.selectedRegion = region;
+        added.hasSelectedRegion = StartClientCapture(added, region, warmState);
+        if (warmState) {
+            g_state->config.warmState.valid = false;
+        }
+    }
+
+    ShowWindow(added.overlay, g_state->showCommand);
+    UpdateWindow(added.overlay);
+    return true;
+}
+
+void RemoveClient(size_t index) {
+    OverlayClient& client = *g_state->clients[index];
+    if (client.recorderDump.valid()) {
+        client.recorderDump.wait();
+    }
+    if (client.captureSystem) {
+        // Unregister before the window the task posts to goes away
+        client.captureSystem->Shutdown();
+    }
+    ReleaseBackBuffer(client);
+    DestroyWindow(client.overlay);
+    g_state->clients.erase(g_state->clients.begin() + index);
+}
+
+// Follow a moved or resized game window without restarting capture
+void RetargetClient(OverlayClient& client, const RECT& oldBounds) {
+    const SIZE oldSize = { oldBounds.right - oldBounds.left, oldBounds.bottom - oldBounds.top };
+    const SIZE newSize = GetWindowSize(client.gameWindow);
+    if (g_state->config.normalizeRegion && (oldSize.cx != newSize.cx || oldSize.cy != newSize.cy)) {
+        client.selectedRegion = RegionMapping::Rescale(client.selectedRegion,
+            oldSize.cx, oldSize.cy, newSize.cx, newSize.cy);
+        client.textRegion = RegionMapping::Rescale(client.textRegion,
+            oldSize.cx, oldSize.cy, newSize.cx, newSize.cy);
+        InvalidateRect(client.overlay, nullptr, TRUE);
+    }
+
+    if (client.captureSystem && client.hasSelectedRegion) {
+        const RECT screenRegion = ToScreen(client, client.selectedRegion);
+        const RECT screenText = ToScreen(client, client.textRegion);
+        client.captureSystem->Retarget(screenRegion, g_state->digitTemplates ? &screenText : nullptr);
+    }
+}
+
+// Follow window moves, drop clients whose game window closed and pick up new ones
+void SyncClients() {
+    for (size_t i = g_state->clients.size(); i-- > 0;) {
+        OverlayClient& client = *g_state->clients[i];
+
+        // Update overlay position to match game window; a minimized window
+        // is left alone until it comes back
+        const RECT oldBounds = client.gameWindow.bounds;
+        if (!WindowManager::RefreshOverlayPosition(client.overlay, client.gameWindow)) {
+            if (!IsWindow(client.gameWindow.handle)) {
+                RemoveClient(i);
             }
+            continue;
+        }
+
+        if (!EqualRect(&oldBounds, &client.gameWindow.bounds)) {
+            RetargetClient(client, oldBounds);
+        }
+    }
+
+    for (const auto& gameWindow : WindowManager::FindPantheonWindows()) {
+        if (!IsTracked(gameWindow.handle)) {
+            AddClient(gameWindow);
+        }
+    }
+
+    if (g_state->clients.empty()) {
+        // Every game window was closed; stop tracking before the message box
+        // pumps more timer messages
+        KillTimer(g_state->controller, AppState::WINDOW_TRACK_TIMER);
+        ShowError(L"Lost connection to Pantheon window!");
+        DestroyWindow(g_state->controller);
+    }
+}
+
+LRESULT CALLBACK ControllerProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    switch (msg) {
+    case WM_CREATE: {
+        // Bind hotkey actions; only the configured combinations are
+        // registered, so other keystrokes never reach this window
+        HotkeyDispatcher& dispatcher = g_state->hotkeyManager.GetDispatcher();
+        dispatcher.Bind(HotkeyAction::ToggleClickthrough, OnToggleClickthrough, hwnd);
+        dispatcher.Bind(HotkeyAction::ToggleCapturePause, OnToggleCapturePause, hwnd);
+        dispatcher.Bind(HotkeyAction::Recalibrate, OnRecalibrate, hwnd);
+        dispatcher.Bind(HotkeyAction::ToggleHud, OnToggleHud, hwnd);
+        dispatcher.Bind(HotkeyAction::DumpRecorder, OnDumpRecorder, hwnd);
+
+        if (g_state->hotkeyManager.RegisterAll(hwnd, g_state->config.hotkeys) > 0) {
+            ShowError(L"Some hotkeys could not be registered; they may be in use by another application.");
+        }
+        return 0;
+    }
+
+    case WM_HOTKEY: {
+        g_state->hotkeyManager.OnHotkey(wParam);
+        return 0;
+    }
+
+    case WM_TIMER: {
+        if (wParam == AppState::WINDOW_TRACK_TIMER) {
+            SyncClients();
+            SampleHistory();
+            UpdateGovernor();
         }
         return 0;
     }
 
     case WM_DESTROY: {
-        g_state->configManager->SaveCurrentState(
-            g_state->hasSelectedRegion,
-            g_state->selectedRegion,
-            g_state->textPosition
-        );
         KillTimer(hwnd, AppState::WINDOW_TRACK_TIMER);
-        if (g_state->captureSystem) {
-            g_state->captureSystem->StopCapture();
+        g_state->hotkeyManager.UnregisterAll();
+
+        // Persist the state of the client on the well-known channel, the one
+        // AddClient gives it to on the next launch
+        while (!g_state->clients.empty()) {
+            OverlayClient& client = *g_state->clients.front();
+            if (client.captureSystem) {
+                client.captureSystem->Shutdown();
+                if (client.channelName == SharedSampleChannel::DEFAULT_NAME) {
+                    g_state->configManager->SaveWarmState(client.captureSystem->GetWarmState());
+                }
+            }
+            RemoveClient(0);
         }
+
+        g_state->configManager->SaveCurrentState(
+            g_state->config.hasRegion,
+            g_state->config.xpBarRegion,
+            g_state->config.textPosition,
+            g_state->config.regionReference
+        );
         PostQuitMessage(0);
         return 0;
     }
@@ -363,6 +1149,29 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     }
 }
 
+// The loupe only paints its last rendered image and never takes the mouse
+LRESULT CALLBACK LoupeProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    switch (msg) {
+    case WM_PAINT: {
+        PAINTSTRUCT ps;
+        HDC hdc = BeginPaint(hwnd, &ps);
+        const LoupeView& view = g_state->loupe;
+        if (view.outputDC) {
+            const int size = view.loupe.GetOutputSize();
+            BitBlt(hdc, 0, 0, size, size, view.outputDC, 0, 0, SRCCOPY);
+        }
+        EndPaint(hwnd, &ps);
+        return 0;
+    }
+
+    case WM_NCHITTEST:
+        return HTTRANSPARENT;
+
+    default:
+        return DefWindowProc(hwnd, msg, wParam, lParam);
+    }
+}
+
 bool RegisterOverlayClass(HINSTANCE hInstance) {
     WNDCLASSEX wc = {};
     wc.cbSize = sizeof(WNDCLASSEX);
@@ -379,90 +1188,137 @@ bool RegisterOverlayClass(HINSTANCE hInstance) {
         ShowError(L"Failed to register window class!");
         return false;
     }
-    return true;
-}
 
-HWND CreateOverlayWindow(HINSTANCE hInstance, const RECT& bounds) {
-    HWND hwnd = CreateWindowEx(
-        WS_EX_TOPMOST | WS_EX_LAYERED | WS_EX_TRANSPARENT,
-        L"OverlayWindow",
-        L"Game Overlay",
-        WS_POPUP,
-        bounds.left, bounds.top,
-        bounds.right - bounds.left,
-        bounds.bottom - bounds.top,
-        nullptr, nullptr,
-        hInstance,
-        nullptr
-    );
+    // Message-only controller window
+    WNDCLASSEX controller = {};
+    controller.cbSize = sizeof(WNDCLASSEX);
+    controller.lpfnWndProc = ControllerProc;
+    controller.hInstance = hInstance;
+    controller.lpszClassName = L"OverlayController";
 
-    if (!hwnd) {
-        ShowError(L"Failed to create overlay window!");
-        return nullptr;
+    if (!RegisterClassEx(&controller)) {
+        ShowError(L"Failed to register window class!");
+        return false;
     }
 
-    // Start with color keying for the background
-    SetLayeredWindowAttributes(hwnd, RGB(128, 128, 128), 0, LWA_COLORKEY);
+    // Setup-mode magnifier
+    WNDCLASSEX loupe = {};
+    loupe.cbSize = sizeof(WNDCLASSEX);
+    loupe.lpfnWndProc = LoupeProc;
+    loupe.hInstance = hInstance;
+    loupe.lpszClassName = L"LoupeWindow";
 
-    return hwnd;
+    if (!RegisterClassEx(&loupe)) {
+        ShowError(L"Failed to register window class!");
+        return false;
+    }
+    return true;
 }
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    if (const char* soak = strstr(lpCmdLine, "--soak")) {
+        return RunSoak(soak);
+    }
+    if (const char* replay = strstr(lpCmdLine, "--replay")) {
+        return RunReplay(replay);
+    }
+    if (const char* tune = strstr(lpCmdLine, "--tune")) {
+        return RunTune(lpCmdLine, tune);
+    }
+
     if (!RegisterOverlayClass(hInstance)) {
         return 1;
     }
 
+    g_state->instance = hInstance;
+    g_state->showCommand = nCmdShow;
+
     // Initialize ConfigManager before other systems
     g_state->configManager = std::make_unique<ConfigManager>();
-    auto config = g_state->configManager->LoadConfig();
+    g_state->config = g_state->configManager->LoadConfig();
+
+    // Only layouts with a pre-built analyzer can be captured
+    if (!GaugeAnalyzerRegistry::Find(g_state->config.gaugeLayout)) {
+        ShowError(L"Unsupported [Gauge] layout in config.ini, using the XP bar defaults.");
+        g_state->config.gaugeLayout = GaugeLayout{};
+    }
+
+    // Exact XP read needs its glyph templates
+    if (g_state->config.hasTextRegion) {
+        auto templates = std::make_shared<DigitTemplateSet>();
+        std::vector<uint8_t> strip = g_state->configManager->ReadDataFile(g_state->config.digitTemplateFile);
+        if (templates->LoadPgm(strip.data(), strip.size(), g_state->config.digitGlyphs,
+            g_state->config.digitReader.threshold)) {
+            g_state->digitTemplates = std::move(templates);
+        }
+        else {
+            ShowError(L"Could not load the [XpText] digit templates, exact XP is disabled.");
+        }
+    }
 
     // Always start in click-through mode
     g_state->isClickthrough = true;
 
-    // Apply loaded configuration
-    g_state->textPosition = config.textPosition;
-
-    // Initialize FontManager and load Crimson Text font
+    // Load Crimson Text on a worker while we look for the game windows
     g_state->fontManager = std::make_unique<FontManager>();
-    if (!g_state->fontManager->LoadFontFromResource(hInstance, IDR_FONT_CRIMSONTEXT)) {
+    auto fontLoaded = std::async(std::launch::async, [hInstance]() {
+        return g_state->fontManager->LoadFontFromResource(hInstance, IDR_FONT_CRIMSONTEXT);
+    });
+
+    // Find every Pantheon window
+    auto gameWindows = WindowManager::FindPantheonWindows();
+
+    if (!fontLoaded.get()) {
         ShowError(L"Failed to load Crimson Text font!");
         return 1;
     }
 
-    // Find Pantheon window
-    auto gameWindow = WindowManager::FindPantheonWindow();
-    if (!gameWindow) {
-        ShowError(L"Pantheon window not found!");
+    // Fonts, brushes and pens are shared by every paint
+    if (!g_state->paint.Create()) {
+        ShowError(L"Failed to create drawing resources!");
+        g_state->paint.Destroy();
         return 1;
     }
 
-    g_state->gameWindow = gameWindow;
+    // The loupe is a setup aid; the overlay works without it
+    if (g_state->config.loupe.enabled &&
+        !g_state->loupe.Create(hInstance, g_state->config.palette, g_state->config.loupe.zoom)) {
+        ShowError(L"Failed to create the loupe, setup mode will run without it.");
+        g_state->loupe.Destroy();
+    }
 
-    // Create overlay sized to match game window
-    HWND hwnd = CreateOverlayWindow(hInstance, gameWindow->bounds);
-    if (!hwnd) {
+    if (gameWindows.empty()) {
+        ShowError(L"Pantheon window not found!");
         return 1;
     }
 
-    // Initialize capture system if we have a saved region
-    if (config.hasRegion) {
-        g_state->selectedRegion = config.xpBarRegion;
-        g_state->hasSelectedRegion = true;
-
-        g_state->captureSystem = std::make_unique<CaptureSystem>();
-        if (g_state->captureSystem->Initialize(hwnd)) {
-            if (!g_state->captureSystem->StartCapture(config.xpBarRegion)) {
-                g_state->captureSystem.reset();
-                g_state->hasSelectedRegion = false;
-            }
-        }
+    g_state->scheduler = std::make_unique<CaptureScheduler>();
+    g_state->governor = std::make_unique<CpuGovernor>(
+        [] { return g_state->scheduler->GetCpuTime(); },
+        [] {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch());
+        });
+    g_state->governor->Configure(g_state->config.governor);
+
+    g_state->controller = CreateWindowEx(0, L"OverlayController", L"pOverlay", 0,
+        0, 0, 0, 0, HWND_MESSAGE, nullptr, hInstance, nullptr);
+    if (!g_state->controller) {
+        ShowError(L"Failed to create controller window!");
+        return 1;
     }
 
-    // Set timer to track window position
-    SetTimer(hwnd, AppState::WINDOW_TRACK_TIMER, AppState::WINDOW_TRACK_INTERVAL, nullptr);
+    // Create an overlay for each game window
+    for (const auto& gameWindow : gameWindows) {
+        AddClient(gameWindow);
+    }
+    if (g_state->clients.empty()) {
+        DestroyWindow(g_state->controller);
+        return 1;
+    }
 
-    ShowWindow(hwnd, nCmdShow);
-    UpdateWindow(hwnd);
+    // Set timer to track window positions and new or closed windows
+    SetTimer(g_state->controller, AppState::WINDOW_TRACK_TIMER, AppState::WINDOW_TRACK_INTERVAL, nullptr);
 
     MSG msg = {};
     while (GetMessage(&msg, nullptr, 0, 0)) {
@@ -470,5 +1326,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         DispatchMessage(&msg);
     }
 
+    g_state->loupe.Destroy();
+    g_state->paint.Destroy();
+
     return static_cast<int>(msg.wParam);
-}
\ No newline at end of file
+}
@@ -0,0 +1,268 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CaptureSystem.h"
+#include "DigitReader.h"
+#include "SharedSampleChannel.h"
+#include "SyntheticCaptureDevice.h"
+#include "XpTextFormat.h"
+
+#include "Check.h"
+
+namespace {
+    using namespace std::chrono_literals;
+
+    constexpr int FPS = 2000;
+    constexpr uint64_t WARMUP_FRAMES = 500;
+    constexpr uint64_t STEADY_FRAMES = 4000;
+
+    constexpr int BAR_HEIGHT = 12;
+    constexpr int TEXT_WIDTH = 320;
+    constexpr int TEXT_HEIGHT = 20;
+    constexpr int TEXT_MARGIN = 2;      // Blank rows and columns around the glyphs
+    constexpr int GLYPH_GAP = 3;
+    constexpr uint32_t MAXIMUM_XP = 100000;
+
+    const std::string GLYPHS = "0123456789/,";
+
+    // XP that creeps up and wraps, one step per blit, so every frame has
+    // something to analyze and some of them something to announce. Below
+    // the bar it draws the XP text with the reader's own templates, so the
+    // exact read runs on every full-quality frame.
+    class CreepingDevice : public SyntheticCaptureDevice {
+    public:
+        explicit CreepingDevice(std::shared_ptr<const DigitTemplateSet> templates)
+            : m_templates(std::move(templates)) {
+            for (size_t i = 0; i < m_templates->GetCount(); i++) {
+                m_glyphWidths[i] = MeasureGlyph(i);
+            }
+        }
+
+        bool Blit(const CaptureBuffer& buffer, const CaptureRect& region) override {
+            if (!SyntheticCaptureDevice::Blit(buffer, region)) return false;
+
+            // Band-only frames are just the gauge line
+            const int width = static_cast<int>(region.right - region.left);
+            const int height = static_cast<int>(region.bottom - region.top);
+            if (height >= BAR_HEIGHT + TEXT_HEIGHT && width >= TEXT_WIDTH) {
+                DrawText(buffer.bits + static_cast<size_t>(BAR_HEIGHT) * buffer.GetStride(), buffer.GetStride());
+            }
+            return true;
+        }
+
+    protected:
+        float GetPercent() override {
+            m_value += 0.05f;
+            if (m_value >= 100.0f) m_value -= 100.0f;
+            return m_value;
+        }
+
+    private:
+        int MeasureGlyph(size_t index) const {
+            const uint8_t* cell = m_templates->GetCell(index);
+            int width = 0;
+            for (int y = 0; y < m_templates->GetCellHeight(); y++) {
+                for (int x = 0; x < DigitTemplateSet::CELL_WIDTH; x++) {
+                    if (cell[y * DigitTemplateSet::CELL_WIDTH + x] && x + 1 > width) width = x + 1;
+                }
+            }
+            return width;
+        }
+
+        // "current/maximum" with thousands separators, as the game shows it
+        void FormatText(char* text, size_t capacity) const {
+            const uint32_t current = static_cast<uint32_t>(m_value * (MAXIMUM_XP / 100));
+            char currentDigits[16];
+            char maximumDigits[16];
+            std::snprintf(currentDigits, sizeof(currentDigits), "%u", current);
+            std::snprintf(maximumDigits, sizeof(maximumDigits), "%u", MAXIMUM_XP);
+
+            size_t length = 0;
+            for (const char* digits : { currentDigits, maximumDigits }) {
+                const size_t count = std::strlen(digits);
+                for (size_t i = 0; i < count && length + 2 < capacity; i++) {
+                    if (i > 0 && (count - i) % 3 == 0) text[length++] = ',';
+                    text[length++] = digits[i];
+                }
+                if (digits == currentDigits) text[length++] = '/';
+            }
+            text[length] = '\0';
+        }
+
+        void DrawText(uint8_t* bits, int stride) const {
+            for (int y = 0; y < TEXT_HEIGHT; y++) {
+                std::memset(bits + static_cast<size_t>(y) * stride, 0x20,
+                    static_cast<size_t>(TEXT_WIDTH) * FrameView::BYTES_PER_PIXEL);
+            }
+
+            char text[DigitReader::MAX_TEXT_LENGTH];
+            FormatText(text, sizeof(text));
+            int left = TEXT_MARGIN;
+            for (const char* c = text; *c; c++) {
+                const size_t index = GLYPHS.find(*c);
+                const uint8_t* cell = m_templates->GetCell(index);
+                for (int y = 0; y < m_templates->GetCellHeight(); y++) {
+                    uint8_t* row = bits + static_cast<size_t>(TEXT_MARGIN + y) * stride;
+                    for (int x = 0; x < m_glyphWidths[index]; x++) {
+                        if (cell[y * DigitTemplateSet::CELL_WIDTH + x]) {
+                            std::memset(row + static_cast<size_t>(left + x) * FrameView::BYTES_PER_PIXEL, 0xE0, 3);
+                        }
+                    }
+                }
+                left += m_glyphWidths[index] + GLYPH_GAP;
+            }
+        }
+
+        std::shared_ptr<const DigitTemplateSet> m_templates;
+        int m_glyphWidths[DigitTemplateSet::MAX_GLYPHS] = {};
+        float m_value = 0.0f;
+    };
+
+    // Counts announcements for the test thread, which formats them the way
+    // the overlay's window procedure does
+    class CountingSink : public CaptureSink {
+    public:
+        std::atomic<int> updates{ 0 };
+        std::atomic<int> failures{ 0 };
+
+        void OnXpUpdate(float /*percent*/) override { updates.fetch_add(1); }
+        void OnCaptureFailed() override { failures.fetch_add(1); }
+        void OnRecorderFrozen() override {}
+    };
+
+    std::string MakeChannelName() {
+#ifdef _WIN32
+        const unsigned long process = GetCurrentProcessId();
+#else
+        const unsigned long process = static_cast<unsigned long>(getpid());
+#endif
+        return "pOverlay.Test." + std::to_string(process) + ".allocation";
+    }
+
+    CaptureRect MakeRegion(int left, int top, int width, int height) {
+        return CaptureRect{ left, top, left + width, top + height };
+    }
+
+    // Text region right below the bar
+    CaptureRect MakeTextRegion(const CaptureRect& bar) {
+        return MakeRegion(bar.left, bar.bottom, TEXT_WIDTH, TEXT_HEIGHT);
+    }
+
+    std::shared_ptr<const DigitTemplateSet> LoadTemplates(const std::string& dataDirectory) {
+        std::ifstream in(dataDirectory + "/digits.pgm", std::ios::binary);
+        const std::vector<uint8_t> strip((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        auto templates = std::make_shared<DigitTemplateSet>();
+        CHECK(templates->LoadPgm(strip.data(), strip.size(), GLYPHS, DigitReaderConfig{}.threshold));
+        return templates;
+    }
+
+    struct Totals {
+        int formatted = 0;
+        int exact = 0;
+        int published = 0;
+    };
+
+    // Play the UI thread until the device has blitted frames more: format
+    // each update, read the published sample, and every so often move the
+    // capture or restart it
+    void Drive(CaptureSystem& system, const CreepingDevice& device, CountingSink& sink,
+        SharedSampleReader& reader, uint64_t frames, Totals& totals) {
+        const uint64_t target = device.GetBlitCount() + frames;
+        const auto deadline = std::chrono::steady_clock::now() + 30s;
+        wchar_t text[XpTextFormat::CAPACITY];
+        uint64_t lastSequence = 0;
+        int step = 0;
+        while (device.GetBlitCount() < target) {
+            CHECK(std::chrono::steady_clock::now() < deadline);
+            std::this_thread::sleep_for(1ms);
+
+            if (sink.updates.exchange(0) > 0) {
+                const CaptureSystem::Display display = system.GetDisplay();
+                XpTextFormat::Format(text, display.percent, display.exact);
+                totals.formatted++;
+                if (display.exact.valid) {
+                    CHECK(display.exact.maximum == MAXIMUM_XP);
+                    totals.exact++;
+                }
+            }
+            XpSample sample;
+            if (reader.ReadNewer(lastSequence, sample)) {
+                lastSequence = sample.sequence;
+                totals.published++;
+            }
+
+            step++;
+            const CaptureRect region = MakeRegion(step % 7 * 10, 100, 400, BAR_HEIGHT);
+            const CaptureRect textRegion = MakeTextRegion(region);
+            if (step % 200 == 0) {
+                CHECK(system.StopCapture());
+                CHECK(system.StartCapture(region, &textRegion));
+            }
+            else if (step % 20 == 0) {
+                CHECK(system.Retarget(region, &textRegion));
+            }
+        }
+    }
+
+    void TestSteadyStateDoesNotAllocate(const std::string& dataDirectory) {
+        CHECK(AllocationCounter::IsEnabled());
+
+        const std::string channelName = MakeChannelName();
+        const std::shared_ptr<const DigitTemplateSet> templates = LoadTemplates(dataDirectory);
+        CaptureScheduler scheduler(1);
+        auto ownedDevice = std::make_unique<CreepingDevice>(templates);
+        auto ownedSink = std::make_unique<CountingSink>();
+        const CreepingDevice& device = *ownedDevice;
+        CountingSink& sink = *ownedSink;
+        CaptureSystem system(scheduler, std::move(ownedDevice), std::move(ownedSink));
+        system.SetDigitReader(templates, DigitReaderConfig{});
+        CHECK(system.Initialize(channelName));
+        SharedSampleReader reader;
+        CHECK(reader.Open(channelName.c_str()));
+
+        // Warm-up fills the buffer pool, the analyzer's, the text reader's
+        // and the recorder's scratch, and whatever the runtime sets up on
+        // first use
+        CHECK(system.SetCaptureRate(FPS));
+        const CaptureRect region = MakeRegion(0, 100, 400, BAR_HEIGHT);
+        const CaptureRect textRegion = MakeTextRegion(region);
+        CHECK(system.StartCapture(region, &textRegion));
+        Totals totals;
+        Drive(system, device, sink, reader, WARMUP_FRAMES, totals);
+
+        const uint64_t before = AllocationCounter::GetAllocationCount();
+        totals = Totals{};
+        Drive(system, device, sink, reader, STEADY_FRAMES, totals);
+        const uint64_t allocations = AllocationCounter::GetAllocationCount() - before;
+
+        std::printf("steady state: %llu frames, %d formatted, %d exact, %d published, %llu allocations\n",
+            static_cast<unsigned long long>(STEADY_FRAMES), totals.formatted, totals.exact, totals.published,
+            static_cast<unsigned long long>(allocations));
+        CHECK(allocations == 0);
+        CHECK(totals.formatted > 0);
+        CHECK(totals.exact > 0);
+        CHECK(totals.published > 0);
+        CHECK(sink.failures.load() == 0);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: AllocationTest <data directory>\n");
+        return 2;
+    }
+
+    TestSteadyStateDoesNotAllocate(argv[1]);
+    return 0;
+}
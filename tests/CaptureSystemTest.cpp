@@ -0,0 +1,247 @@
+#include "CaptureSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+#include "SyntheticCaptureDevice.h"
+
+#include "Check.h"
+
+namespace {
+    using namespace std::chrono_literals;
+
+    constexpr int FAST_FPS = 1000;
+
+    // Counts what the capture task announces
+    class RecordingSink : public CaptureSink {
+    public:
+        std::atomic<int> updates{ 0 };
+        std::atomic<int> failures{ 0 };
+        std::atomic<int> freezes{ 0 };
+
+        void OnXpUpdate(float /*percent*/) override { updates.fetch_add(1); }
+        void OnCaptureFailed() override { failures.fetch_add(1); }
+        void OnRecorderFrozen() override { freezes.fetch_add(1); }
+    };
+
+    // Remembers the size of the last blit
+    class RecordingDevice : public SyntheticCaptureDevice {
+    public:
+        std::atomic<int> lastWidth{ 0 };
+        std::atomic<int> lastHeight{ 0 };
+        bool failBitmaps = false;
+
+        bool CreateBitmap(CaptureBuffer& buffer, int width, int height) override {
+            if (failBitmaps) {
+                buffer = CaptureBuffer{};
+                return false;
+            }
+            return SyntheticCaptureDevice::CreateBitmap(buffer, width, height);
+        }
+
+        bool Blit(const CaptureBuffer& buffer, const CaptureRect& region) override {
+            lastWidth.store(region.right - region.left);
+            lastHeight.store(region.bottom - region.top);
+            return SyntheticCaptureDevice::Blit(buffer, region);
+        }
+    };
+
+    // A CaptureSystem with its device and sink still reachable
+    struct Fixture {
+        CaptureScheduler scheduler{ 1 };
+        RecordingDevice* device = nullptr;
+        RecordingSink* sink = nullptr;
+        std::unique_ptr<CaptureSystem> system;
+
+        Fixture() {
+            auto ownedDevice = std::make_unique<RecordingDevice>();
+            auto ownedSink = std::make_unique<RecordingSink>();
+            device = ownedDevice.get();
+            sink = ownedSink.get();
+            system = std::make_unique<CaptureSystem>(scheduler, std::move(ownedDevice), std::move(ownedSink));
+        }
+    };
+
+    CaptureRect MakeRegion(int left, int top, int width, int height) {
+        return CaptureRect{ left, top, left + width, top + height };
+    }
+
+    template <typename Predicate>
+    bool WaitFor(Predicate predicate) {
+        const auto deadline = std::chrono::steady_clock::now() + 2s;
+        while (!predicate()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
+
+    bool WaitForBlits(const RecordingDevice& device, uint64_t count) {
+        return WaitFor([&]() { return device.GetBlitCount() >= count; });
+    }
+
+    // True if no blit happens for a while, once a frame in progress is done
+    bool IsIdle(const RecordingDevice& device) {
+        std::this_thread::sleep_for(20ms);
+        const uint64_t blits = device.GetBlitCount();
+        std::this_thread::sleep_for(30ms);
+        return device.GetBlitCount() == blits;
+    }
+
+    void TestStartPublishesAndStopIdles() {
+        Fixture fixture;
+        CHECK(fixture.system->Initialize(""));
+        CHECK(fixture.device->IsOpen());
+
+        // At 4 fps a frame would be 250 ms away; the wake starts it at once
+        fixture.device->SetPercent(37.5f);
+        const auto start = std::chrono::steady_clock::now();
+        CHECK(fixture.system->StartCapture(MakeRegion(100, 50, 400, 12)));
+        CHECK(WaitForBlits(*fixture.device, 1));
+        CHECK(std::chrono::steady_clock::now() - start < 200ms);
+        CHECK(WaitFor([&]() { return fixture.sink->updates.load() > 0; }));
+        CHECK(std::fabs(fixture.system->GetDisplay().percent - 37.5f) < 1.0f);
+        CHECK(fixture.device->GetLiveBitmapCount() == 1);
+
+        // XP moves on and the rate goes up
+        CHECK(fixture.system->SetCaptureRate(FAST_FPS));
+        fixture.device->SetPercent(62.5f);
+        CHECK(WaitFor([&]() { return std::fabs(fixture.system->GetDisplay().percent - 62.5f) < 1.0f; }));
+
+        // Stopping keeps the bitmap in the pool for the next start
+        CHECK(fixture.system->StopCapture());
+        CHECK(IsIdle(*fixture.device));
+        CHECK(fixture.device->GetLiveBitmapCount() == 1);
+        CHECK(fixture.sink->failures.load() == 0);
+
+        const uint64_t blits = fixture.device->GetBlitCount();
+        CHECK(fixture.system->StartCapture(MakeRegion(100, 50, 400, 12)));
+        CHECK(WaitForBlits(*fixture.device, blits + 10));
+        CHECK(fixture.device->GetBitmapCreationCount() == 1);
+
+        fixture.system->Shutdown();
+        CHECK(IsIdle(*fixture.device));
+    }
+
+    void TestRetargetKeepsFittingBuffer() {
+        Fixture fixture;
+        CHECK(fixture.system->Initialize(""));
+        CHECK(fixture.system->SetCaptureRate(FAST_FPS));
+
+        // Moves keep the buffer, and so does a size it still holds
+        CHECK(fixture.system->StartCapture(MakeRegion(0, 0, 400, 12)));
+        CHECK(WaitForBlits(*fixture.device, 1));
+        CHECK(fixture.system->Retarget(MakeRegion(300, 200, 400, 12)));
+        CHECK(fixture.system->Retarget(MakeRegion(300, 200, 420, 14)));
+        CHECK(WaitFor([&]() { return fixture.device->lastWidth.load() == 420; }));
+        CHECK(fixture.device->GetBitmapCreationCount() == 1);
+
+        // A larger one needs another bitmap, the pool holds at most two
+        CHECK(fixture.system->Retarget(MakeRegion(300, 200, 1000, 12)));
+        CHECK(WaitFor([&]() { return fixture.device->lastWidth.load() == 1000; }));
+        CHECK(fixture.device->GetBitmapCreationCount() == 2);
+        CHECK(fixture.device->GetLiveBitmapCount() <= 2);
+
+        // Ignored while stopped
+        CHECK(fixture.system->StopCapture());
+        CHECK(fixture.system->Retarget(MakeRegion(0, 0, 200, 12)));
+        CHECK(IsIdle(*fixture.device));
+    }
+
+    void TestPauseAndResume() {
+        Fixture fixture;
+        CHECK(fixture.system->Initialize(""));
+        CHECK(fixture.system->SetCaptureRate(FAST_FPS));
+        CHECK(fixture.system->StartCapture(MakeRegion(0, 0, 400, 12)));
+        CHECK(WaitForBlits(*fixture.device, 5));
+
+        CHECK(fixture.system->SetPaused(true));
+        CHECK(fixture.system->IsPaused());
+        CHECK(IsIdle(*fixture.device));
+
+        const uint64_t blits = fixture.device->GetBlitCount();
+        CHECK(fixture.system->SetPaused(false));
+        CHECK(!fixture.system->IsPaused());
+        CHECK(WaitForBlits(*fixture.device, blits + 5));
+    }
+
+    void TestQualityAndRate() {
+        Fixture fixture;
+        CHECK(fixture.system->Initialize(""));
+        CHECK(!fixture.system->SetCaptureRate(0));
+        CHECK(fixture.system->SetCaptureRate(FAST_FPS));
+        CHECK(fixture.system->StartCapture(MakeRegion(0, 0, 400, 12)));
+        CHECK(WaitFor([&]() { return fixture.device->lastHeight.load() == 12; }));
+
+        // Band only blits the one row the analyzer samples
+        CHECK(fixture.system->SetQuality(CaptureQuality::BandOnly, 1));
+        CHECK(WaitFor([&]() { return fixture.device->lastHeight.load() == 1; }));
+        CHECK(fixture.device->lastWidth.load() == 400);
+
+        CHECK(fixture.system->SetQuality(CaptureQuality::Full, 1));
+        CHECK(WaitFor([&]() { return fixture.device->lastHeight.load() == 12; }));
+    }
+
+    void TestRecalibrateRepublishes() {
+        Fixture fixture;
+        CHECK(fixture.system->Initialize(""));
+        CHECK(fixture.system->SetCaptureRate(FAST_FPS));
+        fixture.device->SetPercent(25.0f);
+        CHECK(fixture.system->StartCapture(MakeRegion(0, 0, 400, 12)));
+        CHECK(WaitFor([&]() { return fixture.sink->updates.load() > 0; }));
+
+        // A steady value is announced once; a recalibrated pipeline starts
+        // over and announces it again
+        std::this_thread::sleep_for(20ms);
+        const int updates = fixture.sink->updates.load();
+        std::this_thread::sleep_for(20ms);
+        CHECK(fixture.sink->updates.load() == updates);
+        CHECK(fixture.system->Recalibrate());
+        CHECK(WaitFor([&]() { return fixture.sink->updates.load() > updates; }));
+        CHECK(std::fabs(fixture.system->GetDisplay().percent - 25.0f) < 1.0f);
+    }
+
+    void TestStartWithoutBufferFails() {
+        Fixture fixture;
+        fixture.device->failBitmaps = true;
+        CHECK(fixture.system->Initialize(""));
+        CHECK(fixture.system->StartCapture(MakeRegion(0, 0, 400, 12)));
+        CHECK(WaitFor([&]() { return fixture.sink->failures.load() == 1; }));
+        CHECK(IsIdle(*fixture.device));
+        CHECK(fixture.device->GetBlitCount() == 0);
+    }
+
+    void TestShutdownDrainsQueue() {
+        // Without Initialize no task runs, so commands only queue up
+        Fixture fixture;
+        int queued = 0;
+        while (fixture.system->StartCapture(MakeRegion(0, 0, 400 + queued, 12)) && queued < 100) {
+            queued++;
+        }
+        CHECK(queued == 32);
+        CHECK(fixture.device->GetBitmapCreationCount() == 0);
+
+        // Shutdown applies them in order on the calling thread and lets go
+        // of the buffer; the queue takes commands again
+        fixture.system->Shutdown();
+        CHECK(fixture.device->GetBitmapCreationCount() == 1);
+        CHECK(fixture.device->GetLiveBitmapCount() == 1);
+        CHECK(fixture.device->GetBlitCount() == 0);
+        CHECK(fixture.sink->failures.load() == 0);
+        CHECK(fixture.system->StopCapture());
+    }
+}
+
+int main() {
+    TestStartPublishesAndStopIdles();
+    TestRetargetKeepsFittingBuffer();
+    TestPauseAndResume();
+    TestQualityAndRate();
+    TestRecalibrateRepublishes();
+    TestStartWithoutBufferFails();
+    TestShutdownDrainsQueue();
+    return 0;
+}
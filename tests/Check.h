@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+
+// Assertion for the portable tests. Unlike assert it stays active in
+// release builds; a failure prints where it happened and exits non-zero.
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (false)
@@ -0,0 +1,226 @@
+#include "ClassificationLoupe.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "SyntheticGaugeSource.h"
+
+#include "Check.h"
+
+// Run with the data directory as the first argument. Passing --update as
+// the second rewrites the golden image after an intended change to the
+// loupe's tints; review the new image before committing it.
+
+namespace {
+    constexpr int PATCH_WIDTH = ClassificationLoupe::PATCH_SIZE;
+    constexpr int PATCH_HEIGHT = 50;    // Shorter than the loupe, so the bottom stays black
+
+    std::string g_dataDirectory;
+    bool g_update = false;
+
+    // A patch off the edge of the XP bar: the bar with its markers across
+    // the middle, with noise in the rows above and below where the XP text
+    // and the game's UI would be. Deterministic on every platform.
+    std::vector<uint8_t> MakePatch() {
+        SyntheticGaugeSource source(XpBarPalette{}, GaugeLayout{}, 12);
+        source.Resize(PATCH_WIDTH, 20);
+        source.Render(45.0f);
+        const FrameView bar = source.GetFrame();
+
+        std::mt19937 random(42);
+        std::vector<uint8_t> pixels(static_cast<size_t>(PATCH_WIDTH) * PATCH_HEIGHT * FrameView::BYTES_PER_PIXEL);
+        for (int y = 0; y < PATCH_HEIGHT; y++) {
+            for (int x = 0; x < PATCH_WIDTH; x++) {
+                uint8_t* pixel = pixels.data() + (static_cast<size_t>(y) * PATCH_WIDTH + x) * FrameView::BYTES_PER_PIXEL;
+                const int barRow = y - 15;
+                if (barRow >= 0 && barRow < bar.height) {
+                    std::memcpy(pixel, bar.PixelAt(x, barRow), FrameView::BYTES_PER_PIXEL);
+                    // Anti-aliased top and bottom edges: off-palette blends
+                    if (barRow == 0 || barRow == bar.height - 1) {
+                        pixel[0] = static_cast<uint8_t>(pixel[0] / 2 + 0x20);
+                        pixel[1] = static_cast<uint8_t>(pixel[1] / 2 + 0x20);
+                    }
+                }
+                else {
+                    const uint32_t value = random();
+                    pixel[0] = static_cast<uint8_t>(value);
+                    pixel[1] = static_cast<uint8_t>(value >> 8);
+                    pixel[2] = static_cast<uint8_t>(value >> 16);
+                    pixel[3] = 0;
+                }
+            }
+        }
+        return pixels;
+    }
+
+    FrameView MakeView(const std::vector<uint8_t>& pixels) {
+        FrameView view;
+        view.data = pixels.data();
+        view.width = PATCH_WIDTH;
+        view.height = PATCH_HEIGHT;
+        view.stride = PATCH_WIDTH * FrameView::BYTES_PER_PIXEL;
+        return view;
+    }
+
+    // Binary PPM (P6) as packed BGRX, the layout the loupe writes
+    bool ReadPpm(const std::string& path, std::vector<uint32_t>& pixels, int& width, int& height) {
+        std::ifstream in(path, std::ios::binary);
+        std::string magic;
+        int maxval = 0;
+        if (!(in >> magic >> width >> height >> maxval) || magic != "P6" || maxval != 255) return false;
+        in.get();
+
+        const std::vector<char> raster((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (raster.size() != static_cast<size_t>(width) * height * 3) return false;
+        pixels.resize(static_cast<size_t>(width) * height);
+        for (size_t i = 0; i < pixels.size(); i++) {
+            pixels[i] = static_cast<uint32_t>(static_cast<uint8_t>(raster[i * 3 + 2])) |
+                (static_cast<uint32_t>(static_cast<uint8_t>(raster[i * 3 + 1])) << 8) |
+                (static_cast<uint32_t>(static_cast<uint8_t>(raster[i * 3 + 0])) << 16);
+        }
+        return true;
+    }
+
+    bool WritePpm(const std::string& path, const std::vector<uint32_t>& pixels, int width, int height) {
+        std::ofstream out(path, std::ios::binary);
+        out << "P6\n" << width << " " << height << "\n255\n";
+        for (uint32_t pixel : pixels) {
+            const char rgb[3] = {
+                static_cast<char>(pixel >> 16), static_cast<char>(pixel >> 8), static_cast<char>(pixel),
+            };
+            out.write(rgb, sizeof(rgb));
+        }
+        return static_cast<bool>(out);
+    }
+
+    // Render into a buffer with padding past each row, which must stay untouched
+    std::vector<uint32_t> Render(ClassificationLoupe& loupe, const FrameView& patch) {
+        const int size = loupe.GetOutputSize();
+        const int padding = 3;
+        const int stride = (size + padding) * FrameView::BYTES_PER_PIXEL;
+        std::vector<uint32_t> buffer(static_cast<size_t>(size + padding) * size, 0xABABABABu);
+        loupe.Render(patch, reinterpret_cast<uint8_t*>(buffer.data()), stride);
+
+        std::vector<uint32_t> image(static_cast<size_t>(size) * size);
+        for (int y = 0; y < size; y++) {
+            const uint32_t* row = buffer.data() + static_cast<size_t>(y) * (size + padding);
+            for (int x = 0; x < size; x++) {
+                CHECK((row[x] & 0xFF000000u) == 0); // X byte cleared
+                image[static_cast<size_t>(y) * size + x] = row[x];
+            }
+            for (int x = size; x < size + padding; x++) {
+                CHECK(row[x] == 0xABABABABu);
+            }
+        }
+        return image;
+    }
+
+    // At zoom 1 the output is the tinted patch itself; compare it with the
+    // checked-in golden image
+    void TestMatchesGolden() {
+        const std::vector<uint8_t> pixels = MakePatch();
+        ClassificationLoupe loupe;
+        loupe.Configure(XpBarPalette{}, 1);
+        const std::vector<uint32_t> image = Render(loupe, MakeView(pixels));
+
+        const std::string path = g_dataDirectory + "/loupe-golden.ppm";
+        if (g_update) {
+            CHECK(WritePpm(path, image, loupe.GetOutputSize(), loupe.GetOutputSize()));
+            std::printf("wrote %s\n", path.c_str());
+            return;
+        }
+
+        std::vector<uint32_t> golden;
+        int width = 0, height = 0;
+        CHECK(ReadPpm(path, golden, width, height));
+        CHECK(width == loupe.GetOutputSize() && height == loupe.GetOutputSize());
+        for (size_t i = 0; i < golden.size(); i++) {
+            if (image[i] != golden[i]) {
+                std::fprintf(stderr, "first difference at %zu,%zu: %06X, golden %06X\n",
+                    i % width, i / width, image[i], golden[i]);
+            }
+            CHECK(image[i] == golden[i]);
+        }
+
+        // The patch crosses every class
+        for (PixelClass pixelClass : { PixelClass::Other, PixelClass::Background, PixelClass::Fill,
+            PixelClass::Marker, PixelClass::FilledMarker }) {
+            CHECK(loupe.GetClassCount(pixelClass) > 0);
+        }
+        int total = 0;
+        for (int pixelClass = 0; pixelClass < 5; pixelClass++) {
+            total += loupe.GetClassCount(static_cast<PixelClass>(pixelClass));
+        }
+        CHECK(total == PATCH_WIDTH * PATCH_HEIGHT);
+    }
+
+    // Every zoom is the golden image scaled up by nearest neighbour, with
+    // the centre cell framed once it is three pixels or larger
+    void TestZoomMatchesGolden() {
+        if (g_update) return;
+
+        std::vector<uint32_t> golden;
+        int goldenSize = 0, height = 0;
+        CHECK(ReadPpm(g_dataDirectory + "/loupe-golden.ppm", golden, goldenSize, height));
+
+        const std::vector<uint8_t> pixels = MakePatch();
+        const FrameView patch = MakeView(pixels);
+        for (int zoom = 1; zoom <= ClassificationLoupe::MAX_ZOOM; zoom++) {
+            ClassificationLoupe loupe;
+            loupe.Configure(XpBarPalette{}, zoom);
+            CHECK(loupe.GetZoom() == zoom);
+            const std::vector<uint32_t> image = Render(loupe, patch);
+
+            const int size = loupe.GetOutputSize();
+            const int centre = ClassificationLoupe::PATCH_SIZE / 2;
+            for (int y = 0; y < size; y++) {
+                for (int x = 0; x < size; x++) {
+                    const int cellX = x / zoom;
+                    const int cellY = y / zoom;
+                    uint32_t expected = golden[static_cast<size_t>(cellY) * goldenSize + cellX];
+                    const bool isCellEdge = x % zoom == 0 || x % zoom == zoom - 1 ||
+                        y % zoom == 0 || y % zoom == zoom - 1;
+                    if (zoom >= 3 && cellX == centre && cellY == centre && isCellEdge) {
+                        expected = 0x00FFFFFF;
+                    }
+                    CHECK(image[static_cast<size_t>(y) * size + x] == expected);
+                }
+            }
+        }
+
+        // Out of range zooms are clamped
+        ClassificationLoupe loupe;
+        loupe.Configure(XpBarPalette{}, 0);
+        CHECK(loupe.GetZoom() == 1);
+        loupe.Configure(XpBarPalette{}, 100);
+        CHECK(loupe.GetZoom() == ClassificationLoupe::MAX_ZOOM);
+    }
+
+    void TestEmptyPatchIsBlack() {
+        ClassificationLoupe loupe;
+        loupe.Configure(XpBarPalette{}, 2);
+        for (uint32_t pixel : Render(loupe, FrameView{})) {
+            CHECK(pixel == 0);
+        }
+        CHECK(loupe.GetClassCount(PixelClass::Other) == 0);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: ClassificationLoupeTest <data directory> [--update]\n");
+        return 2;
+    }
+    g_dataDirectory = argv[1];
+    g_update = argc > 2 && std::strcmp(argv[2], "--update") == 0;
+
+    TestMatchesGolden();
+    TestZoomMatchesGolden();
+    TestEmptyPatchIsBlack();
+    return 0;
+}
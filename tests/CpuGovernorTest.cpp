@@ -0,0 +1,146 @@
+#include "CpuGovernor.h"
+
+#include <chrono>
+
+#include "Check.h"
+
+namespace {
+    using namespace std::chrono_literals;
+
+    // Clocks the test advances by hand
+    struct FakeClocks {
+        std::chrono::nanoseconds cpu{};
+        std::chrono::nanoseconds wall{};
+
+        // One interval of wall time at the given usage in percent of a core
+        void Run(std::chrono::milliseconds interval, float usagePercent) {
+            wall += interval;
+            cpu += std::chrono::nanoseconds(static_cast<long long>(
+                std::chrono::nanoseconds(interval).count() * usagePercent / 100.0f));
+        }
+    };
+
+    CpuGovernor MakeGovernor(FakeClocks& clocks, const CpuGovernorConfig& config) {
+        CpuGovernor governor([&clocks]() { return clocks.cpu; }, [&clocks]() { return clocks.wall; });
+        governor.Configure(config);
+        CHECK(!governor.Poll()); // Baseline
+        return governor;
+    }
+
+    void TestDegradesOneLevelPerInterval() {
+        FakeClocks clocks;
+        const CpuGovernorConfig config;
+        CpuGovernor governor = MakeGovernor(clocks, config);
+        const std::chrono::milliseconds interval(config.intervalMs);
+
+        // Nothing happens before an interval has passed
+        clocks.Run(interval / 2, 5.0f);
+        CHECK(!governor.Poll());
+        CHECK(governor.GetLevel() == CaptureQuality::Full);
+
+        clocks.Run(interval / 2, 5.0f);
+        CHECK(governor.Poll());
+        CHECK(governor.GetLevel() == CaptureQuality::ReducedRate);
+        CHECK(governor.GetUsagePercent() > 4.9f && governor.GetUsagePercent() < 5.1f);
+
+        clocks.Run(interval, 5.0f);
+        CHECK(governor.Poll());
+        CHECK(governor.GetLevel() == CaptureQuality::BandOnly);
+        clocks.Run(interval, 5.0f);
+        CHECK(governor.Poll());
+        CHECK(governor.GetLevel() == CaptureQuality::Sampled);
+
+        // Stays at the deepest level however long it is over budget
+        clocks.Run(interval, 5.0f);
+        CHECK(!governor.Poll());
+        CHECK(governor.GetLevel() == CaptureQuality::Sampled);
+    }
+
+    void TestMaxLevelLimitsDegrading() {
+        FakeClocks clocks;
+        CpuGovernorConfig config;
+        config.maxLevel = static_cast<int>(CaptureQuality::ReducedRate);
+        CpuGovernor governor = MakeGovernor(clocks, config);
+        for (int i = 0; i < 5; i++) {
+            clocks.Run(std::chrono::milliseconds(config.intervalMs), 5.0f);
+            governor.Poll();
+        }
+        CHECK(governor.GetLevel() == CaptureQuality::ReducedRate);
+    }
+
+    void TestRestoresAfterSustainedHeadroom() {
+        FakeClocks clocks;
+        const CpuGovernorConfig config;
+        CpuGovernor governor = MakeGovernor(clocks, config);
+        const std::chrono::milliseconds interval(config.intervalMs);
+        clocks.Run(interval, 5.0f);
+        governor.Poll();
+        clocks.Run(interval, 5.0f);
+        governor.Poll();
+        CHECK(governor.GetLevel() == CaptureQuality::BandOnly);
+
+        // Just under budget is not headroom
+        const float fits = config.budgetPercent * 0.9f;
+        for (int i = 0; i < 10; i++) {
+            clocks.Run(interval, fits);
+            CHECK(!governor.Poll());
+        }
+        CHECK(governor.GetLevel() == CaptureQuality::BandOnly);
+
+        // Headroom must last restoreIntervals in a row
+        const float idle = config.budgetPercent * config.restoreFraction * 0.5f;
+        for (int i = 0; i < config.restoreIntervals - 1; i++) {
+            clocks.Run(interval, idle);
+            CHECK(!governor.Poll());
+        }
+        clocks.Run(interval, fits);
+        CHECK(!governor.Poll());
+        for (int i = 0; i < config.restoreIntervals - 1; i++) {
+            clocks.Run(interval, idle);
+            CHECK(!governor.Poll());
+        }
+        clocks.Run(interval, idle);
+        CHECK(governor.Poll());
+        CHECK(governor.GetLevel() == CaptureQuality::ReducedRate);
+
+        // One level per restoreIntervals, down to Full
+        for (int i = 0; i < config.restoreIntervals; i++) {
+            clocks.Run(interval, idle);
+            governor.Poll();
+        }
+        CHECK(governor.GetLevel() == CaptureQuality::Full);
+        for (int i = 0; i < config.restoreIntervals * 3; i++) {
+            clocks.Run(interval, idle);
+            CHECK(!governor.Poll());
+        }
+        CHECK(governor.GetLevel() == CaptureQuality::Full);
+    }
+
+    void TestDisabledAndReconfigured() {
+        FakeClocks clocks;
+        CpuGovernorConfig config;
+        config.enabled = false;
+        CpuGovernor governor = MakeGovernor(clocks, config);
+        clocks.Run(std::chrono::milliseconds(config.intervalMs), 50.0f);
+        CHECK(!governor.Poll());
+        CHECK(governor.GetLevel() == CaptureQuality::Full);
+
+        // Configure starts over at Full with a new baseline
+        config.enabled = true;
+        governor.Configure(config);
+        CHECK(!governor.Poll());
+        clocks.Run(std::chrono::milliseconds(config.intervalMs), 50.0f);
+        CHECK(governor.Poll());
+        governor.Configure(config);
+        CHECK(governor.GetLevel() == CaptureQuality::Full);
+        CHECK(!governor.Poll());
+    }
+}
+
+int main() {
+    TestDegradesOneLevelPerInterval();
+    TestMaxLevelLimitsDegrading();
+    TestRestoresAfterSustainedHeadroom();
+    TestDisabledAndReconfigured();
+    return 0;
+}
@@ -0,0 +1,324 @@
+#include "DigitReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+
+// Run with the data directory as the first argument. digits.pgm is the
+// template strip; the xp-text-*.ppm crops are XP text cut from the area
+// next to the bar, each named for what it shows.
+
+namespace {
+    using namespace std::chrono_literals;
+
+    const std::string GLYPHS = "0123456789/,";
+    constexpr int READ_REPEATS = 1000;
+    constexpr auto MAX_READ_TIME = 200us;
+
+    std::string g_dataDirectory;
+
+    std::vector<uint8_t> ReadFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    }
+
+    std::vector<uint8_t> ToBytes(const std::string& text) {
+        return std::vector<uint8_t>(text.begin(), text.end());
+    }
+
+    // Binary PPM (P6) to the BGRX layout the capture delivers
+    struct Crop {
+        std::vector<uint8_t> pixels;
+        int width = 0;
+        int height = 0;
+
+        FrameView GetView() const {
+            FrameView view;
+            view.data = pixels.data();
+            view.width = width;
+            view.height = height;
+            view.stride = width * FrameView::BYTES_PER_PIXEL;
+            return view;
+        }
+    };
+
+    bool ReadPpm(const std::string& path, Crop& crop) {
+        std::ifstream in(path, std::ios::binary);
+        std::string magic;
+        int maxval = 0;
+        if (!(in >> magic >> crop.width >> crop.height >> maxval) || magic != "P6" || maxval != 255) return false;
+        in.get();
+
+        const std::vector<char> raster((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        const size_t count = static_cast<size_t>(crop.width) * crop.height;
+        if (raster.size() != count * 3) return false;
+        crop.pixels.assign(count * FrameView::BYTES_PER_PIXEL, 0);
+        for (size_t i = 0; i < count; i++) {
+            uint8_t* pixel = &crop.pixels[i * FrameView::BYTES_PER_PIXEL];
+            pixel[0] = static_cast<uint8_t>(raster[i * 3 + 2]);
+            pixel[1] = static_cast<uint8_t>(raster[i * 3 + 1]);
+            pixel[2] = static_cast<uint8_t>(raster[i * 3]);
+        }
+        return true;
+    }
+
+    std::shared_ptr<const DigitTemplateSet> LoadTemplates() {
+        const std::vector<uint8_t> strip = ReadFile(g_dataDirectory + "/digits.pgm");
+        auto templates = std::make_shared<DigitTemplateSet>();
+        CHECK(templates->LoadPgm(strip.data(), strip.size(), GLYPHS, DigitReaderConfig{}.threshold));
+        return templates;
+    }
+
+    Crop LoadCrop(const char* name) {
+        Crop crop;
+        CHECK(ReadPpm(g_dataDirectory + "/" + name, crop));
+        return crop;
+    }
+
+    XpTextReading MakeReading(uint32_t current, uint32_t maximum) {
+        XpTextReading reading;
+        reading.valid = true;
+        reading.current = current;
+        reading.maximum = maximum;
+        return reading;
+    }
+
+    void TestLoadStrip() {
+        const std::shared_ptr<const DigitTemplateSet> templates = LoadTemplates();
+        CHECK(templates->GetCount() == GLYPHS.size());
+        CHECK(templates->GetCellHeight() > 0);
+        CHECK(templates->GetCellHeight() <= DigitTemplateSet::MAX_CELL_HEIGHT);
+        for (size_t i = 0; i < GLYPHS.size(); i++) {
+            CHECK(templates->GetGlyph(i) == GLYPHS[i]);
+        }
+
+        // Every template is told apart from every other
+        for (size_t i = 0; i < templates->GetCount(); i++) {
+            for (size_t j = 0; j < templates->GetCount(); j++) {
+                const uint32_t difference = DigitReader::SumAbsoluteDifferences(
+                    templates->GetCell(i), templates->GetCell(j), templates->GetCellHeight());
+                CHECK((difference == 0) == (i == j));
+            }
+        }
+    }
+
+    void TestLoadRejectsBadStrips() {
+        const std::vector<uint8_t> strip = ReadFile(g_dataDirectory + "/digits.pgm");
+        DigitTemplateSet templates;
+
+        // More or fewer names than glyphs in the strip
+        CHECK(!templates.LoadPgm(strip.data(), strip.size(), "0123456789/", 128));
+        CHECK(templates.IsEmpty());
+        CHECK(!templates.LoadPgm(strip.data(), strip.size(), "0123456789/,.", 128));
+        CHECK(!templates.LoadPgm(strip.data(), strip.size(), "", 128));
+        CHECK(!templates.LoadPgm(strip.data(), strip.size(), "0123456789/,.:-+x", 128));
+
+        // Wrong magic, cut short, or nothing at all
+        std::vector<uint8_t> ascii = strip;
+        ascii[1] = '2';
+        CHECK(!templates.LoadPgm(ascii.data(), ascii.size(), GLYPHS, 128));
+        CHECK(!templates.LoadPgm(strip.data(), strip.size() / 2, GLYPHS, 128));
+        CHECK(!templates.LoadPgm(nullptr, 0, GLYPHS, 128));
+        const std::vector<uint8_t> blank = ToBytes(std::string("P5 4 2 255\n") + std::string(8, '\0'));
+        CHECK(!templates.LoadPgm(blank.data(), blank.size(), "0", 128));
+
+        // A glyph wider than a cell
+        const std::vector<uint8_t> wide = ToBytes(std::string("P5 17 1 255\n") + std::string(17, '\xff'));
+        CHECK(!templates.LoadPgm(wide.data(), wide.size(), "0", 128));
+
+        // Header comments and a smaller maximum value are fine
+        const std::vector<uint8_t> commented = ToBytes(
+            std::string("P5\n# strip\n3 1 # width height\n15\n") + std::string("\x0f\x00\x0f", 3));
+        CHECK(templates.LoadPgm(commented.data(), commented.size(), "01", 128));
+        CHECK(templates.GetCount() == 2);
+        CHECK(templates.GetCellHeight() == 1);
+    }
+
+    void TestSegmentation() {
+        // Two glyphs and one touching the right edge; ink outside the rows
+        // looked at does not count
+        const int width = 12, height = 3;
+        const char* rows[height] = {
+            "..#.........",
+            ".##..###..##",
+            "#....#.#...#",
+        };
+        std::vector<uint8_t> mask(static_cast<size_t>(width) * height);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                mask[static_cast<size_t>(y) * width + x] = rows[y][x] == '#' ? 255 : 0;
+            }
+        }
+        CHECK(DigitSegmentation::FindTopRow(mask.data(), width, height) == 0);
+        CHECK(DigitSegmentation::FindTopRow(mask.data() + width, width, height - 1) == 0);
+
+        std::vector<DigitSegmentation::Span> spans;
+        DigitSegmentation::ForEachSpan(mask.data(), width, 0, height,
+            [&](const DigitSegmentation::Span& span) { spans.push_back(span); });
+        CHECK(spans.size() == 3);
+        CHECK(spans[0].start == 0 && spans[0].end == 3);
+        CHECK(spans[1].start == 5 && spans[1].end == 8);
+        CHECK(spans[2].start == 10 && spans[2].end == 12);
+
+        spans.clear();
+        DigitSegmentation::ForEachSpan(mask.data(), width, 0, 1,
+            [&](const DigitSegmentation::Span& span) { spans.push_back(span); });
+        CHECK(spans.size() == 1);
+        CHECK(spans[0].start == 2 && spans[0].end == 3);
+
+        const std::vector<uint8_t> blank(static_cast<size_t>(width) * height, 0);
+        CHECK(DigitSegmentation::FindTopRow(blank.data(), width, height) == -1);
+    }
+
+    void TestSumMatchesScalar() {
+        // Random cells, not just binarized ones, at every height
+        std::mt19937 random(7);
+        alignas(16) uint8_t a[DigitTemplateSet::CELL_WIDTH * DigitTemplateSet::MAX_CELL_HEIGHT];
+        alignas(16) uint8_t b[DigitTemplateSet::CELL_WIDTH * DigitTemplateSet::MAX_CELL_HEIGHT];
+        for (int round = 0; round < 200; round++) {
+            const bool isBinary = round % 2 == 0;
+            for (size_t i = 0; i < sizeof(a); i++) {
+                a[i] = static_cast<uint8_t>(isBinary ? (random() & 1) * 255 : random());
+                b[i] = static_cast<uint8_t>(isBinary ? (random() & 1) * 255 : random());
+            }
+            for (int rows = 0; rows <= DigitTemplateSet::MAX_CELL_HEIGHT; rows++) {
+                CHECK(DigitReader::SumAbsoluteDifferences(a, b, rows) ==
+                    DigitReader::SumAbsoluteDifferencesScalar(a, b, rows));
+            }
+        }
+
+        // The largest possible difference
+        memset(a, 0, sizeof(a));
+        memset(b, 255, sizeof(b));
+        CHECK(DigitReader::SumAbsoluteDifferences(a, b, DigitTemplateSet::MAX_CELL_HEIGHT) ==
+            255u * sizeof(a));
+    }
+
+    void TestReadsCrops() {
+        DigitReader reader;
+        reader.SetTemplates(LoadTemplates());
+        CHECK(reader.IsEnabled());
+
+        struct Case {
+            const char* name;
+            const char* text;
+            XpTextReading expected;
+        };
+        const Case cases[] = {
+            { "xp-text-plain.ppm", "12,345/67,890", MakeReading(12345, 67890) },
+            { "xp-text-noisy.ppm", "987,654/1,000,000", MakeReading(987654, 1000000) },
+            { "xp-text-worn.ppm", "406/8,150", MakeReading(406, 8150) },
+            { "xp-text-limit.ppm", "4,294,967,295/4,294,967,295", MakeReading(UINT32_MAX, UINT32_MAX) },
+            // Every glyph matches but the numbers are not XP
+            { "xp-text-overflow.ppm", "4,294,967,296/4,294,967,296", XpTextReading{} },
+            { "xp-text-over-max.ppm", "1,234/567", XpTextReading{} },
+        };
+        for (const Case& test : cases) {
+            const Crop crop = LoadCrop(test.name);
+            const XpTextReading reading = reader.Read(crop.GetView());
+            std::printf("%s: \"%s\"\n", test.name, reader.GetLastText().c_str());
+            CHECK(reader.GetLastText() == test.text);
+            CHECK(reading == test.expected);
+        }
+
+        // Something drawn over the text fails a glyph rather than misreading it
+        const Crop covered = LoadCrop("xp-text-covered.ppm");
+        CHECK(!reader.Read(covered.GetView()).valid);
+
+        // A stricter threshold on the worn crop loses glyphs
+        DigitReaderConfig strict;
+        strict.maxMismatch = 0;
+        reader.Configure(strict);
+        CHECK(!reader.Read(LoadCrop("xp-text-worn.ppm").GetView()).valid);
+    }
+
+    void TestDisabledAndBlank() {
+        DigitReader reader;
+        const Crop crop = LoadCrop("xp-text-plain.ppm");
+        CHECK(!reader.IsEnabled());
+        CHECK(!reader.Read(crop.GetView()).valid);
+
+        reader.SetTemplates(LoadTemplates());
+        CHECK(!reader.Read(FrameView{}).valid);
+        Crop blank = crop;
+        std::fill(blank.pixels.begin(), blank.pixels.end(), static_cast<uint8_t>(0));
+        CHECK(!reader.Read(blank.GetView()).valid);
+        CHECK(reader.GetLastText().empty());
+    }
+
+    void TestParse() {
+        CHECK(DigitReader::ParseXpText("0/1") == MakeReading(0, 1));
+        CHECK(DigitReader::ParseXpText("12,345/67,890") == MakeReading(12345, 67890));
+        CHECK(DigitReader::ParseXpText("12.345/67.890") == MakeReading(12345, 67890));
+        CHECK(DigitReader::ParseXpText("5/5") == MakeReading(5, 5));
+        CHECK(DigitReader::ParseXpText("4294967295/4294967295") == MakeReading(UINT32_MAX, UINT32_MAX));
+        CHECK(DigitReader::ParseXpText("000042/100") == MakeReading(42, 100));
+
+        const char* invalid[] = {
+            "",
+            "/",
+            "12345",
+            "12/",
+            "/34",
+            ",/,",
+            "1/2/3",
+            "1//2",
+            "5/0",
+            "6/5",
+            "4294967296/4294967296",
+            "1/99999999999999999999",
+            "1 /2",
+            "1/2x",
+            "-1/2",
+        };
+        for (const char* text : invalid) {
+            CHECK(!DigitReader::ParseXpText(text).valid);
+        }
+    }
+
+    void TestReadTime() {
+        DigitReader reader;
+        reader.SetTemplates(LoadTemplates());
+        const Crop crop = LoadCrop("xp-text-limit.ppm");
+        const FrameView view = crop.GetView();
+        CHECK(reader.Read(view).valid);
+
+        const auto start = std::chrono::steady_clock::now();
+        int valid = 0;
+        for (int i = 0; i < READ_REPEATS; i++) {
+            valid += reader.Read(view).valid ? 1 : 0;
+        }
+        const auto average = (std::chrono::steady_clock::now() - start) / READ_REPEATS;
+        std::printf("read %dx%d: %lld ns\n", crop.width, crop.height,
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(average).count()));
+        CHECK(valid == READ_REPEATS);
+        CHECK(average < MAX_READ_TIME);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: DigitReaderTest <data directory>\n");
+        return 2;
+    }
+    g_dataDirectory = argv[1];
+
+    TestLoadStrip();
+    TestLoadRejectsBadStrips();
+    TestSegmentation();
+    TestSumMatchesScalar();
+    TestReadsCrops();
+    TestDisabledAndBlank();
+    TestParse();
+    TestReadTime();
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include "FlightRecorder.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GaugeAnalyzer.h"
+#include "SyntheticGaugeSource.h"
+
+#include "Check.h"
+
+namespace {
+    constexpr int BAR_WIDTH = 400;
+    constexpr int BAR_HEIGHT = 12;
+
+    // A bar drawn by the synthetic source, analyzed the way the pipeline
+    // does, and recorded; covered pixels are painted off-palette from the left
+    class RecordingBench {
+    public:
+        explicit RecordingBench(const FlightRecorderConfig& config)
+            : m_pixels(static_cast<size_t>(BAR_WIDTH) * BAR_HEIGHT * FrameView::BYTES_PER_PIXEL) {
+            m_recorder.Configure(config);
+            m_analyzer = GaugeAnalyzerRegistry::Find(m_layout);
+            CHECK(m_analyzer);
+        }
+
+        bool Record(float percent, int covered = 0) {
+            const int stride = BAR_WIDTH * FrameView::BYTES_PER_PIXEL;
+            m_source.Draw(m_pixels.data(), stride, BAR_WIDTH, BAR_HEIGHT, percent);
+            for (int y = 0; y < BAR_HEIGHT; y++) {
+                for (int x = 0; x < covered; x++) {
+                    uint8_t* pixel = m_pixels.data() + static_cast<size_t>(y) * stride + x * FrameView::BYTES_PER_PIXEL;
+                    pixel[0] = 0xFF;
+                    pixel[1] = 0x00;
+                    pixel[2] = 0xFF;
+                }
+            }
+
+            FrameView bar;
+            bar.data = m_pixels.data();
+            bar.width = BAR_WIDTH;
+            bar.height = BAR_HEIGHT;
+            bar.stride = stride;
+            int frontier = 0;
+            const GaugeReading reading = m_analyzer->scan(bar, m_classifier, frontier);
+
+            SignalConditioner::Output conditioned;
+            conditioned.value = reading.percent;
+            conditioned.emit = true;
+            return m_recorder.Record(bar, m_layout, reading, conditioned, XpTextReading{}, 5);
+        }
+
+        bool Dump(std::string& bytes) const {
+            std::ostringstream out(std::ios::binary);
+            if (!m_recorder.Write(out, m_classifier.palette, m_layout)) return false;
+            bytes = out.str();
+            return true;
+        }
+
+        FlightRecorder& GetRecorder() { return m_recorder; }
+        const XpBarPalette& GetPalette() const { return m_classifier.palette; }
+        const GaugeLayout& GetLayout() const { return m_layout; }
+
+    private:
+        SyntheticGaugeSource m_source;
+        GaugeLayout m_layout;
+        PaletteClassifier m_classifier;
+        const GaugeAnalyzerEntry* m_analyzer = nullptr;
+        FlightRecorder m_recorder;
+        std::vector<uint8_t> m_pixels;
+    };
+
+    FlightRecording Load(const std::string& bytes) {
+        FlightRecording recording;
+        std::istringstream in(bytes, std::ios::binary);
+        CHECK(recording.Load(in));
+        return recording;
+    }
+
+    void TestRoundTrip() {
+        RecordingBench bench{ FlightRecorderConfig{} };
+        const int frames = static_cast<int>(FlightRecorder::CAPACITY) + 20;
+        for (int i = 0; i < frames; i++) {
+            CHECK(!bench.Record(10.0f + i * 0.5f));
+        }
+        bench.GetRecorder().Trigger();
+        CHECK(bench.Record(60.0f));
+
+        std::string bytes;
+        CHECK(bench.Dump(bytes));
+        const FlightRecording recording = Load(bytes);
+        CHECK(recording.reason == FlightFreezeReason::Manual);
+        CHECK(recording.palette == bench.GetPalette());
+        CHECK(recording.layout == bench.GetLayout());
+
+        // The ring holds the newest frames, oldest first, with their lines
+        CHECK(recording.frames.size() == FlightRecorder::CAPACITY);
+        for (size_t i = 0; i < recording.frames.size(); i++) {
+            const FlightFrame& frame = recording.frames[i];
+            CHECK(frame.sequence == frames + 1 - FlightRecorder::CAPACITY + i);
+            CHECK(frame.width == BAR_WIDTH && frame.height == BAR_HEIGHT);
+            CHECK(frame.lineLength == BAR_WIDTH);
+            CHECK(frame.flags & FlightFrame::FLAG_EMITTED);
+            CHECK(recording.GetLine(i).width == BAR_WIDTH);
+            CHECK(recording.GetLine(i).height == 1);
+        }
+        CHECK(recording.frames.back().rawPercent > 59.0f);
+
+        // Re-analyzing the recorded lines gives the recorded readings
+        const std::string replay = recording.Replay();
+        CHECK(replay.rfind("Frozen on Manual, 64 frames\n", 0) == 0);
+        CHECK(replay.find("MISMATCH") == std::string::npos);
+        CHECK(replay.find("clipped") == std::string::npos);
+
+        // Cut short, or not a dump at all
+        FlightRecording broken;
+        std::istringstream truncated(bytes.substr(0, bytes.size() - 1), std::ios::binary);
+        CHECK(!broken.Load(truncated));
+        std::string renamed = bytes;
+        renamed[0] = 'Q';
+        std::istringstream wrongMagic(renamed, std::ios::binary);
+        CHECK(!broken.Load(wrongMagic));
+        CHECK(broken.frames.empty());
+    }
+
+    void TestManualTrigger() {
+        RecordingBench bench{ FlightRecorderConfig{} };
+        FlightRecorder& recorder = bench.GetRecorder();
+        for (int i = 0; i < 10; i++) {
+            CHECK(!bench.Record(20.0f + i));
+        }
+        std::string bytes;
+        CHECK(!bench.Dump(bytes));
+
+        // From another thread, taking effect at the next frame, and only once
+        std::thread hotkey([&recorder]() { recorder.Trigger(); });
+        hotkey.join();
+        CHECK(!recorder.IsFrozen());
+        CHECK(bench.Record(30.0f));
+        CHECK(recorder.IsFrozen());
+        CHECK(recorder.GetFreezeReason() == FlightFreezeReason::Manual);
+
+        // Frozen frames are not recorded, so the dump ends at the trigger
+        CHECK(!bench.Record(31.0f));
+        CHECK(!bench.Record(32.0f));
+        CHECK(bench.Dump(bytes));
+        const FlightRecording recording = Load(bytes);
+        CHECK(recording.frames.size() == 11);
+        CHECK(recording.frames.back().sequence == 10);
+        CHECK(recording.frames.back().anomaly == FlightFreezeReason::None);
+
+        recorder.Resume();
+        CHECK(!recorder.IsFrozen());
+        CHECK(!bench.Record(33.0f));
+        CHECK(!bench.Dump(bytes));
+    }
+
+    void TestDropout() {
+        // Covering the bar also moves the reading; only dropouts count here
+        FlightRecorderConfig config;
+        config.postTriggerFrames = 2;
+        config.freezeOnDecrease = false;
+        RecordingBench bench{ config };
+        FlightRecorder& recorder = bench.GetRecorder();
+        for (int i = 0; i < 10; i++) {
+            CHECK(!bench.Record(50.0f));
+        }
+
+        // A quarter of the bar lost is not a dropout; most of it is, and the
+        // freeze waits postTriggerFrames to see how it resolves
+        CHECK(!bench.Record(50.0f, BAR_WIDTH / 4));
+        CHECK(!bench.Record(50.0f));
+        CHECK(!bench.Record(50.0f, BAR_WIDTH * 3 / 4));
+        CHECK(!bench.Record(50.0f, BAR_WIDTH * 3 / 4));
+        CHECK(bench.Record(50.0f, BAR_WIDTH * 3 / 4));
+        CHECK(recorder.GetFreezeReason() == FlightFreezeReason::Dropout);
+
+        std::string bytes;
+        CHECK(bench.Dump(bytes));
+        const FlightRecording recording = Load(bytes);
+        CHECK(recording.reason == FlightFreezeReason::Dropout);
+        const size_t last = recording.frames.size() - 1;
+        CHECK(recording.frames[last - 2].anomaly == FlightFreezeReason::Dropout);
+        CHECK(recording.frames[last - 1].anomaly == FlightFreezeReason::None);
+        CHECK(recording.frames[last].totalPixels * 2 < recording.frames[last - 3].totalPixels);
+        CHECK(recording.Replay().find("<- Dropout") != std::string::npos);
+
+        // Turned off, the same frames never freeze
+        config.freezeOnDropout = false;
+        RecordingBench quiet{ config };
+        for (int i = 0; i < 20; i++) {
+            CHECK(!quiet.Record(50.0f, i % 2 ? BAR_WIDTH * 3 / 4 : 0));
+        }
+    }
+
+    std::filesystem::path MakeTempDirectory() {
+        std::random_device random;
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() /
+            ("pOverlay-FlightRecorderTest-" + std::to_string(random()));
+        std::filesystem::create_directories(directory);
+        return directory;
+    }
+
+    void Touch(const std::filesystem::path& path, int ageSeconds) {
+        std::ofstream(path, std::ios::binary) << "PXFR";
+        std::filesystem::last_write_time(path,
+            std::filesystem::file_time_type::clock::now() - std::chrono::seconds(ageSeconds));
+    }
+
+    void TestPruneKeepsNewest() {
+        const std::filesystem::path directory = MakeTempDirectory();
+        // Written in this order; the names sort differently from the times
+        const char* dumps[] = {
+            "flight-20260101-120000-9.pxfr",
+            "flight-20260101-120000-10.pxfr",
+            "flight-20260101-120500-0.pxfr",
+            "flight-20260101-120501-1.pxfr",
+            "flight-20260101-121000-2.pxfr",
+        };
+        int age = 100;
+        for (const char* name : dumps) {
+            Touch(directory / name, age);
+            age -= 10;
+        }
+        Touch(directory / "notes.txt", 1000);
+        Touch(directory / "flight-old.txt", 1000);
+        Touch(directory / "other.pxfr", 1000);
+
+        CHECK(FlightRecordingFiles::IsRecording(directory / dumps[0]));
+        CHECK(!FlightRecordingFiles::IsRecording(directory / "other.pxfr"));
+        CHECK(!FlightRecordingFiles::IsRecording(directory / "flight-.pxfr"));
+
+        CHECK(FlightRecordingFiles::Prune(directory, 3) == 2);
+        CHECK(!std::filesystem::exists(directory / dumps[0]));
+        CHECK(!std::filesystem::exists(directory / dumps[1]));
+        for (size_t i = 2; i < 5; i++) {
+            CHECK(std::filesystem::exists(directory / dumps[i]));
+        }
+        CHECK(std::filesystem::exists(directory / "notes.txt"));
+        CHECK(std::filesystem::exists(directory / "flight-old.txt"));
+        CHECK(std::filesystem::exists(directory / "other.pxfr"));
+
+        CHECK(FlightRecordingFiles::Prune(directory, 3) == 0);
+        CHECK(FlightRecordingFiles::Prune(directory, 0) == 3);
+        CHECK(FlightRecordingFiles::Prune(directory / "missing", 0) == 0);
+
+        std::filesystem::remove_all(directory);
+    }
+}
+
+int main() {
+    TestRoundTrip();
+    TestManualTrigger();
+    TestDropout();
+    TestPruneKeepsNewest();
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include "GaugeAnalyzer.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "SyntheticGaugeSource.h"
+
+#include "Check.h"
+
+namespace {
+    // The priority order PaletteClassifier must reproduce, written as the
+    // plain if-chain
+    PixelClass ClassifyReference(const XpBarPalette& palette, const uint8_t* pixel) {
+        const uint8_t blue = pixel[0];
+        const uint8_t green = pixel[1];
+        const uint8_t red = pixel[2];
+
+        if (palette.fill.Matches(red, green, blue)) return PixelClass::Fill;
+        if (palette.filledMarker.Matches(red, green, blue)) return PixelClass::FilledMarker;
+        if (palette.marker.Matches(red, green, blue)) return PixelClass::Marker;
+        if (palette.background.Matches(red, green, blue)) return PixelClass::Background;
+        return PixelClass::Other;
+    }
+
+    // Pixels near each palette colour, where the tolerance edges are
+    void CheckNearColors(const PaletteClassifier& classifier, std::mt19937& random) {
+        const PaletteColor* colors[] = {
+            &classifier.palette.fill, &classifier.palette.filledMarker,
+            &classifier.palette.marker, &classifier.palette.background,
+        };
+        std::uniform_int_distribution<int> offset(-40, 40);
+        for (const PaletteColor* color : colors) {
+            for (int i = 0; i < 5000; i++) {
+                const uint8_t pixel[4] = {
+                    static_cast<uint8_t>((std::max)(0, (std::min)(255, color->blue + offset(random)))),
+                    static_cast<uint8_t>((std::max)(0, (std::min)(255, color->green + offset(random)))),
+                    static_cast<uint8_t>((std::max)(0, (std::min)(255, color->red + offset(random)))),
+                    0,
+                };
+                CHECK(classifier.Classify(pixel) == ClassifyReference(classifier.palette, pixel));
+            }
+        }
+    }
+
+    void TestClassifierMatchesPriorityOrder() {
+        std::mt19937 random(11);
+        std::uniform_int_distribution<int> channel(0, 255);
+
+        PaletteClassifier classifier;
+        CheckNearColors(classifier, random);
+
+        // Overlapping colours, where only the priority decides
+        classifier.palette.marker = { 0x30, 0x60, 0xE0, 40 };
+        classifier.palette.filledMarker = { 0x2D, 0x67, 0xE2, 10 };
+        CheckNearColors(classifier, random);
+
+        // Random palettes, including tolerances the INI file does not clamp
+        const int tolerances[] = { -1, 0, 1, 12, 255, 300, INT_MAX };
+        for (int palette = 0; palette < 200; palette++) {
+            PaletteColor* colors[] = {
+                &classifier.palette.fill, &classifier.palette.filledMarker,
+                &classifier.palette.marker, &classifier.palette.background,
+            };
+            for (PaletteColor* color : colors) {
+                color->red = static_cast<uint8_t>(channel(random));
+                color->green = static_cast<uint8_t>(channel(random));
+                color->blue = static_cast<uint8_t>(channel(random));
+                color->tolerance = tolerances[random() % std::size(tolerances)];
+            }
+            CheckNearColors(classifier, random);
+            for (int i = 0; i < 1000; i++) {
+                const uint8_t pixel[4] = {
+                    static_cast<uint8_t>(channel(random)), static_cast<uint8_t>(channel(random)),
+                    static_cast<uint8_t>(channel(random)), 0,
+                };
+                CHECK(classifier.Classify(pixel) == ClassifyReference(classifier.palette, pixel));
+            }
+        }
+    }
+
+    // Any classifier type plugs into the analyzers; this one reads the class
+    // straight from the pixel's unused fourth byte
+    struct KeyClassifier {
+        PixelClass Classify(const uint8_t* pixel) const {
+            return static_cast<PixelClass>(pixel[3] % 5);
+        }
+    };
+
+    // The scan as a plain loop that branches on every pixel: markers are
+    // looked for where a marker coloured pixel starts and skipped as a whole
+    template <GaugeOrientation Orientation, FillDirection Direction, int MarkerWidth, typename Classifier>
+    GaugeReading ScanReference(const FrameView& frame, const Classifier& classifier, int& frontier) {
+        const GaugeLine<Orientation, Direction> line(frame);
+        auto classAt = [&](int i) { return classifier.Classify(line.At(i)); };
+        auto isMarker = [](PixelClass c) { return c == PixelClass::Marker || c == PixelClass::FilledMarker; };
+
+        GaugeReading reading;
+        frontier = 0;
+        for (int i = 0; i < line.length; i++) {
+            const PixelClass pixelClass = classAt(i);
+            if (pixelClass == PixelClass::Other) continue;
+
+            bool isRun = MarkerWidth > 0 && isMarker(pixelClass) && i + MarkerWidth <= line.length;
+            for (int j = 1; isRun && j < MarkerWidth; j++) {
+                isRun = isMarker(classAt(i + j));
+            }
+            if (isRun) {
+                bool isMarkerFilled = false;
+                for (int j = 0; j < MarkerWidth; j++) {
+                    isMarkerFilled = isMarkerFilled || classAt(i + j) == PixelClass::FilledMarker;
+                }
+                const bool isFilledBefore = i > 0 && classAt(i - 1) == PixelClass::Fill;
+                const bool isFilledAfter = i + MarkerWidth < line.length && classAt(i + MarkerWidth) == PixelClass::Fill;
+                if ((isFilledBefore && isFilledAfter) || isMarkerFilled) {
+                    reading.filledPixels += MarkerWidth;
+                    if (isMarkerFilled) frontier = i + MarkerWidth;
+                }
+                reading.totalPixels += MarkerWidth;
+                i += MarkerWidth - 1;
+                continue;
+            }
+
+            if (pixelClass == PixelClass::Fill) {
+                reading.filledPixels++;
+                frontier = i + 1;
+            }
+            reading.totalPixels++;
+        }
+        if (reading.totalPixels > 0) {
+            reading.percent = (reading.filledPixels * 100.0f) / reading.totalPixels;
+        }
+        return reading;
+    }
+
+    template <GaugeOrientation Orientation, FillDirection Direction, int MarkerWidth>
+    void CheckScanMatchesReference(std::mt19937& random) {
+        // Lines that are mostly fill then background, with marker runs of
+        // every length and stray classes mixed in
+        constexpr int LENGTH = 97;
+        std::vector<uint8_t> pixels(LENGTH * FrameView::BYTES_PER_PIXEL);
+        FrameView frame;
+        frame.data = pixels.data();
+        frame.width = Orientation == GaugeOrientation::Horizontal ? LENGTH : 1;
+        frame.height = Orientation == GaugeOrientation::Horizontal ? 1 : LENGTH;
+        frame.stride = frame.width * FrameView::BYTES_PER_PIXEL;
+        frame.format = PixelFormat::BGRX32;
+
+        const KeyClassifier classifier;
+        std::uniform_int_distribution<int> anyClass(0, 4);
+        std::uniform_int_distribution<int> runLength(1, 9);
+        for (int trial = 0; trial < 2000; trial++) {
+            const int edge = static_cast<int>(random() % (LENGTH + 1));
+            for (int i = 0; i < LENGTH;) {
+                int pixelClass = static_cast<int>(i < edge ? PixelClass::Fill : PixelClass::Background);
+                int run = 1;
+                const int roll = static_cast<int>(random() % 10);
+                if (roll < 2) {
+                    pixelClass = static_cast<int>(roll == 0 ? PixelClass::Marker : PixelClass::FilledMarker);
+                    run = runLength(random);
+                }
+                else if (roll == 2) {
+                    pixelClass = anyClass(random);
+                }
+                for (int j = 0; j < run && i < LENGTH; j++, i++) {
+                    pixels[i * FrameView::BYTES_PER_PIXEL + 3] = static_cast<uint8_t>(
+                        j > 0 && random() % 4 == 0 ? static_cast<int>(PixelClass::Marker) : pixelClass);
+                }
+            }
+
+            int frontier = -1;
+            int expectedFrontier = -1;
+            const GaugeReading reading =
+                GaugeAnalyzer<Orientation, Direction, MarkerWidth, KeyClassifier>::Scan(frame, classifier, frontier);
+            const GaugeReading expected =
+                ScanReference<Orientation, Direction, MarkerWidth>(frame, classifier, expectedFrontier);
+            CHECK(reading.filledPixels == expected.filledPixels);
+            CHECK(reading.totalPixels == expected.totalPixels);
+            CHECK(reading.percent == expected.percent);
+            CHECK(frontier == expectedFrontier);
+        }
+    }
+
+    void TestScanMatchesReference() {
+        std::mt19937 random(5);
+        constexpr auto H = GaugeOrientation::Horizontal;
+        constexpr auto V = GaugeOrientation::Vertical;
+        constexpr auto F = FillDirection::Forward;
+        constexpr auto R = FillDirection::Reverse;
+        CheckScanMatchesReference<H, F, 0>(random);
+        CheckScanMatchesReference<H, F, 1>(random);
+        CheckScanMatchesReference<H, F, 2>(random);
+        CheckScanMatchesReference<H, R, 4>(random);
+        CheckScanMatchesReference<V, F, 3>(random);
+        CheckScanMatchesReference<V, R, 4>(random);
+    }
+
+    void TestRegisteredLayoutsScan() {
+        const GaugeOrientation orientations[] = { GaugeOrientation::Horizontal, GaugeOrientation::Vertical };
+        const FillDirection directions[] = { FillDirection::Forward, FillDirection::Reverse };
+        const int markerWidths[] = { 0, 2, 4 };
+
+        int registered = 0;
+        for (GaugeOrientation orientation : orientations) {
+            for (FillDirection direction : directions) {
+                for (int markerWidth : markerWidths) {
+                    const GaugeLayout layout{ orientation, direction, markerWidth };
+                    const GaugeAnalyzerEntry* entry = GaugeAnalyzerRegistry::Find(layout);
+                    if (!entry) continue;
+                    registered++;
+                    CHECK(entry->layout == layout);
+
+                    SyntheticGaugeSource source(XpBarPalette{}, layout);
+                    if (orientation == GaugeOrientation::Horizontal) {
+                        source.Resize(400, 12);
+                    } else {
+                        source.Resize(12, 400);
+                    }
+                    const PaletteClassifier classifier;
+                    for (float percent : { 0.0f, 12.5f, 37.5f, 50.0f, 99.0f, 100.0f }) {
+                        source.Render(percent);
+                        int frontier = -1;
+                        const GaugeReading reading = entry->scan(source.GetFrame(), classifier, frontier);
+                        CHECK(reading.totalPixels == 400);
+                        // A marker straddling the edge counts as unfilled
+                        CHECK(std::fabs(reading.percent - percent) <= (markerWidth + 1) * 100.0f / 400);
+                    }
+                }
+            }
+        }
+        CHECK(registered == 10);
+    }
+}
+
+int main() {
+    TestClassifierMatchesPriorityOrder();
+    TestScanMatchesReference();
+    TestRegisteredLayoutsScan();
+    return 0;
+}
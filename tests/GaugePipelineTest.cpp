@@ -0,0 +1,119 @@
+#include "GaugePipeline.h"
+
+#include "SyntheticGaugeSource.h"
+
+#include "Check.h"
+
+namespace {
+    // The gauge line a band-only capture blits: the middle row of the bar
+    FrameView GetBand(const FrameView& bar) {
+        return bar.SubView(0, bar.height / 2, bar.width, 1);
+    }
+
+    void TestWarmStateSurvivesBandOnly() {
+        SyntheticGaugeSource source;
+        source.Resize(400, 12);
+        source.Render(37.5f);
+
+        GaugePipeline pipeline;
+        pipeline.Process(source.GetFrame());
+        const AnalyzerWarmState full = pipeline.GetWarmState();
+        CHECK(full.valid && full.gaugeLength == 400);
+
+        // Seed a reading only the incremental path would return, so taking
+        // it shows the warm state was kept
+        AnalyzerWarmState seeded = full;
+        seeded.reading.filledPixels--;
+        seeded.reading.percent = 42.0f;
+        pipeline.SetWarmState(seeded);
+
+        // The governor switching to band only must not force a rescan
+        pipeline.Process(GetBand(source.GetFrame()));
+        CHECK(pipeline.GetLastReading().percent == 42.0f);
+        CHECK(pipeline.GetWarmState().frontier == full.frontier);
+
+        // Nor does switching back
+        pipeline.Process(source.GetFrame());
+        CHECK(pipeline.GetLastReading().percent == 42.0f);
+
+        // A bar of another length is a different gauge
+        source.Resize(300, 12);
+        source.Render(37.5f);
+        pipeline.Process(source.GetFrame());
+        CHECK(pipeline.GetLastReading().percent != 42.0f);
+        CHECK(pipeline.GetWarmState().gaugeLength == 300);
+    }
+
+    constexpr int MAX_FRAMES = 50;
+
+    // Frames processed until the pipeline emits a value within half a
+    // percent of the bar, or MAX_FRAMES + 1 if it never does
+    int FramesToFirstReading(GaugePipeline& pipeline, const FrameView& frame, float percent) {
+        for (int frames = 1; frames <= MAX_FRAMES; frames++) {
+            const GaugePipeline::Result result = pipeline.Process(frame);
+            if (result.emit && result.conditioned.value > percent - 0.5f &&
+                result.conditioned.value < percent + 0.5f) {
+                return frames;
+            }
+        }
+        return MAX_FRAMES + 1;
+    }
+
+    // State saved at shutdown from a bar at percent
+    AnalyzerWarmState SaveWarmState(float percent) {
+        SyntheticGaugeSource source;
+        source.Resize(400, 12);
+        source.Render(percent);
+        GaugePipeline pipeline;
+        pipeline.Process(source.GetFrame());
+        CHECK(pipeline.GetWarmState().valid);
+        return pipeline.GetWarmState();
+    }
+
+    void TestFramesToFirstReading() {
+        SyntheticGaugeSource source;
+        source.Resize(400, 12);
+        source.Render(62.5f);
+
+        // From cold, and from this bar's own saved state, the first frame reads it
+        GaugePipeline cold;
+        CHECK(FramesToFirstReading(cold, source.GetFrame(), 62.5f) == 1);
+        GaugePipeline warm;
+        warm.SetWarmState(SaveWarmState(62.5f));
+        CHECK(FramesToFirstReading(warm, source.GetFrame(), 62.5f) == 1);
+
+        // A state from another window's bar of the same length is caught by
+        // the fill edge check and never published, whether that bar was
+        // behind or ahead, and on the governor's sampled path too
+        for (const float other : { 20.0f, 90.0f }) {
+            for (const int step : { 1, 4 }) {
+                GaugePipeline stale;
+                stale.SetSampleStep(step);
+                stale.SetWarmState(SaveWarmState(other));
+                CHECK(FramesToFirstReading(stale, source.GetFrame(), 62.5f) == 1);
+                CHECK(stale.GetWarmState().frontier != SaveWarmState(other).frontier);
+            }
+        }
+    }
+
+    void TestBandMatchesFullScan() {
+        SyntheticGaugeSource source;
+        source.Resize(400, 12);
+        GaugePipeline full;
+        GaugePipeline band;
+        for (int step = 0; step <= 100; step++) {
+            source.Render(step * 0.7f);
+            full.Process(source.GetFrame());
+            band.Process(GetBand(source.GetFrame()));
+            CHECK(full.GetLastReading().filledPixels == band.GetLastReading().filledPixels);
+            CHECK(full.GetLastReading().totalPixels == band.GetLastReading().totalPixels);
+        }
+    }
+}
+
+int main() {
+    TestWarmStateSurvivesBandOnly();
+    TestFramesToFirstReading();
+    TestBandMatchesFullScan();
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include "HotkeyBindings.h"
+
+#include "Check.h"
+
+namespace {
+    constexpr uint32_t KEY_F7 = 0x76;
+    constexpr uint32_t KEY_F24 = 0x87;
+
+    bool Parses(const wchar_t* text, uint32_t expectedModifiers, uint32_t expectedKey) {
+        uint32_t modifiers = 0xFFFF, virtualKey = 0xFFFF;
+        return HotkeyParser::Parse(text, modifiers, virtualKey) &&
+            modifiers == expectedModifiers && virtualKey == expectedKey;
+    }
+
+    bool Rejects(const wchar_t* text) {
+        uint32_t modifiers = 0xFFFF, virtualKey = 0xFFFF;
+        return !HotkeyParser::Parse(text, modifiers, virtualKey) && virtualKey == 0;
+    }
+
+    void TestParseKeys() {
+        CHECK(Parses(L"F7", 0, KEY_F7));
+        CHECK(Parses(L"f24", 0, KEY_F24));
+        CHECK(Parses(L"a", 0, 'A'));
+        CHECK(Parses(L"5", 0, '5'));
+        CHECK(Parses(L"pageup", 0, 0x21));
+        CHECK(Parses(L"Pause", 0, 0x13));
+
+        CHECK(Rejects(L"F0"));
+        CHECK(Rejects(L"F25"));
+        CHECK(Rejects(L"F7x"));
+        CHECK(Rejects(L"F100"));
+        CHECK(Rejects(L"Escape"));
+        CHECK(Rejects(L"-"));
+    }
+
+    void TestParseModifiers() {
+        using namespace HotkeyModifier;
+        CHECK(Parses(L"Ctrl+Shift+F7", Control | Shift, KEY_F7));
+        CHECK(Parses(L"control+alt+win+A", Control | Alt | Win, 'A'));
+        CHECK(Parses(L" Shift + Alt + F7 ", Shift | Alt, KEY_F7));
+        CHECK(Parses(L"Ctrl+Ctrl+F7", Control, KEY_F7));
+
+        // The key comes last, exactly once
+        CHECK(Rejects(L"F7+Ctrl"));
+        CHECK(Rejects(L"A+B"));
+        CHECK(Rejects(L"Ctrl+Shift"));
+        CHECK(Rejects(L"Ctrl+Hyper+F7"));
+        CHECK(Rejects(L"Ctrl++F7"));
+        CHECK(Rejects(L"Ctrl+F7+"));
+    }
+
+    void TestParseEmpty() {
+        CHECK(Rejects(L""));
+        CHECK(Rejects(L" "));
+        CHECK(Rejects(L"+"));
+
+        // An empty entry leaves the action unbound
+        HotkeyTable table;
+        CHECK(!table.Add(L"", HotkeyAction::Recalibrate));
+        CHECK(table.Size() == 0);
+    }
+
+    void TestDuplicates() {
+        HotkeyTable table;
+        CHECK(table.Add(L"Ctrl+F7", HotkeyAction::ToggleHud));
+        CHECK(!table.Add(L"ctrl+f7", HotkeyAction::Recalibrate));
+        CHECK(!table.Add(L"Control + F7", HotkeyAction::ToggleHud));
+        CHECK(table.Size() == 1);
+
+        // Same key with other modifiers is another hotkey
+        CHECK(table.Add(L"Ctrl+Shift+F7", HotkeyAction::Recalibrate));
+        CHECK(table.Add(L"F7", HotkeyAction::DumpRecorder));
+        CHECK(table.Size() == 3);
+        CHECK(table.Find(HotkeyModifier::Control, KEY_F7) == HotkeyAction::ToggleHud);
+        CHECK(table.Find(HotkeyModifier::Control | HotkeyModifier::Shift, KEY_F7) == HotkeyAction::Recalibrate);
+        CHECK(table.Find(0, KEY_F7) == HotkeyAction::DumpRecorder);
+        CHECK(table.Find(HotkeyModifier::Alt, KEY_F7) == HotkeyAction::None);
+    }
+
+    void TestCapacity() {
+        HotkeyTable table;
+        for (uint32_t i = 0; i < HotkeyTable::MAX_BINDINGS; i++) {
+            HotkeyBinding binding;
+            binding.virtualKey = 'A' + i;
+            binding.action = HotkeyAction::ToggleHud;
+            CHECK(table.Add(binding));
+        }
+        CHECK(table.Size() == HotkeyTable::MAX_BINDINGS);
+        CHECK(!table.Add(L"Ctrl+Z", HotkeyAction::Recalibrate));
+        CHECK(table.Size() == HotkeyTable::MAX_BINDINGS);
+
+        table.Clear();
+        CHECK(table.Size() == 0);
+        CHECK(table.Add(L"Ctrl+Z", HotkeyAction::Recalibrate));
+
+        // A binding without a key is never added
+        CHECK(!table.Add(HotkeyBinding{}));
+    }
+
+    void TestDefaults() {
+        const HotkeyTable table = HotkeyTable::CreateDefault();
+        CHECK(table.Size() == static_cast<size_t>(HotkeyAction::Count) - 1);
+        for (size_t id = 0; id < table.Size(); id++) {
+            // Bare keys would be taken from the game
+            CHECK(table[id].modifiers != 0);
+            CHECK(table.GetAction(id) == static_cast<HotkeyAction>(id + 1));
+        }
+        CHECK(table.Find(HotkeyModifier::Control | HotkeyModifier::Shift, KEY_F7) ==
+            HotkeyAction::ToggleClickthrough);
+        CHECK(table.Find(0, KEY_F7) == HotkeyAction::None);
+    }
+
+    struct Counts {
+        int hud = 0;
+        int recalibrate = 0;
+    };
+
+    void OnHud(void* context) { static_cast<Counts*>(context)->hud++; }
+    void OnRecalibrate(void* context) { static_cast<Counts*>(context)->recalibrate++; }
+
+    void TestDispatchById() {
+        HotkeyTable table;
+        CHECK(table.Add(L"Ctrl+Shift+F6", HotkeyAction::ToggleHud));
+        CHECK(table.Add(L"Ctrl+Shift+F9", HotkeyAction::Recalibrate));
+        CHECK(table.Add(L"Ctrl+Shift+F10", HotkeyAction::DumpRecorder));
+
+        Counts counts;
+        HotkeyDispatcher dispatcher;
+        dispatcher.Bind(HotkeyAction::ToggleHud, OnHud, &counts);
+        dispatcher.Bind(HotkeyAction::Recalibrate, OnRecalibrate, &counts);
+
+        CHECK(dispatcher.Dispatch(table, 0));
+        CHECK(dispatcher.Dispatch(table, 1));
+        CHECK(dispatcher.Dispatch(table, 1));
+        CHECK(counts.hud == 1);
+        CHECK(counts.recalibrate == 2);
+
+        // Bound id without a handler, ids past the table, and bad actions
+        CHECK(!dispatcher.Dispatch(table, 2));
+        CHECK(!dispatcher.Dispatch(table, 3));
+        CHECK(!dispatcher.Dispatch(table, HotkeyTable::MAX_BINDINGS - 1));
+        CHECK(!dispatcher.Dispatch(HotkeyAction::None));
+        CHECK(!dispatcher.Dispatch(HotkeyAction::Count));
+        dispatcher.Bind(HotkeyAction::Count, OnHud, &counts);
+        CHECK(counts.hud == 1);
+        CHECK(counts.recalibrate == 2);
+    }
+}
+
+int main() {
+    TestParseKeys();
+    TestParseModifiers();
+    TestParseEmpty();
+    TestDuplicates();
+    TestCapacity();
+    TestDefaults();
+    TestDispatchById();
+    return 0;
+}
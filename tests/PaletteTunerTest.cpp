@@ -0,0 +1,176 @@
+#include "PaletteTuner.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "SyntheticGaugeSource.h"
+
+#include "Check.h"
+
+namespace {
+    constexpr int BAR_WIDTH = 400;
+    constexpr int BAR_HEIGHT = 8;
+    constexpr int FRAMES = 12;
+    constexpr int COLOR_SHIFT = 6; // How far the game's colours are from the configured ones
+
+    // The game's colours: the configured palette shifted a little, so only
+    // tolerances of at least COLOR_SHIFT read it
+    XpBarPalette MakeGamePalette() {
+        XpBarPalette palette;
+        PaletteColor* colors[] = { &palette.fill, &palette.marker, &palette.filledMarker, &palette.background };
+        for (PaletteColor* color : colors) {
+            color->red = static_cast<uint8_t>(color->red + COLOR_SHIFT);
+            color->green = static_cast<uint8_t>(color->green + COLOR_SHIFT);
+            color->blue = static_cast<uint8_t>(color->blue + COLOR_SHIFT);
+        }
+        return palette;
+    }
+
+    // Configured colours with no tolerance, which read nothing
+    XpBarPalette MakeStartPalette() {
+        XpBarPalette palette;
+        palette.fill.tolerance = 0;
+        palette.marker.tolerance = 0;
+        palette.filledMarker.tolerance = 0;
+        palette.background.tolerance = 0;
+        return palette;
+    }
+
+    // Synthetic frames as P6 files with a manifest beside them, removed
+    // with the corpus
+    class SyntheticCorpus {
+    public:
+        SyntheticCorpus() {
+            std::random_device random;
+            m_directory = std::filesystem::temp_directory_path() /
+                ("pOverlay-PaletteTunerTest-" + std::to_string(random()));
+            std::filesystem::create_directories(m_directory);
+
+            SyntheticGaugeSource source(MakeGamePalette());
+            source.Resize(BAR_WIDTH, BAR_HEIGHT);
+            std::ofstream manifest(m_directory / "manifest.txt");
+            manifest << "# Synthetic frames\n";
+            for (int i = 0; i < FRAMES; i++) {
+                const float percent = 3.0f + i * 8.0f;
+                source.Render(percent);
+                const std::string name = "frame-" + std::to_string(i) + ".ppm";
+                WritePpm(m_directory / name, source.GetFrame());
+                manifest << name << " " << percent << "\n";
+            }
+        }
+
+        ~SyntheticCorpus() {
+            std::error_code error;
+            std::filesystem::remove_all(m_directory, error);
+        }
+
+        TuningCorpus Load() const {
+            TuningCorpus corpus;
+            std::string error;
+            CHECK(corpus.Load((m_directory / "manifest.txt").string(), error));
+            CHECK(corpus.samples.size() == FRAMES);
+            return corpus;
+        }
+
+    private:
+        static void WritePpm(const std::filesystem::path& path, const FrameView& frame) {
+            std::ofstream out(path, std::ios::binary);
+            out << "P6\n" << frame.width << " " << frame.height << "\n255\n";
+            for (int y = 0; y < frame.height; y++) {
+                for (int x = 0; x < frame.width; x++) {
+                    const uint8_t* pixel = frame.PixelAt(x, y);
+                    const char rgb[3] = { static_cast<char>(pixel[2]), static_cast<char>(pixel[1]),
+                        static_cast<char>(pixel[0]) };
+                    out.write(rgb, 3);
+                }
+            }
+        }
+
+        std::filesystem::path m_directory;
+    };
+
+    PaletteTunerConfig MakeConfig() {
+        PaletteTunerConfig config;
+        config.palette = MakeStartPalette();
+        config.markerWidths = { config.layout.markerWidth };
+        config.toleranceStep = 4;
+        config.maxTolerance = 8;
+        config.threads = 2;
+        config.keep = 3;
+        return config;
+    }
+
+    void TestGridFindsTolerances() {
+        const SyntheticCorpus files;
+        const TuningCorpus corpus = files.Load();
+        const TuningReport report = PaletteTuner::Run(corpus, MakeConfig());
+        CHECK(report.succeeded);
+        CHECK(report.frames == FRAMES);
+        CHECK(report.candidates == 3 * 3 * 3 * 3 + 1);
+
+        // The configured palette reads nothing; the grid's best reads every
+        // frame, and needs the tolerance to cover the shift on each colour
+        CHECK(report.baseline.meanError > 10.0);
+        CHECK(report.best.size() == 3);
+        const TuningResult& best = report.best.front();
+        CHECK(best.meanError < 0.5);
+        CHECK(best.maxError < 1.0);
+        CHECK(best.palette.fill.tolerance >= COLOR_SHIFT);
+        CHECK(best.palette.background.tolerance >= COLOR_SHIFT);
+        CHECK(best.palette.fill.red == MakeStartPalette().fill.red);
+        CHECK(report.ToString().find("[Palette]\nFill=") != std::string::npos);
+    }
+
+    void TestRandomSearchIsRepeatable() {
+        const SyntheticCorpus files;
+        const TuningCorpus corpus = files.Load();
+        PaletteTunerConfig config = MakeConfig();
+        config.search = TuningSearch::Random;
+        config.candidates = 400;
+        config.colorJitter = 8;
+        config.maxTolerance = 12;
+        config.seed = 7;
+
+        // The candidates follow from the seed alone, not the thread count
+        const TuningReport first = PaletteTuner::Run(corpus, config);
+        config.threads = 1;
+        const TuningReport second = PaletteTuner::Run(corpus, config);
+        CHECK(first.succeeded && second.succeeded);
+        CHECK(first.candidates == 401);
+        CHECK(first.best.front().meanError == second.best.front().meanError);
+        CHECK(first.best.front().maxError == second.best.front().maxError);
+        CHECK(first.best.front().meanError < 0.5);
+        CHECK(first.best.front().meanError < first.baseline.meanError);
+    }
+
+    void TestNegativeLimitsCountAsZero() {
+        const SyntheticCorpus files;
+        const TuningCorpus corpus = files.Load();
+        PaletteTunerConfig config = MakeConfig();
+        config.maxTolerance = -5;
+        config.colorJitter = -3;
+
+        // The grid has only tolerance 0 to try
+        TuningReport report = PaletteTuner::Run(corpus, config);
+        CHECK(report.succeeded);
+        CHECK(report.candidates == 2);
+
+        // Random candidates keep the configured colours at tolerance 0
+        config.search = TuningSearch::Random;
+        config.candidates = 50;
+        report = PaletteTuner::Run(corpus, config);
+        CHECK(report.succeeded);
+        for (const TuningResult& result : report.best) {
+            CHECK(result.palette == config.palette);
+        }
+    }
+}
+
+int main() {
+    TestGridFindsTolerances();
+    TestRandomSearchIsRepeatable();
+    TestNegativeLimitsCountAsZero();
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include "RegionMapping.h"
+
+#include <cstdlib>
+#include <random>
+#include <utility>
+
+#include "Check.h"
+
+namespace {
+    // RECT-shaped, as the overlay passes on Windows
+    struct Rect {
+        int left;
+        int top;
+        int right;
+        int bottom;
+
+        bool operator==(const Rect&) const = default;
+    };
+
+    bool IsWithin(const Rect& a, const Rect& b, int pixels) {
+        return std::abs(a.left - b.left) <= pixels && std::abs(a.top - b.top) <= pixels &&
+            std::abs(a.right - b.right) <= pixels && std::abs(a.bottom - b.bottom) <= pixels;
+    }
+
+    void TestToScreenRoundTrip() {
+        std::mt19937 random(3);
+        std::uniform_int_distribution<int> coordinate(-4000, 4000);
+        for (int i = 0; i < 10000; i++) {
+            const Rect relative{ coordinate(random), coordinate(random), coordinate(random), coordinate(random) };
+            const int windowLeft = coordinate(random);
+            const int windowTop = coordinate(random);
+
+            const Rect screen = RegionMapping::ToScreen(relative, windowLeft, windowTop);
+            CHECK(screen.right - screen.left == relative.right - relative.left);
+            CHECK(screen.bottom - screen.top == relative.bottom - relative.top);
+            CHECK(RegionMapping::Offset(screen, -windowLeft, -windowTop) == relative);
+        }
+    }
+
+    void TestRescaleSameSize() {
+        const Rect region{ 10, 700, 1270, 712 };
+        CHECK(RegionMapping::Rescale(region, 1280, 720, 1280, 720) == region);
+
+        // An unknown reference size leaves the region alone
+        CHECK(RegionMapping::Rescale(region, 0, 0, 1920, 1080) == region);
+    }
+
+    void TestRescaleRoundTrip() {
+        // Growing by a whole factor and back is exact
+        const Rect region{ 10, 700, 1270, 712 };
+        const Rect doubled = RegionMapping::Rescale(region, 1280, 720, 2560, 1440);
+        CHECK((doubled == Rect{ 20, 1400, 2540, 1424 }));
+        CHECK(RegionMapping::Rescale(doubled, 2560, 1440, 1280, 720) == region);
+
+        // Any other round trip lands within a pixel, however often the
+        // window is resized
+        std::mt19937 random(5);
+        std::uniform_int_distribution<int> size(640, 3840);
+        for (int i = 0; i < 10000; i++) {
+            const int width = size(random);
+            const int height = size(random) * 9 / 16;
+            std::uniform_int_distribution<int> x(0, width - 1);
+            std::uniform_int_distribution<int> y(0, height - 1);
+            int left = x(random);
+            int right = x(random);
+            int top = y(random);
+            int bottom = y(random);
+            if (right < left) std::swap(left, right);
+            if (bottom < top) std::swap(top, bottom);
+            const Rect relative{ left, top, right + 1, bottom + 1 };
+
+            const int otherWidth = size(random);
+            const int otherHeight = size(random) * 9 / 16;
+            const Rect resized = RegionMapping::Rescale(relative, width, height, otherWidth, otherHeight);
+            CHECK(resized.right > resized.left && resized.bottom > resized.top);
+
+            const Rect back = RegionMapping::Rescale(resized, otherWidth, otherHeight, width, height);
+            const int pixels = 1 + (width + otherWidth - 1) / otherWidth + (height + otherHeight - 1) / otherHeight;
+            CHECK(IsWithin(back, relative, pixels));
+        }
+    }
+
+    void TestRescaleKeepsThinRegions() {
+        // A one pixel high bar shrunk to a quarter stays one pixel high
+        const Rect region{ 100, 700, 1100, 701 };
+        const Rect shrunk = RegionMapping::Rescale(region, 1920, 1080, 480, 270);
+        CHECK(shrunk.bottom - shrunk.top == 1);
+        CHECK(shrunk.right - shrunk.left == 250);
+
+        // An empty region stays empty
+        const Rect empty{ 100, 700, 100, 700 };
+        const Rect scaled = RegionMapping::Rescale(empty, 1920, 1080, 480, 270);
+        CHECK(scaled.right == scaled.left && scaled.bottom == scaled.top);
+    }
+}
+
+int main() {
+    TestToScreenRoundTrip();
+    TestRescaleSameSize();
+    TestRescaleRoundTrip();
+    TestRescaleKeepsThinRegions();
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "SamplePyramid.h"
+
+#include <random>
+#include <vector>
+
+#include "Check.h"
+
+namespace {
+    using Pyramid = SamplePyramid<16, 6>;
+
+    // Summary of samples [first, first + count) computed directly
+    Pyramid::Bucket Summarize(const std::vector<float>& samples, size_t first, size_t count) {
+        Pyramid::Bucket bucket;
+        bucket.minimum = samples[first];
+        bucket.maximum = samples[first];
+        for (size_t i = first; i < first + count; i++) {
+            if (samples[i] < bucket.minimum) bucket.minimum = samples[i];
+            if (samples[i] > bucket.maximum) bucket.maximum = samples[i];
+            bucket.sum += samples[i];
+            bucket.count++;
+        }
+        return bucket;
+    }
+
+    // Every held bucket on every level against a brute-force summary of the
+    // samples it covers
+    void CheckAgainstSamples(const Pyramid& pyramid, const std::vector<float>& samples) {
+        CHECK(pyramid.GetSampleCount() == samples.size());
+        for (size_t level = 0; level < Pyramid::LEVELS; level++) {
+            const size_t span = size_t(1) << level;
+            const uint64_t total = samples.size() / span;
+            CHECK(pyramid.GetBucketTotal(level) == total);
+
+            const size_t held = pyramid.GetBucketCount(level);
+            CHECK(held == (total < Pyramid::CAPACITY ? total : Pyramid::CAPACITY));
+            for (size_t index = 0; index < held; index++) {
+                const size_t first = static_cast<size_t>(total - held + index) * span;
+                const Pyramid::Bucket expected = Summarize(samples, first, span);
+                const Pyramid::Bucket& bucket = pyramid.GetBucket(level, index);
+                CHECK(bucket.count == expected.count);
+                CHECK(bucket.minimum == expected.minimum);
+                CHECK(bucket.maximum == expected.maximum);
+                CHECK(bucket.sum == expected.sum); // Quarter steps add up exactly
+            }
+        }
+    }
+
+    void TestMatchesBruteForce() {
+        std::mt19937 random(17);
+        std::uniform_int_distribution<int> quarter(0, 400);
+
+        Pyramid pyramid;
+        std::vector<float> samples;
+        for (int i = 0; i < 5000; i++) {
+            const float value = quarter(random) / 4.0f;
+            pyramid.Add(value);
+            samples.push_back(value);
+
+            // Every step while the levels fill, then now and then once the
+            // rings have wrapped
+            if (i < 1200 || i % 97 == 0) {
+                CheckAgainstSamples(pyramid, samples);
+            }
+        }
+        CheckAgainstSamples(pyramid, samples);
+
+        pyramid.Clear();
+        samples.clear();
+        CheckAgainstSamples(pyramid, samples);
+        pyramid.Add(1.0f);
+        samples.push_back(1.0f);
+        CheckAgainstSamples(pyramid, samples);
+    }
+
+    void TestSelectLevel() {
+        const Pyramid pyramid;
+        for (uint64_t samples = 0; samples < 4000; samples += 7) {
+            for (size_t points = 0; points < 40; points++) {
+                size_t expected = Pyramid::LEVELS - 1;
+                if (points > 0) {
+                    const size_t limit = points < Pyramid::CAPACITY ? points : Pyramid::CAPACITY;
+                    for (size_t level = 0; level < Pyramid::LEVELS; level++) {
+                        const uint64_t span = uint64_t(1) << level;
+                        if ((samples + span - 1) / span <= limit) {
+                            expected = level;
+                            break;
+                        }
+                    }
+                }
+                CHECK(pyramid.SelectLevel(samples, points) == expected);
+            }
+        }
+    }
+}
+
+int main() {
+    TestMatchesBruteForce();
+    TestSelectLevel();
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "SharedSampleChannel.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#endif
+
+#include "Check.h"
+
+namespace {
+    // Per-process names, so parallel runs do not share segments
+    std::string MakeChannelName(const char* suffix) {
+#ifdef _WIN32
+        const unsigned long process = GetCurrentProcessId();
+#else
+        const unsigned long process = static_cast<unsigned long>(getpid());
+#endif
+        return "pOverlay.Test." + std::to_string(process) + "." + suffix;
+    }
+
+    // Every field derives from the sequence, so a torn read shows as a mismatch
+    XpSample MakeSample(uint64_t sequence) {
+        XpSample sample;
+        sample.sequence = sequence;
+        sample.timestampUs = static_cast<int64_t>(sequence * 3);
+        sample.percent = static_cast<float>(sequence % 10000) / 100.0f;
+        sample.filledPixels = static_cast<uint32_t>(sequence * 7);
+        sample.totalPixels = static_cast<uint32_t>(sequence * 11);
+        sample.flags = static_cast<uint32_t>(sequence & XpSample::FLAG_LEVEL_WRAPPED);
+        sample.currentXp = static_cast<uint32_t>(sequence * 13);
+        sample.maximumXp = static_cast<uint32_t>(sequence * 17);
+        return sample;
+    }
+
+    bool IsConsistent(const XpSample& sample) {
+        const XpSample expected = MakeSample(sample.sequence);
+        return sample.timestampUs == expected.timestampUs && sample.percent == expected.percent &&
+            sample.filledPixels == expected.filledPixels && sample.totalPixels == expected.totalPixels &&
+            sample.flags == expected.flags && sample.currentXp == expected.currentXp &&
+            sample.maximumXp == expected.maximumXp;
+    }
+
+    void TestNothingPublished() {
+        const std::string name = MakeChannelName("empty");
+        SharedSampleReader reader;
+        CHECK(!reader.Open(name.c_str())); // No writer yet
+
+        SharedSampleWriter writer;
+        CHECK(writer.Open(name.c_str()));
+        CHECK(reader.Open(name.c_str()));
+
+        // sequence == 0 until the first Publish
+        XpSample sample;
+        CHECK(!reader.Read(sample));
+        CHECK(!reader.ReadNewer(0, sample));
+    }
+
+    void TestRoundTrip() {
+        const std::string name = MakeChannelName("round-trip");
+        SharedSampleWriter writer;
+        CHECK(writer.Open(name.c_str()));
+        SharedSampleReader reader;
+        CHECK(reader.Open(name.c_str()));
+
+        writer.Publish(MakeSample(1));
+        XpSample sample;
+        CHECK(reader.Read(sample));
+        CHECK(sample.sequence == 1 && IsConsistent(sample));
+        CHECK(sample.IsLevelWrapped());
+
+        // ReadNewer only reports samples past the one already seen
+        CHECK(!reader.ReadNewer(1, sample));
+        writer.Publish(MakeSample(2));
+        CHECK(reader.ReadNewer(1, sample));
+        CHECK(sample.sequence == 2 && IsConsistent(sample));
+    }
+
+    void TestUninitializedSegment() {
+        // A segment whose magic was never written is not read
+        const std::string name = MakeChannelName("uninitialized");
+        SharedSampleChannel::Mapping mapping;
+        CHECK(mapping.Create(name.c_str()));
+        SharedSampleReader reader;
+        CHECK(reader.Open(name.c_str()));
+
+        XpSample sample;
+        CHECK(!reader.Read(sample));
+    }
+
+    void TestConcurrentWriter() {
+        const std::string name = MakeChannelName("stress");
+        SharedSampleWriter writer;
+        CHECK(writer.Open(name.c_str()));
+        SharedSampleReader reader;
+        CHECK(reader.Open(name.c_str()));
+
+        constexpr uint64_t SAMPLES = 1000000;
+        std::atomic<bool> done{ false };
+        std::thread publisher([&]() {
+            for (uint64_t sequence = 1; sequence <= SAMPLES; sequence++) {
+                writer.Publish(MakeSample(sequence));
+                if (sequence % 256 == 0) std::this_thread::yield();
+            }
+            done.store(true, std::memory_order_release);
+        });
+
+        uint64_t reads = 0;
+        uint64_t torn = 0;
+        uint64_t lastSequence = 0;
+        bool ordered = true;
+        while (!done.load(std::memory_order_acquire)) {
+            XpSample sample;
+            if (!reader.Read(sample)) continue;
+            reads++;
+            if (!IsConsistent(sample)) torn++;
+            if (sample.sequence < lastSequence) ordered = false;
+            lastSequence = sample.sequence;
+        }
+        publisher.join();
+
+        CHECK(torn == 0);
+        CHECK(ordered);
+        XpSample last;
+        CHECK(reader.Read(last));
+        CHECK(last.sequence == SAMPLES && IsConsistent(last));
+        std::printf("stress: %llu reads, none torn\n", static_cast<unsigned long long>(reads));
+    }
+
+    void TestCreatorUnlinksOnClose() {
+        const std::string name = MakeChannelName("unlink");
+        SharedSampleWriter writer;
+        CHECK(writer.Open(name.c_str()));
+        writer.Publish(MakeSample(5));
+
+        SharedSampleReader reader;
+        CHECK(reader.Open(name.c_str()));
+        writer.Close();
+        CHECK(!writer.IsOpen());
+
+        // A mapped reader keeps its view
+        XpSample sample;
+        CHECK(reader.Read(sample));
+        CHECK(sample.sequence == 5);
+
+#ifndef _WIN32
+        // New readers no longer find the name; Windows keeps it while any handle is open
+        SharedSampleReader late;
+        CHECK(!late.Open(name.c_str()));
+        const std::string segment = SharedSampleChannel::GetSegmentName(name.c_str());
+        CHECK(shm_open(segment.c_str(), O_RDONLY, 0) < 0 && errno == ENOENT);
+#endif
+
+        // Closing a reader never removes the name
+        CHECK(writer.Open(name.c_str()));
+        SharedSampleReader first;
+        CHECK(first.Open(name.c_str()));
+        first.Close();
+        SharedSampleReader second;
+        CHECK(second.Open(name.c_str()));
+    }
+}
+
+int main() {
+    TestNothingPublished();
+    TestRoundTrip();
+    TestUninitializedSegment();
+    TestConcurrentWriter();
+    TestCreatorUnlinksOnClose();
+    return 0;
+}
@@ -0,0 +1,255 @@
+#include "SignalConditioner.h"
+
+#include <cmath>
+#include <random>
+
+#include "GaugePipeline.h"
+#include "SyntheticGaugeSource.h"
+
+#include "Check.h"
+
+namespace {
+    // Readings in the shape the analyzer reports at 4 fps. Anti-aliased
+    // edges and the glow animation make it flicker between adjacent values
+    // while XP stands still.
+    constexpr float FLICKER[] = {
+        37.41f, 37.44f, 37.41f, 37.43f, 37.44f, 37.41f, 37.41f, 37.44f, 37.42f, 37.44f,
+        37.41f, 37.44f, 37.44f, 37.41f, 37.43f, 37.41f, 37.44f, 37.41f, 37.44f, 37.42f,
+    };
+
+    // A tooltip passing over the bar for one frame
+    constexpr float OCCLUSION[] = {
+        52.10f, 52.10f, 52.13f, 52.13f, 3.20f, 52.13f, 52.16f, 52.16f, 52.19f, 52.19f,
+    };
+
+    // A level-up from a mob kill
+    constexpr float LEVEL_UP[] = {
+        99.10f, 99.13f, 99.10f, 99.16f, 0.41f, 0.44f, 0.41f, 0.47f, 0.47f, 0.50f,
+    };
+
+    struct Totals {
+        int emits = 0;
+        int wraps = 0;
+        bool wentBackwards = false;
+        float last = 0.0f;
+    };
+
+    template <size_t Count>
+    Totals Run(SignalConditioner& conditioner, const float (&sequence)[Count]) {
+        Totals totals;
+        bool hasLast = false;
+        for (float raw : sequence) {
+            const SignalConditioner::Output output = conditioner.Process(raw);
+            if (output.emit) totals.emits++;
+            if (output.levelWrapped) totals.wraps++;
+            if (hasLast && output.value < totals.last && !output.levelWrapped) totals.wentBackwards = true;
+            totals.last = output.value;
+            hasLast = true;
+        }
+        return totals;
+    }
+
+    void TestFlickerSuppressed() {
+        SignalConditioner conditioner;
+        const Totals totals = Run(conditioner, FLICKER);
+        CHECK(totals.emits == 1); // The first value only
+        CHECK(totals.wraps == 0);
+        CHECK(!totals.wentBackwards);
+        CHECK(totals.last >= 37.41f && totals.last <= 37.44f);
+    }
+
+    void TestSingleFrameOcclusionDropped() {
+        SignalConditioner conditioner;
+        const Totals totals = Run(conditioner, OCCLUSION);
+        CHECK(totals.wraps == 0);
+        CHECK(!totals.wentBackwards);
+        CHECK(std::fabs(totals.last - 52.19f) < 0.05f);
+    }
+
+    void TestLevelWrapConfirmed() {
+        SignalConditioner conditioner;
+        const Totals totals = Run(conditioner, LEVEL_UP);
+        CHECK(totals.wraps == 1);
+        CHECK(std::fabs(totals.last - 0.47f) < 0.05f);
+    }
+
+    void TestSmallLevelWrapConfirmed() {
+        // A quest turn-in levels up from 40% to 5%, a drop well below
+        // levelWrapDrop; it must not stay pinned at 40% for most of a level
+        SignalConditionerConfig config;
+        SignalConditioner conditioner(config);
+        for (int i = 0; i < 10; i++) {
+            conditioner.Process(40.0f);
+        }
+
+        const int drop = 35;
+        const int expectedFrames = config.levelWrapConfirmFrames + static_cast<int>(std::ceil(
+            (config.levelWrapMaxConfirmFrames - config.levelWrapConfirmFrames) * (1.0f - drop / config.levelWrapDrop)));
+        int frames = 0;
+        SignalConditioner::Output output;
+        do {
+            output = conditioner.Process(5.0f);
+            frames++;
+            if (!output.levelWrapped) {
+                CHECK(output.wrapPending);
+                CHECK(output.value == 40.0f);
+            }
+        } while (!output.levelWrapped && frames < 100);
+
+        CHECK(output.levelWrapped);
+        CHECK(frames == expectedFrames);
+        CHECK(output.value == 5.0f && output.emit);
+
+        // The new level then climbs normally
+        output = conditioner.Process(5.2f);
+        CHECK(!output.levelWrapped && !output.wrapPending);
+        CHECK(output.value >= 5.0f);
+    }
+
+    void TestShortDipIsNotAWrap() {
+        // Partial occlusion for a second: four frames, fewer than a drop of
+        // this size needs before it counts as a level-up
+        SignalConditioner conditioner;
+        for (int i = 0; i < 10; i++) {
+            conditioner.Process(37.0f);
+        }
+        for (int i = 0; i < 4; i++) {
+            const SignalConditioner::Output output = conditioner.Process(20.0f);
+            CHECK(!output.levelWrapped);
+            CHECK(output.value == 37.0f);
+        }
+        const SignalConditioner::Output output = conditioner.Process(37.1f);
+        CHECK(!output.levelWrapped && !output.wrapPending);
+        CHECK(output.value >= 37.0f);
+    }
+
+    void TestPartialOcclusionHeld() {
+        // The map over part of a 400 pixel bar for 15 seconds: the reading
+        // falls from 60% to 43% but counts fewer bar pixels
+        SignalConditioner conditioner;
+        for (int i = 0; i < 10; i++) {
+            conditioner.Process(60.0f, 400);
+        }
+        for (int i = 0; i < 60; i++) {
+            const SignalConditioner::Output output = conditioner.Process(43.0f, 300);
+            CHECK(!output.levelWrapped && !output.wrapPending && !output.emit);
+            CHECK(output.value == 60.0f);
+        }
+
+        // Covered entirely, which reads as an empty bar
+        for (int i = 0; i < 60; i++) {
+            const SignalConditioner::Output output = conditioner.Process(0.0f, 0);
+            CHECK(!output.levelWrapped && !output.emit);
+            CHECK(output.value == 60.0f);
+        }
+
+        // Uncovered, XP goes on from where it was
+        SignalConditioner::Output output;
+        bool emitted = false;
+        for (int i = 0; i < 5; i++) {
+            output = conditioner.Process(60.5f, 400);
+            CHECK(!output.levelWrapped);
+            emitted = emitted || output.emit;
+        }
+        CHECK(output.value == 60.5f && emitted);
+
+        // A level-up on the intact bar is still recognised
+        for (int i = 0; i < 40 && !output.levelWrapped; i++) {
+            output = conditioner.Process(2.0f, 400);
+        }
+        CHECK(output.levelWrapped && output.value == 2.0f);
+    }
+
+    void TestPixelRegressionHeld() {
+        // One pixel of a 400 pixel bar reads unfilled for a minute, e.g. a
+        // glow frame stuck at the fill edge; and a steady 0.1 point dip
+        SignalConditioner conditioner;
+        for (int i = 0; i < 10; i++) {
+            conditioner.Process(60.0f, 400);
+        }
+        for (int i = 0; i < 240; i++) {
+            const SignalConditioner::Output output = conditioner.Process(59.75f, 400);
+            CHECK(!output.levelWrapped && !output.wrapPending && !output.emit);
+            CHECK(output.value == 60.0f);
+        }
+        for (int i = 0; i < 44; i++) {
+            const SignalConditioner::Output output = conditioner.Process(59.9f, 399);
+            CHECK(!output.levelWrapped && !output.emit);
+            CHECK(output.value == 60.0f);
+        }
+    }
+
+    void TestUpdateCountReduced() {
+        // Ten minutes at 4 fps: XP creeping up with flicker, bursts of kills,
+        // the odd occluded frame and a level-up
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> noise(-0.03f, 0.03f);
+        std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+
+        SignalConditioner conditioner;
+        float value = 80.0f;
+        float lastRaw = -1.0f;
+        int rawChanges = 0;
+        int emits = 0;
+        int wraps = 0;
+        for (int frame = 0; frame < 2400; frame++) {
+            value += chance(random) < 0.02f ? 1.5f : 0.002f;
+            if (value >= 100.0f) value -= 100.0f;
+
+            float raw = std::round((value + noise(random)) * 100.0f) / 100.0f;
+            if (frame % 211 == 100) raw = 0.0f;
+
+            if (raw != lastRaw) rawChanges++;
+            lastRaw = raw;
+
+            const SignalConditioner::Output output = conditioner.Process(raw);
+            if (output.emit) emits++;
+            if (output.levelWrapped) wraps++;
+        }
+
+        std::printf("updates: %d raw changes, %d emitted, %d wraps\n", rawChanges, emits, wraps);
+        CHECK(wraps == 1);
+        CHECK(emits * 10 <= rawChanges);
+    }
+
+    void TestRecorderWaitsForSmallWrap() {
+        // The recorder sees the raw drop at once, but must not freeze on a
+        // level-up the conditioner is still confirming
+        SyntheticGaugeSource source;
+        source.Resize(400, 12);
+        GaugePipeline pipeline;
+
+        bool frozen = false;
+        bool wrapped = false;
+        for (int frame = 0; frame < 60 && !frozen; frame++) {
+            source.Render(frame < 10 ? 40.0f : 5.0f);
+            const GaugePipeline::Result result = pipeline.Process(source.GetFrame());
+            frozen = result.recorderFrozen;
+            wrapped = wrapped || result.conditioned.levelWrapped;
+        }
+        CHECK(wrapped);
+        CHECK(!frozen);
+
+        // A dip that clears before it is confirmed is still a misread
+        GaugePipeline dipping;
+        for (int frame = 0; frame < 40 && !frozen; frame++) {
+            source.Render(frame >= 10 && frame < 14 ? 20.0f : 40.0f);
+            frozen = dipping.Process(source.GetFrame()).recorderFrozen;
+        }
+        CHECK(frozen);
+        CHECK(dipping.GetRecorder().GetFreezeReason() == FlightFreezeReason::Decrease);
+    }
+}
+
+int main() {
+    TestFlickerSuppressed();
+    TestSingleFrameOcclusionDropped();
+    TestLevelWrapConfirmed();
+    TestSmallLevelWrapConfirmed();
+    TestShortDipIsNotAWrap();
+    TestPartialOcclusionHeld();
+    TestPixelRegressionHeld();
+    TestUpdateCountReduced();
+    TestRecorderWaitsForSmallWrap();
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Command line front end for SoakHarness, for soaking the capture path on
+// a machine without the game or a display. Built with allocation counting,
+// so the run also fails on heap traffic after warm-up; the overlay's
+// --soak runs the same harness against GDI bitmaps on Windows.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "SoakHarness.h"
+
+namespace {
+    void PrintUsage() {
+        std::fputs(
+            "usage: pOverlay-soak [options]\n"
+            "  --clients=N          simulated game windows\n"
+            "  --hours=H            simulated capture time\n"
+            "  --minutes=M          simulated capture time, instead of --hours\n"
+            "  --checkpoints=N      resource samples over the run\n"
+            "  --warmup=N           checkpoints ignored by the growth checks\n"
+            "  --run-period-us=N    real time per simulated frame\n"
+            "  --seed=N             seed for values and regions\n"
+            "  --channel=NAME       publish samples under NAME.<client>, empty for none\n"
+            "  --out=FILE           also write the report to FILE\n",
+            stderr);
+    }
+
+    // Value of "--name=value", or nullptr if argument is not that option
+    const char* GetOption(const char* argument, const char* name) {
+        const size_t length = std::strlen(name);
+        if (std::strncmp(argument, name, length) != 0 || argument[length] != '=') return nullptr;
+        return argument + length + 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string outPath;
+    SoakConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        const char* argument = argv[i];
+        const char* value = nullptr;
+        if ((value = GetOption(argument, "--clients"))) {
+            config.clients = std::atoi(value);
+        }
+        else if ((value = GetOption(argument, "--hours"))) {
+            config.simulatedDuration = std::chrono::seconds(static_cast<long long>(std::atof(value) * 3600.0));
+        }
+        else if ((value = GetOption(argument, "--minutes"))) {
+            config.simulatedDuration = std::chrono::seconds(static_cast<long long>(std::atof(value) * 60.0));
+        }
+        else if ((value = GetOption(argument, "--checkpoints"))) {
+            config.checkpoints = std::atoi(value);
+        }
+        else if ((value = GetOption(argument, "--warmup"))) {
+            config.warmupCheckpoints = std::atoi(value);
+        }
+        else if ((value = GetOption(argument, "--run-period-us"))) {
+            config.runPeriod = std::chrono::microseconds(std::atoll(value));
+        }
+        else if ((value = GetOption(argument, "--seed"))) {
+            config.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        }
+        else if ((value = GetOption(argument, "--channel"))) {
+            config.channelPrefix = value;
+        }
+        else if ((value = GetOption(argument, "--out"))) {
+            outPath = value;
+        }
+        else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    const SoakReport report = SoakHarness::Run(config);
+    const std::string text = report.ToString();
+    std::fputs(text.c_str(), stdout);
+
+    if (!outPath.empty()) {
+        FILE* file = std::fopen(outPath.c_str(), "w");
+        if (!file) {
+            std::fprintf(stderr, "Could not write %s\n", outPath.c_str());
+            return 1;
+        }
+        std::fputs(text.c_str(), file);
+        std::fclose(file);
+    }
+    return report.passed ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+// Command line front end for PaletteTuner, for running a search on a
+// machine without the overlay. Starts from the built-in palette and XP bar
+// layout; the overlay's --tune starts from config.ini instead.
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "PaletteTuner.h"
+
+namespace {
+    void PrintUsage() {
+        std::fputs(
+            "usage: pOverlay-tune <manifest> [options]\n"
+            "  --random             random search around the palette instead of the grid\n"
+            "  --candidates=N       random search: candidates to evaluate\n"
+            "  --seed=N             random search: seed\n"
+            "  --step=N             grid: tolerance spacing\n"
+            "  --max-tolerance=N    largest tolerance tried\n"
+            "  --threads=N          workers, 0 for every core\n"
+            "  --vertical           the gauge is vertical\n"
+            "  --reverse            the gauge fills right to left or bottom up\n"
+            "  --out=FILE           also write the report to FILE\n",
+            stderr);
+    }
+
+    // Value of "--name=value", or nullptr if argument is not that option
+    const char* GetOption(const char* argument, const char* name) {
+        const size_t length = std::strlen(name);
+        if (std::strncmp(argument, name, length) != 0 || argument[length] != '=') return nullptr;
+        return argument + length + 1;
+    }
+
+    // Whole number option value; false if it is negative or not a number
+    bool ParseCount(const char* value, int& count) {
+        char* end = nullptr;
+        const long parsed = std::strtol(value, &end, 10);
+        if (end == value || *end != '\0' || parsed < 0 || parsed > INT_MAX) return false;
+        count = static_cast<int>(parsed);
+        return true;
+    }
+
+    // Exit code for an option ParseCount refused
+    int RejectCount(const char* argument) {
+        std::fprintf(stderr, "%s: expected a whole number of 0 or more\n", argument);
+        return 2;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string manifest;
+    std::string outPath;
+    PaletteTunerConfig config;
+    int threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* argument = argv[i];
+        const char* value = nullptr;
+        if (std::strcmp(argument, "--random") == 0) {
+            config.search = TuningSearch::Random;
+        }
+        else if (std::strcmp(argument, "--vertical") == 0) {
+            config.layout.orientation = GaugeOrientation::Vertical;
+        }
+        else if (std::strcmp(argument, "--reverse") == 0) {
+            config.layout.direction = FillDirection::Reverse;
+        }
+        else if ((value = GetOption(argument, "--candidates"))) {
+            if (!ParseCount(value, config.candidates)) return RejectCount(argument);
+        }
+        else if ((value = GetOption(argument, "--seed"))) {
+            config.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        }
+        else if ((value = GetOption(argument, "--step"))) {
+            if (!ParseCount(value, config.toleranceStep)) return RejectCount(argument);
+        }
+        else if ((value = GetOption(argument, "--max-tolerance"))) {
+            if (!ParseCount(value, config.maxTolerance)) return RejectCount(argument);
+        }
+        else if ((value = GetOption(argument, "--threads"))) {
+            if (!ParseCount(value, threads)) return RejectCount(argument);
+            config.threads = static_cast<size_t>(threads);
+        }
+        else if ((value = GetOption(argument, "--out"))) {
+            outPath = value;
+        }
+        else if (argument[0] != '-' && manifest.empty()) {
+            manifest = argument;
+        }
+        else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (manifest.empty()) {
+        PrintUsage();
+        return 2;
+    }
+
+    TuningCorpus corpus;
+    std::string error;
+    if (!corpus.Load(manifest, error)) {
+        std::fprintf(stderr, "Could not read the tuning corpus: %s\n", error.c_str());
+        return 1;
+    }
+
+    const TuningReport report = PaletteTuner::Run(corpus, config);
+    const std::string text = report.ToString();
+    std::fputs(text.c_str(), stdout);
+
+    if (!outPath.empty()) {
+        FILE* file = std::fopen(outPath.c_str(), "w");
+        if (!file) {
+            std::fprintf(stderr, "Could not write %s\n", outPath.c_str());
+            return 1;
+        }
+        std::fputs(text.c_str(), file);
+        std::fclose(file);
+    }
+    return report.succeeded ? 0 : 1;
+}